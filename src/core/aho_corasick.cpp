@@ -0,0 +1,151 @@
+#include "aho_corasick.hpp"
+
+#include <cstring>
+
+namespace core
+{
+
+constexpr static uint32_t NONE = UINT32_MAX;
+
+constexpr static uint8_t foldCase(uint8_t c, bool caseInsensitive)
+{
+    return caseInsensitive and c >= 'A' and c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+AhoCorasick::AhoCorasick(std::span<const std::string> patterns, bool caseInsensitive)
+    : mClassCount(1)
+{
+    // Class 0 is for all bytes which don't occur in patterns
+    mClasses.fill(0);
+
+    for (const auto& pattern : patterns)
+    {
+        for (const auto c : pattern)
+        {
+            const auto folded = foldCase(static_cast<uint8_t>(c), caseInsensitive);
+
+            if (mClasses[folded] == 0)
+            {
+                mClasses[folded] = mClassCount++;
+            }
+        }
+    }
+
+    if (caseInsensitive)
+    {
+        for (uint8_t c = 'A'; c <= 'Z'; ++c)
+        {
+            mClasses[c] = mClasses[foldCase(c, true)];
+        }
+    }
+
+    // Trie, with NONE for missing edges
+    std::vector<uint32_t> next(mClassCount, NONE);
+    std::vector<bool> output(1, false);
+
+    for (const auto& pattern : patterns)
+    {
+        if (pattern.empty())
+        {
+            continue;
+        }
+
+        uint32_t state = 0;
+
+        for (const auto c : pattern)
+        {
+            const auto cls = mClasses[static_cast<uint8_t>(c)];
+            auto& edge = next[state * mClassCount + cls];
+
+            if (edge == NONE)
+            {
+                edge = output.size();
+                output.push_back(false);
+                next.resize(next.size() + mClassCount, NONE);
+            }
+
+            state = next[state * mClassCount + cls];
+        }
+
+        output[state] = true;
+    }
+
+    // Breadth-first, so that failure links of shorter prefixes are known;
+    // missing edges become transitions of the failure state
+    std::vector<uint32_t> fail(output.size(), 0);
+    std::vector<uint32_t> queue;
+    queue.reserve(output.size());
+
+    for (size_t cls = 0; cls < mClassCount; ++cls)
+    {
+        auto& edge = next[cls];
+
+        if (edge == NONE)
+        {
+            edge = 0;
+        }
+        else
+        {
+            queue.push_back(edge);
+        }
+    }
+
+    for (size_t i = 0; i < queue.size(); ++i)
+    {
+        const auto state = queue[i];
+
+        output[state] = output[state] or output[fail[state]];
+
+        for (size_t cls = 0; cls < mClassCount; ++cls)
+        {
+            auto& edge = next[state * mClassCount + cls];
+            const auto failEdge = next[fail[state] * mClassCount + cls];
+
+            if (edge == NONE)
+            {
+                edge = failEdge;
+            }
+            else
+            {
+                fail[edge] = failEdge;
+                queue.push_back(edge);
+            }
+        }
+    }
+
+    mTable.resize(next.size());
+
+    for (size_t i = 0; i < next.size(); ++i)
+    {
+        mTable[i] = next[i] * mClassCount | (output[next[i]] ? MATCH : 0);
+    }
+}
+
+size_t AhoCorasick::find(std::string_view text, size_t pos) const
+{
+    const auto table = mTable.data();
+    const auto classes = mClasses.data();
+    const auto data = reinterpret_cast<const uint8_t*>(text.data());
+    uint32_t row = 0;
+
+    // Search stops at the first matching state, so row never has MATCH set
+    // when it's used as an offset
+    for (size_t i = pos; i < text.size(); ++i)
+    {
+        row = table[row + classes[data[i]]];
+
+        if (row & MATCH) [[unlikely]]
+        {
+            return i;
+        }
+    }
+
+    return npos;
+}
+
+size_t AhoCorasick::memoryUsage() const
+{
+    return mTable.capacity() * sizeof(uint32_t);
+}
+
+}  // namespace core
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core
+{
+
+// Aho-Corasick automaton finding any of many fixed strings in a single pass
+// over text, so that its speed doesn't depend on the number of strings.
+// It's built as a DFA: every state has a transition for every byte class,
+// where bytes not occurring in any pattern share a single class, so matching
+// is one table lookup per byte. Case insensitive matching folds ASCII
+// letters only, like LiteralSearch
+struct AhoCorasick final
+{
+    constexpr static size_t npos = std::string_view::npos;
+
+    // Empty patterns are ignored
+    AhoCorasick(std::span<const std::string> patterns, bool caseInsensitive);
+
+    // Offset of the last byte of the occurrence of any pattern in text
+    // following pos which ends first, or npos
+    size_t find(std::string_view text, size_t pos = 0) const;
+
+    bool contains(std::string_view text) const
+    {
+        return find(text) != npos;
+    }
+
+    constexpr size_t stateCount() const
+    {
+        return mClassCount ? mTable.size() / mClassCount : 0;
+    }
+
+    size_t memoryUsage() const;
+
+private:
+    // Transitions are kept as offsets of rows of destination states, with
+    // MATCH set if the state ends some pattern; offsets have to be below
+    // MATCH, which takes patterns of a few MiB in total
+    constexpr static uint32_t MATCH = 1u << 31;
+
+    std::array<uint16_t, 256> mClasses;
+    size_t                    mClassCount;
+    std::vector<uint32_t>     mTable;
+};
+
+}  // namespace core
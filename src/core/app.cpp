@@ -6,11 +6,14 @@
 #include "core/argparse.hpp"
 #include "core/commands/open.hpp"
 #include "core/commands/source.hpp"
+#include "core/config.hpp"
 #include "core/context.hpp"
 #include "core/fwd.hpp"
 #include "core/input.hpp"
 #include "core/logger.hpp"
 #include "core/main_loop.hpp"
+#include "core/message_line.hpp"
+#include "core/spool.hpp"
 #include "sys/system.hpp"
 #include "utils/time.hpp"
 
@@ -22,7 +25,7 @@ static const CommandLineOption file(
         .type = Type::string,
         .variant = Option::positional,
         .longName = "file",
-        .help = "file to open",
+        .help = "file to open; standard input is read if it's not given and input is not a terminal",
     });
 
 static const CommandLineOption logFile(
@@ -44,6 +47,22 @@ int run(int argc, char* const* argv, Context& context)
         return -1;
     }
 
+    // Piped input has to be taken over before the UI starts reading keys
+    sys::FileDescriptor input = -1;
+
+    if (not file)
+    {
+        if (auto result = sys::stdinDetach(); not result) [[unlikely]]
+        {
+            fprintf(stderr, "cannot read standard input: %s\n", sys::errorDescribe(result.error()));
+            return -1;
+        }
+        else
+        {
+            input = *result;
+        }
+    }
+
     if (logFile)
     {
         logger.setLogFile(logFile->string);
@@ -58,10 +77,23 @@ int run(int argc, char* const* argv, Context& context)
         logger.info() << "sourced " << configFile << "; took: " << 1000 * t.elapsed() << " ms";
     }
 
+    Spool spool;
+
     if (file)
     {
         commands::open(std::string(file->string), context);
     }
+    else if (input != -1)
+    {
+        if (auto result = spool.start(input); result) [[likely]]
+        {
+            commands::open(spool.path(), context, true);
+        }
+        else
+        {
+            context.messageLine.error() << result.error();
+        }
+    }
 
     context.mainLoop->run(context);
 
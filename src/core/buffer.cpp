@@ -4,20 +4,34 @@
 #include <algorithm>
 #include <cstring>
 #include <expected>
+#include <limits>
+#include <mutex>
 #include <string_view>
 #include <type_traits>
+#include <utility>
 
+#include "core/aho_corasick.hpp"
 #include "core/assert.hpp"
 #include "core/config.hpp"
 #include "core/context.hpp"
-#include "core/line.hpp"
+#include "core/grep_cache.hpp"
+#include "core/index_cache.hpp"
+#include "core/line_index.hpp"
+#include "core/literal_search.hpp"
 #include "core/logger.hpp"
+#include "core/newline_scanner.hpp"
 #include "core/regex.hpp"
 #include "core/thread.hpp"
+#include "core/timestamp.hpp"
+#include "sys/system.hpp"
 #include "utils/format.hpp"
 #include "utils/function_ref.hpp"
 #include "utils/math.hpp"
+#include "utils/maybe.hpp"
 #include "utils/memory.hpp"
+#include "utils/noncopyable.hpp"
+#include "utils/roaring_bitmap.hpp"
+#include "utils/string.hpp"
 #include "utils/time.hpp"
 #include "utils/units.hpp"
 
@@ -26,23 +40,92 @@ namespace core
 
 using Result = std::expected<bool, BufferError>;
 using Results = std::vector<Result>;
+using Files = std::vector<File>;
 
 enum struct BufferType : char
 {
     uninitialized,
     base,
     filtered,
+    merged,
 };
 
 enum struct State : char
 {
     uninitialized,
     busy,
+    loading,
     idle,
     aborted,
 };
 
+enum struct FollowState : char
+{
+    off,
+    running,
+    stopping,
+};
+
 constexpr static size_t BLOCK_SIZE = 16_MiB;
+constexpr static float PUBLISH_INTERVAL = 0.1f;
+constexpr static int FOLLOW_INTERVAL_MS = 100;
+constexpr static size_t TIMESTAMP_DETECTION_LEN = 64_KiB;
+
+// Number of workers reading line indexes. Follow updates are not applied
+// while there are any, as extending an index can reallocate its arrays
+static std::atomic_uint indexReaders;
+
+// Versions of buffers, which key cached greps; a buffer gets a new one
+// whenever its lines change, so none is ever reused
+static std::atomic_uint64_t lastVersion;
+
+// Lines without timestamp continue the preceding one; the one they belong to
+// is looked for at most that far back
+constexpr static size_t MAX_CONTINUATION_LINES = 1024;
+
+// Block grep is chosen if at most 1 in GREP_SPARSE_RATIO of first
+// GREP_SAMPLE_LINES lines match
+constexpr static size_t GREP_BLOCK_SIZE = 1_MiB;
+constexpr static size_t GREP_SAMPLE_LINES = 1024;
+constexpr static size_t GREP_SPARSE_RATIO = 8;
+
+// Workers of grep check whether to publish their matches every that many lines
+constexpr static size_t GREP_PUBLISH_LINES = 4096;
+
+// Shorter literal required by regex passes too many lines to be worth it
+constexpr static size_t MIN_PREFILTER_LEN = 3;
+
+// Parallel load and grep split lines or bytes given per thread by config into
+// that many chunks, unless they would get smaller than the minimal size
+constexpr static size_t CHUNKS_PER_THREAD = 8;
+constexpr static size_t MIN_LOAD_CHUNK_SIZE = 16_MiB;
+constexpr static size_t MIN_GREP_CHUNK_LINES = 65536;
+
+// Number of lines sampled per thread to split merge between threads evenly
+constexpr static size_t MERGE_SAMPLES_PER_THREAD = 16;
+
+// Files interleaved by timestamps of their lines. Line of merge is referred to
+// by index of its source in the top bits and by its index in the source in
+// the rest
+struct Buffer::Merge final : utils::NonCopyable
+{
+    constexpr static size_t SOURCE_SHIFT = 56;
+    constexpr static size_t LINE_MASK = (size_t(1) << SOURCE_SHIFT) - 1;
+
+    static_assert(MAX_MERGED_FILES <= size_t(1) << (64 - SOURCE_SHIFT));
+
+    struct Source
+    {
+        File        file;
+        Lines       lines;
+        Timestamps  timestamps;
+        std::string name;
+    };
+
+    std::vector<Source> sources;
+    LineRefs            refs;
+    std::string         name;
+};
 
 template <typename T>
 constexpr static inline char cast(T value)
@@ -61,6 +144,7 @@ constexpr static inline const char* stringify(char value)
         {
             PRINT_STATE(uninitialized);
             PRINT_STATE(busy);
+            PRINT_STATE(loading);
             PRINT_STATE(idle);
             PRINT_STATE(aborted);
         }
@@ -75,6 +159,7 @@ constexpr static inline const char* stringify(char value)
             PRINT_TYPE(uninitialized);
             PRINT_TYPE(base);
             PRINT_TYPE(filtered);
+            PRINT_TYPE(merged);
         }
         return "unknown";
     }
@@ -84,6 +169,272 @@ constexpr static inline const char* stringify(char value)
     }
 }
 
+// Hands over chunks of index being built to the main thread, so that buffer
+// can be displayed and scrolled before loading finishes. The first chunk is
+// published as soon as possible, following ones at most every PUBLISH_INTERVAL
+struct Publisher final
+{
+    Publisher(const LoadProgressCallback& callback)
+        : mCallback(callback)
+        , mLastStart(0)
+        , mLastTime(0)
+        , mCount(0)
+    {
+    }
+
+    void publish(Lines& lines, Timestamps& timestamps, bool force = false)
+    {
+        if (lines.startCount() == 0)
+        {
+            return;
+        }
+
+        if (not force and mCount and mTimer.elapsed() - mLastTime < PUBLISH_INTERVAL)
+        {
+            return;
+        }
+
+        send(lines, timestamps, false);
+    }
+
+    // Adds sentinel for the last line, like LineIndex::finalize, but taking
+    // into account the already published chunks, and publishes the rest
+    void finish(Lines& lines, Timestamps& timestamps, size_t fileSize)
+    {
+        if (lines.startCount())
+        {
+            mLastStart = lines.lastStart();
+        }
+
+        if (mLastStart < fileSize)
+        {
+            lines.append(fileSize + 1);
+        }
+
+        send(lines, timestamps, true);
+    }
+
+    constexpr unsigned count() const
+    {
+        return mCount;
+    }
+
+private:
+    void send(Lines& lines, Timestamps& timestamps, bool last)
+    {
+        if (lines.startCount())
+        {
+            mLastStart = lines.lastStart();
+        }
+
+        mLastTime = mTimer.elapsed();
+        ++mCount;
+
+        mCallback(LoadProgress{
+            .lines = std::move(lines),
+            .timestamps = std::move(timestamps),
+            .time = mLastTime,
+            .last = last,
+        });
+    }
+
+    const LoadProgressCallback& mCallback;
+    utils::Timer                mTimer;
+    size_t                      mLastStart;
+    float                       mLastTime;
+    unsigned                    mCount;
+};
+
+// Hands over matches of grep to the main thread, so that grep window can be
+// used before grep finishes. Workers grep consecutive ranges of lines, called
+// parts, which are chunks of ChunkQueue; only the worker of the first
+// unfinished part publishes its matches while running; matches of the
+// following parts are published once all preceding parts have finished, so
+// that they're applied in order
+struct GrepPublisher final
+{
+    GrepPublisher(const GrepProgressCallback& callback, std::vector<LineRefs>& parts)
+        : mCallback(callback)
+        , mParts(parts)
+        , mFinished(parts.size(), false)
+        , mCurrent(0)
+        , mLastTime(0)
+        , mCount(0)
+    {
+    }
+
+    // Called periodically by worker of the part
+    void publish(size_t part)
+    {
+        if (part != mCurrent.load(std::memory_order_acquire) or mParts[part].empty())
+        {
+            return;
+        }
+
+        std::lock_guard lock(mLock);
+
+        if (mCount and mTimer.elapsed() - mLastTime < PUBLISH_INTERVAL)
+        {
+            return;
+        }
+
+        send(mParts[part], false);
+    }
+
+    // Called by worker of the part once it has grepped all its lines
+    void finish(size_t part)
+    {
+        std::lock_guard lock(mLock);
+
+        mFinished[part] = true;
+
+        for (auto current = mCurrent.load(std::memory_order_relaxed);
+            current < mParts.size() and mFinished[current];
+            ++current)
+        {
+            const bool last = current == mParts.size() - 1;
+
+            if (last or not mParts[current].empty())
+            {
+                send(mParts[current], last);
+            }
+
+            mCurrent.store(current + 1, std::memory_order_release);
+        }
+    }
+
+    unsigned count()
+    {
+        std::lock_guard lock(mLock);
+        return mCount;
+    }
+
+private:
+    void send(LineRefs& lines, bool last)
+    {
+        mLastTime = mTimer.elapsed();
+        ++mCount;
+
+        // Bitmap is built here, on the worker, so that it costs the main
+        // thread only appending it
+        utils::RoaringBitmap bitmap;
+
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            bitmap.append(lines[i]);
+        }
+
+        mCallback(GrepProgress{
+            .lines = std::exchange(lines, LineRefs()),
+            .bitmap = std::move(bitmap),
+            .time = mLastTime,
+            .last = last,
+        });
+    }
+
+    const GrepProgressCallback& mCallback;
+    std::vector<LineRefs>&      mParts;
+    std::vector<bool>           mFinished;
+    std::atomic_size_t          mCurrent;
+    std::mutex                  mLock;
+    utils::Timer                mTimer;
+    float                       mLastTime;
+    unsigned                    mCount;
+};
+
+constexpr static size_t chunkSize(size_t perThread, size_t minChunkSize)
+{
+    return utils::max(perThread / CHUNKS_PER_THREAD, minChunkSize);
+}
+
+// Range of lines or bytes split into equal chunks, which threads take one by
+// one as they finish previous ones, so that a thread stuck with a slow part
+// of file, e.g. long lines or dense matches, doesn't leave others idle.
+// Results are kept per chunk, so they can be joined in order
+struct ChunkQueue final
+{
+    struct Chunk
+    {
+        size_t index;
+        size_t start;
+        size_t end;
+    };
+
+    ChunkQueue(size_t start, size_t end, size_t chunkSize)
+        : mStart(start)
+        , mSize(end - start)
+        , mCount(utils::max((mSize + chunkSize - 1) / chunkSize, size_t(1)))
+        , mNext(0)
+    {
+    }
+
+    utils::Maybe<Chunk> next()
+    {
+        const auto index = mNext.fetch_add(1, std::memory_order_relaxed);
+
+        if (index >= mCount)
+        {
+            return {};
+        }
+
+        return Chunk{.index = index, .start = boundary(index), .end = boundary(index + 1)};
+    }
+
+    // No chunks are handed out anymore, e.g. as one of them has failed
+    void cancel()
+    {
+        mNext.store(mCount, std::memory_order_relaxed);
+    }
+
+    constexpr size_t count() const
+    {
+        return mCount;
+    }
+
+    // Threads beyond the number of chunks would have nothing to take
+    constexpr size_t threadCount(size_t maxThreads) const
+    {
+        return utils::max(utils::min(maxThreads, mCount), size_t(1));
+    }
+
+private:
+    constexpr size_t boundary(size_t index) const
+    {
+        return index == mCount ? mStart + mSize : mStart + mSize / mCount * index;
+    }
+
+    const size_t       mStart;
+    const size_t       mSize;
+    const size_t       mCount;
+    std::atomic_size_t mNext;
+};
+
+// Stands in for GrepPublisher when matches aren't shown while grep runs
+struct NullPublisher final
+{
+    constexpr void publish(size_t)
+    {
+    }
+};
+
+// Stands in for matches of grep when they're only counted. If attribute is
+// set, it's called with each matching line, e.g. to count it per pattern
+struct GrepCounter final
+{
+    void pushBack(size_t lineIndex)
+    {
+        ++lines;
+
+        if (attribute) [[unlikely]]
+        {
+            (*attribute)(lineIndex);
+        }
+    }
+
+    size_t                                  lines = 0;
+    const utils::FunctionRef<void(size_t)>* attribute = nullptr;
+};
+
 struct Buffer::Impl final : Buffer
 {
     Impl() = delete;
@@ -93,19 +444,40 @@ struct Buffer::Impl final : Buffer
         return *static_cast<Impl*>(b);
     }
 
-    constexpr inline void setBusy()
+    constexpr static inline const Impl& get(const Buffer* b)
+    {
+        return *static_cast<const Impl*>(b);
+    }
+
+    inline void setBusy()
+    {
+        notifyChange([this]{ mState = cast(State::busy); });
+    }
+
+    inline void setLoading()
     {
-        mState = cast(State::busy);
+        notifyChange([this]{ mState = cast(State::loading); });
     }
 
-    constexpr inline void setIdle()
+    inline void setIdle()
     {
-        mState = cast(State::idle);
+        notifyChange([this]{ mState = cast(State::idle); });
     }
 
-    constexpr inline void setAborted()
+    inline void setAborted()
     {
-        mState = cast(State::aborted);
+        notifyChange([this]{ mState = cast(State::aborted); });
+    }
+
+    // State which stop, stopSearch and waitForChunks wait for is changed
+    // under the lock, so that they can't miss it, and so that buffer can't
+    // be destroyed by stop before the change is notified
+    template <typename Change>
+    inline void notifyChange(const Change& change)
+    {
+        std::lock_guard lock(mStateLock);
+        change();
+        mStateChanged.notify_all();
     }
 
     constexpr inline void setType(BufferType type)
@@ -113,60 +485,215 @@ struct Buffer::Impl final : Buffer
         mType = cast(type);
     }
 
-    constexpr inline void stop()
+    constexpr inline bool isRunning() const
+    {
+        return mState == cast(State::busy) or mState == cast(State::loading) or mSearching or mCounting;
+    }
+
+    inline void stop()
     {
-        if (mState == cast(State::busy)) [[unlikely]]
+        if (isRunning()) [[unlikely]]
         {
+            std::unique_lock lock(mStateLock);
             mStopFlag = true;
-            while (mState == cast(State::busy));
+            mStateChanged.notify_all();
+            mStateChanged.wait(lock, [this]{ return not isRunning(); });
             mStopFlag = false;
         }
     }
 
+    // Search runs aside of other operations, e.g. on matches of running
+    // grep, so it's stopped on its own
+    inline void stopSearch()
+    {
+        if (mSearching) [[unlikely]]
+        {
+            std::unique_lock lock(mStateLock);
+            mSearchStopFlag = true;
+            mStateChanged.wait(lock, [this]{ return not mSearching; });
+            mSearchStopFlag = false;
+        }
+    }
+
+    // Line of file, or of one of merged files, and index of the file
+    struct Location
+    {
+        Line   line;
+        size_t source;
+    };
+
+    constexpr inline Location locate(size_t lineIndex) const
+    {
+        if (mMerge) [[unlikely]]
+        {
+            const auto ref = mMerge->refs[lineIndex];
+            const auto source = ref >> Merge::SOURCE_SHIFT;
+            return Location{.line = mMerge->sources[source].lines[ref & Merge::LINE_MASK], .source = source};
+        }
+        return Location{.line = (*mFileLines)[lineIndex], .source = 0};
+    }
+
+    constexpr inline size_t baseLineCount() const
+    {
+        return mMerge ? mMerge->refs.size() : mFileLines->size();
+    }
+
+    constexpr inline File& sourceFile(size_t source)
+    {
+        return mMerge ? mMerge->sources[source].file : mFile;
+    }
+
+    // Timestamp of line of file, or of merge, from the indexed column
+    constexpr inline Timestamp timestampOf(size_t lineIndex) const
+    {
+        if (mMerge) [[unlikely]]
+        {
+            const auto ref = mMerge->refs[lineIndex];
+            const auto& timestamps = mMerge->sources[ref >> Merge::SOURCE_SHIFT].timestamps;
+            const auto line = ref & Merge::LINE_MASK;
+            return line < timestamps.size() ? timestamps[line] : NO_TIMESTAMP;
+        }
+        return mFileTimestamps and lineIndex < mFileTimestamps->size()
+            ? (*mFileTimestamps)[lineIndex]
+            : NO_TIMESTAMP;
+    }
+
+    // Copies of files, one for each source, for a worker to read lines with
+    Files copyFiles() const;
+
     void copyFromParent(Buffer& parentBuffer);
     void initialize(Lines&& lines);
-    void initialize(LineRefs&& lineRefs);
+    void initialize(LineRefs&& lineRefs, utils::RoaringBitmap&& bitmap);
+    void initialize(LineRefsPtr lineRefs, LineBitmapPtr bitmap);
+    void initialize(MergePtr merge);
+
+    // Index is the one which chunks passed to progressCallback are applied to
+    Result loadFile(File& file, Context& context, const LoadProgressCallback& progressCallback, const Lines& index);
+
+    // Indexes compressed file while it's being decompressed to build its
+    // compression index, so that it's decompressed only once
+    Result loadCompressedFile(File& file, const LoadProgressCallback& progressCallback, Context& context);
 
-    Result singleThreadedLoadFile();
+    // Format set in config; if it's automatic, the one found in the beginning
+    // of file
+    TimestampFormat timestampFormat(File& file, Context& context);
+    TimestampFormat timestampFormat(const std::string& path, std::string_view head, Context& context);
 
-    Result multiThreadedLoadFile(Context& context);
+    Result multiThreadedReadLines(
+        File& file,
+        size_t start,
+        Lines& lines,
+        Timestamps& timestamps,
+        TimestampFormat format,
+        Publisher& publisher,
+        Context& context);
 
+    // Indexes lines starting after newlines in [start, end), and timestamps
+    // of these lines unless format is none
     Result readLines(
         File& file,
         size_t start,
         size_t end,
-        Lines& lines);
+        Lines& lines,
+        Timestamps& timestamps,
+        TimestampFormat format,
+        Publisher* publisher = nullptr,
+        Progress::Counter* counter = nullptr);
+
+    // Indexes timestamp of a line which start wasn't found by readLines
+    Result readTimestamp(File& file, size_t start, Timestamps& timestamps, TimestampFormat format);
+
+    Result waitForChunks(unsigned count);
+
+    void followFile(std::string path, FileBackend backend, sys::FileIdentity identity, size_t size, const FollowCallback& callback);
+
+    Result mergeFiles(Context& context);
+
+    Result mergeSources(Context& context);
+
+    Result mergeRange(
+        Files& files,
+        const std::vector<size_t>& begin,
+        const std::vector<size_t>& end,
+        LineRefs& refs,
+        Progress::Counter& counter);
+
+    std::vector<Timestamp> mergePivots(Files& files, size_t threadCount);
+
+    size_t findFirstLineAfter(size_t source, File& file, Timestamp timestamp);
+
+    Timestamp timestampAt(size_t source, File& file, size_t lineIndex);
 
     Result singleThreadedGrep(
         std::string pattern,
         GrepOptions options,
-        Buffer& parentBuffer);
+        Buffer& parentBuffer,
+        const GrepProgressCallback& progressCallback,
+        Context& context);
 
     Result multiThreadedGrep(
         std::string pattern,
         GrepOptions options,
         Buffer& parentBuffer,
+        const GrepProgressCallback& progressCallback,
         Context& context);
 
+    // Lines are grepped into lineRefs, which are the given part of publisher;
+    // if they're only counted, lineRefs is GrepCounter and publisher is
+    // NullPublisher
+    template <typename Sink, typename Publisher>
     Result grep(
         std::string pattern,
         GrepOptions options,
         Buffer& parentBuffer,
+        Files& files,
+        size_t start,
+        size_t end,
+        Sink& lineRefs,
+        Progress::Counter& counter,
+        Publisher& publisher,
+        size_t part);
+
+    GrepCountOrError count(std::string pattern, GrepOptions options, Context& context);
+
+    // Grep of lines of file which runs the search over whole blocks and maps
+    // hits back to lines, unless sampled lines match too often for it to pay
+    // off; used only if no line can be skipped, i.e. for base buffer. Matcher
+    // is either LiteralSearch or AhoCorasick, which find offset of some byte
+    // of hit. If re is given, matcher is its prefilter and lines with hits
+    // are matched against it
+    template <typename Matcher, typename Sink, typename Publisher>
+    Result blockGrep(
+        const Matcher& matcher,
+        Regex* re,
+        bool inverted,
         File& file,
         size_t start,
         size_t end,
-        LineRefs& lineRefs);
+        Sink& lineRefs,
+        Progress::Counter& counter,
+        Publisher& publisher,
+        size_t part);
+
+    // Index of line of file in [first, last) which contains offset
+    size_t findLine(size_t offset, size_t first, size_t last) const;
+
+    void logProgress(const char* operation, const char* unit = nullptr);
 
     void filter(
         size_t start,
         size_t end,
         Buffer& parentBuffer);
 
+    void combine(
+        SetOperation operation,
+        const Buffer& first,
+        const Buffer& second);
+
     SearchResult search(
         const SearchRequest& req,
-        File& file);
+        Files& files);
 
-    StringViewOrError readInternal(Line line);
     StringViewOrError readInternal(Line line, File& file);
 };
 
@@ -174,8 +701,24 @@ Buffer::Buffer()
     : mStopFlag(false)
     , mState(cast(State::uninitialized))
     , mType(cast(BufferType::uninitialized))
+    , mFollowState(cast(FollowState::off))
+    , mFollowDeferred(false)
+    , mAppliedChunks(0)
+    , mSearching(false)
+    , mSearchStopFlag(false)
+    , mCounting(false)
+    , mDeferredLast(false)
+    , mGrepCached(false)
+    , mTimestampFormat(TimestampFormat::none)
+    , mFileSize(0)
     , mLineCount(0)
+    , mFirstChunkTime(0)
     , mFileLines(nullptr)
+    , mFileTimestamps(nullptr)
+    , mMerge(nullptr)
+    , mDeferredChunks(0)
+    , mVersion(++lastVersion)
+    , mGrepCacheLimit(0)
 {
     static_assert(sizeof(Impl) == sizeof(Buffer));
 }
@@ -183,7 +726,9 @@ Buffer::Buffer()
 Buffer::~Buffer()
 {
     assert(isMainThread(), "~Buffer called not on main thread");
+    unfollow();
     Impl::get(this).stop();
+    grepCacheInvalidate(mVersion);
     switch (mType)
     {
         case cast(BufferType::base):
@@ -192,80 +737,50 @@ Buffer::~Buffer()
         case cast(BufferType::filtered):
             utils::destroyAt(&mFilteredLines);
             break;
+        case cast(BufferType::merged):
+            utils::destroyAt(&mOwnMerge);
+            break;
         default:
             break;
     }
 }
 
-void Buffer::load(std::string path, Context& context, FinishedCallback callback)
+void Buffer::load(std::string path, FileBackend backend, Context& context, LoadProgressCallback progressCallback, FinishedCallback callback)
 {
     assert(mState == cast(State::uninitialized), utils::format("Buffer {} state is {}", this, stringify<State>(mState)));
     assert(mType == cast(BufferType::uninitialized), utils::format("Buffer {} type is {}", this, stringify<BufferType>(mType)));
 
     auto& impl = Impl::get(this);
 
-    impl.setBusy();
+    impl.setLoading();
 
-    if (auto result = mFile.open(std::move(path)); not result) [[unlikely]]
+    if (auto result = mFile.open(std::move(path), backend); not result) [[unlikely]]
     {
         impl.setAborted();
         callback(std::unexpected(BufferError::systemError(std::move(result.error()))));
         return;
     }
 
-    async(
-        [callback = std::move(callback), &impl, &context]
-        {
-            auto timer = utils::startTimeMeasurement();
-
-            bool runMultiThreaded = impl.mFile.size() > context.config.bytesPerThread
-                and context.config.maxThreads > 1;
-
-            auto result = runMultiThreaded
-                ? impl.multiThreadedLoadFile(context)
-                : impl.singleThreadedLoadFile();
+    mFileSize = mFile.size();
 
-            if (result) [[likely]]
-            {
-                impl.setIdle();
-                callback(timer.elapsed());
-            }
-            else
-            {
-                impl.setAborted();
-                callback(std::unexpected(std::move(result.error())));
-            }
-        });
-}
+    // Buffer's own file is used for reading lines which are displayed
+    mFile.setAccessPattern(sys::AccessPattern::random);
 
-void Buffer::grep(std::string pattern, GrepOptions options, BufferId parentBufferId, Context& context, FinishedCallback callback)
-{
-    auto& impl = Impl::get(this);
+    // Index is filled on the main thread by applyLoadProgress
+    impl.initialize(Lines{});
 
-    impl.setBusy();
+    // Limit of maxThreads, so that it can be changed while the operation runs
+    mProgress.start(utils::max(hardwareThreadCount(), 1u));
 
     async(
-        [pattern = std::move(pattern), callback = std::move(callback), options, parentBufferId, &context, &impl]
+        [progressCallback = std::move(progressCallback), callback = std::move(callback), file = mFile, &impl, &context] mutable
         {
-            auto parentBuffer = getBuffer(parentBufferId, context);
-
-            if (not parentBuffer) [[unlikely]]
-            {
-                impl.setAborted();
-                callback(std::unexpected(BufferError::aborted("Parent buffer has been closed")));
-                return;
-            }
-
-            impl.copyFromParent(*parentBuffer);
-
             auto timer = utils::startTimeMeasurement();
 
-            bool runMultiThreaded = parentBuffer->mLineCount > context.config.linesPerThread
-                and context.config.maxThreads > 1;
+            auto result = impl.loadFile(file, context, progressCallback, impl.mOwnLines);
 
-            auto result = runMultiThreaded
-                ? impl.multiThreadedGrep(std::move(pattern), options, *parentBuffer, context)
-                : impl.singleThreadedGrep(std::move(pattern), options, *parentBuffer);
+            impl.mProgress.stop();
+            impl.logProgress("load");
 
             if (result) [[likely]]
             {
@@ -280,392 +795,1905 @@ void Buffer::grep(std::string pattern, GrepOptions options, BufferId parentBuffe
         });
 }
 
-void Buffer::filter(size_t start, size_t end, BufferId parentBufferId, Context& context, FinishedCallback callback)
+void Buffer::applyLoadProgress(LoadProgress progress)
 {
-    auto& impl = Impl::get(this);
+    assert(isMainThread(), "applyLoadProgress called not on main thread");
 
-    impl.setBusy();
-
-    async(
-        [start, end, callback = std::move(callback), parentBufferId, &context, &impl]
-        {
-            auto parentBuffer = getBuffer(parentBufferId, context);
+    if (mOwnLines.startCount() == 0)
+    {
+        mOwnLines = std::move(progress.lines);
+        mFirstChunkTime = progress.time;
 
-            if (not parentBuffer) [[unlikely]]
-            {
-                impl.setAborted();
-                callback(std::unexpected(BufferError::aborted("Parent buffer has been closed")));
-                return;
-            }
+        // Size of compressed file is known only after it was decompressed
+        mFileSize = mFile.size();
+    }
+    else
+    {
+        mOwnLines.append(std::move(progress.lines));
+    }
 
-            impl.copyFromParent(*parentBuffer);
+    mOwnTimestamps.append(std::move(progress.timestamps));
 
-            auto timer = utils::startTimeMeasurement();
+    if (progress.last)
+    {
+        mOwnLines.shrinkToFit();
+        mOwnTimestamps.shrinkToFit();
+    }
 
-            impl.filter(start, end, *parentBuffer);
+    mLineCount = mOwnLines.size();
 
-            impl.setIdle();
-            callback(timer.elapsed());
-        });
+    Impl::get(this).notifyChange([this]{ mAppliedChunks.fetch_add(1, std::memory_order_release); });
 }
 
-StringViewOrError Buffer::readLine(size_t i)
+void Buffer::follow(FollowCallback callback)
 {
-    auto lineIndex = i;
+    assert(isMainThread(), "follow called not on main thread");
+    assert(mType == cast(BufferType::base), utils::format("Buffer {} type is {}", this, stringify<BufferType>(mType)));
 
-    if (mType == cast(BufferType::filtered))
+    if (mFollowState != cast(FollowState::off))
     {
-        lineIndex = mFilteredLines[lineIndex];
+        return;
     }
 
-    auto& line = (*mFileLines)[lineIndex];
+    auto& impl = Impl::get(this);
 
-    if (line.len == 0)
-    {
+    mFollowState = cast(FollowState::running);
+
+    spawn(
+        [callback = std::move(callback), path = mFile.path(), backend = mFile.backend(), identity = mFile.identity(), size = mFileSize, &impl]
+        {
+            impl.followFile(path, backend, identity, size, callback);
+
+            // State is changed under lock, so that unfollow cannot return
+            // and destroy the buffer while it's still being notified
+            std::lock_guard lock(impl.mFollowLock);
+            impl.mFollowState = cast(FollowState::off);
+            impl.mFollowStopped.notify_all();
+        });
+}
+
+void Buffer::unfollow()
+{
+    if (mFollowState == cast(FollowState::running))
+    {
+        std::unique_lock lock(mFollowLock);
+        mFollowState = cast(FollowState::stopping);
+        mFollowStopped.wait(lock, [this]{ return mFollowState == cast(FollowState::off); });
+    }
+
+    mPendingUpdate.reset();
+    mFollowDeferred = false;
+}
+
+static bool isSameFile(const sys::FileIdentity& lhs, const sys::FileIdentity& rhs)
+{
+    return lhs.device == rhs.device and lhs.inode == rhs.inode;
+}
+
+std::expected<bool, BufferError> Buffer::applyFollowUpdate(FollowUpdate update)
+{
+    assert(isMainThread(), "applyFollowUpdate called not on main thread");
+
+    if (mPendingUpdate)
+    {
+        if (update.type == FollowUpdate::Type::grown)
+        {
+            mPendingUpdate->lines.append(std::move(update.lines));
+            mPendingUpdate->timestamps.append(std::move(update.timestamps));
+            mPendingUpdate->fileSize = update.fileSize;
+            update = std::move(*mPendingUpdate);
+        }
+        mPendingUpdate.reset();
+    }
+
+    // Workers are started only from the main thread, so none can start
+    // reading the index until it's modified
+    if (indexReaders.load(std::memory_order_acquire))
+    {
+        mPendingUpdate = utils::makeUnique<FollowUpdate>(std::move(update));
+        mFollowDeferred = true;
+        return false;
+    }
+
+    mFollowDeferred = false;
+
+    bool unchanged = false;
+
+    if (update.type == FollowUpdate::Type::replaced)
+    {
+        File file;
+
+        if (auto result = file.open(mFile.path(), mFile.backend()); not result) [[unlikely]]
+        {
+            return std::unexpected(BufferError::systemError(std::move(result.error())));
+        }
+
+        if (not isSameFile(file.identity(), update.identity)) [[unlikely]]
+        {
+            return std::unexpected(BufferError::aborted("File has been replaced again while being indexed"));
+        }
+
+        mFile = file;
+        mOwnLines = std::move(update.lines);
+        mOwnTimestamps = std::move(update.timestamps);
+    }
+    else
+    {
+        if (not isSameFile(mFile.identity(), update.identity)) [[unlikely]]
+        {
+            return std::unexpected(BufferError::aborted("File has been replaced while being followed"));
+        }
+
+        // Reads are mapped within the size cached by file, so new lines
+        // couldn't be read without it being refreshed
+        if (update.fileSize != mFileSize)
+        {
+            if (auto result = mFile.refresh(); not result) [[unlikely]]
+            {
+                return std::unexpected(BufferError::systemError(std::move(result.error())));
+            }
+        }
+
+        unchanged = update.lines.empty() and update.fileSize == mFileSize;
+
+        mOwnLines.unfinalize(mFileSize);
+        mOwnLines.append(std::move(update.lines));
+        mOwnTimestamps.append(std::move(update.timestamps));
+    }
+
+    mOwnLines.finalize(update.fileSize);
+
+    mFileSize = update.fileSize;
+    mLineCount = mOwnLines.size();
+
+    // Update sent only to apply a deferred one doesn't change lines, so
+    // matches of greps cached for them are still valid
+    if (not unchanged)
+    {
+        grepCacheInvalidate(std::exchange(mVersion, ++lastVersion));
+    }
+
+    return true;
+}
+
+static std::string baseName(const std::string& path)
+{
+    const auto slash = path.rfind('/');
+    return slash == path.npos ? path : path.substr(slash + 1);
+}
+
+void Buffer::merge(std::vector<std::string> paths, FileBackend backend, Context& context, FinishedCallback callback)
+{
+    assert(mState == cast(State::uninitialized), utils::format("Buffer {} state is {}", this, stringify<State>(mState)));
+    assert(mType == cast(BufferType::uninitialized), utils::format("Buffer {} type is {}", this, stringify<BufferType>(mType)));
+    assert(paths.size() <= MAX_MERGED_FILES, utils::format("Buffer {} merges {} files", this, paths.size()));
+
+    auto& impl = Impl::get(this);
+
+    impl.setLoading();
+
+    auto merge = utils::makeUnique<Merge>();
+
+    merge->sources.reserve(paths.size());
+
+    for (auto& path : paths)
+    {
+        auto& source = merge->sources.emplace_back();
+
+        if (auto result = source.file.open(std::move(path), backend); not result) [[unlikely]]
+        {
+            impl.setAborted();
+            callback(std::unexpected(BufferError::systemError(std::move(result.error()))));
+            return;
+        }
+
+        // Source files are used for reading lines which are displayed
+        source.file.setAccessPattern(sys::AccessPattern::random);
+        source.name = baseName(source.file.path());
+
+        merge->name += merge->name.empty() ? "" : " + ";
+        merge->name += source.file.path();
+    }
+
+    // Merge is filled by the worker; until it's done the buffer isn't shown
+    impl.initialize(std::move(merge));
+
+    mProgress.start(utils::max(hardwareThreadCount(), 1u));
+
+    async(
+        [callback = std::move(callback), &impl, &context]
+        {
+            auto timer = utils::startTimeMeasurement();
+
+            auto result = impl.mergeFiles(context);
+
+            impl.mProgress.stop();
+            impl.logProgress("merge");
+
+            if (result) [[likely]]
+            {
+                impl.setIdle();
+                callback(timer.elapsed());
+            }
+            else
+            {
+                impl.setAborted();
+                callback(std::unexpected(std::move(result.error())));
+            }
+        });
+}
+
+void Buffer::grep(std::string pattern, GrepOptions options, BufferId parentBufferId, Context& context, GrepProgressCallback progressCallback, FinishedCallback callback)
+{
+    auto& impl = Impl::get(this);
+
+    if (const size_t limit = context.config.grepCacheSize; limit)
+    {
+        auto parentBuffer = getBuffer(parentBufferId, context);
+
+        if (parentBuffer) [[likely]]
+        {
+            auto key = GrepCacheKey{
+                .parentVersion = parentBuffer->mVersion,
+                .pattern = pattern,
+                .options = options,
+            };
+
+            if (auto cached = grepCacheFind(key); cached.lines.get())
+            {
+                impl.copyFromParent(*parentBuffer);
+                impl.initialize(std::move(cached.lines), std::move(cached.bitmap));
+                mGrepPrefilter = std::move(cached.prefilter);
+                impl.setIdle();
+                mGrepCached = true;
+                callback(0.0f);
+                return;
+            }
+
+            // Matches are stored once they're all applied
+            mGrepCacheKey = utils::makeUnique<GrepCacheKey>(std::move(key));
+            mGrepCacheLimit = limit;
+        }
+    }
+
+    // Matches are appended on the main thread by applyGrepProgress, and until
+    // grep finishes buffer can't be grepped or filtered further
+    impl.setLoading();
+    impl.initialize(LineRefs{}, utils::RoaringBitmap{});
+
+    indexReaders.fetch_add(1, std::memory_order_relaxed);
+
+    // Limit of maxThreads, so that it can be changed while the operation runs
+    mProgress.start(utils::max(hardwareThreadCount(), 1u));
+
+    async(
+        [pattern = std::move(pattern), progressCallback = std::move(progressCallback), callback = std::move(callback),
+            options, parentBufferId, &context, &impl]
+        {
+            auto parentBuffer = getBuffer(parentBufferId, context);
+
+            if (not parentBuffer) [[unlikely]]
+            {
+                indexReaders.fetch_sub(1, std::memory_order_release);
+                impl.mProgress.stop();
+                impl.setAborted();
+                callback(std::unexpected(BufferError::aborted("Parent buffer has been closed")));
+                return;
+            }
+
+            impl.copyFromParent(*parentBuffer);
+
+            impl.mProgress.setTotal(parentBuffer->mLineCount);
+
+            auto timer = utils::startTimeMeasurement();
+
+            bool runMultiThreaded = parentBuffer->mLineCount > chunkSize(context.config.linesPerThread, MIN_GREP_CHUNK_LINES)
+                and context.config.maxThreads > 1;
+
+            auto result = runMultiThreaded
+                ? impl.multiThreadedGrep(std::move(pattern), options, *parentBuffer, progressCallback, context)
+                : impl.singleThreadedGrep(std::move(pattern), options, *parentBuffer, progressCallback, context);
+
+            indexReaders.fetch_sub(1, std::memory_order_release);
+
+            impl.mProgress.stop();
+            impl.logProgress("grep", "lines");
+
+            if (result) [[likely]]
+            {
+                impl.setIdle();
+                callback(timer.elapsed());
+            }
+            else
+            {
+                impl.setAborted();
+                callback(std::unexpected(std::move(result.error())));
+            }
+        });
+}
+
+bool Buffer::applyGrepProgress(GrepProgress progress)
+{
+    assert(isMainThread(), "applyGrepProgress called not on main thread");
+
+    // Only the last published chunk can be empty
+    if (not progress.lines.empty() or progress.last)
+    {
+        mDeferredLines.append(std::move(progress.lines));
+        mDeferredBitmap.append(std::move(progress.bitmap));
+        mDeferredLast = progress.last;
+        ++mDeferredChunks;
+    }
+
+    // Searching worker reads matches; no new one can start until they're
+    // appended, as searches are started only from the main thread
+    if (mSearching or mDeferredChunks == 0)
+    {
+        return false;
+    }
+
+    mFilteredLines->append(std::move(mDeferredLines));
+    mBitmap->append(std::move(mDeferredBitmap));
+
+    mLineCount = mFilteredLines->size();
+
+    // Matches are complete and won't be modified anymore
+    if (mDeferredLast)
+    {
+        mFilteredLines->shrinkToFit();
+
+        if (mGrepCacheKey)
+        {
+            grepCacheStore(
+                std::move(*mGrepCacheKey),
+                GrepCacheValue{.lines = mFilteredLines, .bitmap = mBitmap, .prefilter = mGrepPrefilter},
+                mGrepCacheLimit);
+            mGrepCacheKey.reset();
+        }
+    }
+
+    Impl::get(this).notifyChange(
+        [this, chunks = std::exchange(mDeferredChunks, 0)]
+        {
+            mAppliedChunks.fetch_add(chunks, std::memory_order_release);
+        });
+
+    return true;
+}
+
+void Buffer::count(std::string pattern, GrepOptions options, Context& context, FinishedCountCallback callback)
+{
+    assert(isMainThread(), "count called not on main thread");
+
+    auto& impl = Impl::get(this);
+
+    mCounting = true;
+
+    indexReaders.fetch_add(1, std::memory_order_relaxed);
+
+    async(
+        [pattern = std::move(pattern), callback = std::move(callback), options, &context, &impl]
+        {
+            auto timer = utils::startTimeMeasurement();
+            auto result = impl.count(std::move(pattern), options, context);
+            indexReaders.fetch_sub(1, std::memory_order_release);
+
+            if (result) [[likely]]
+            {
+                result->time = timer.elapsed();
+            }
+
+            impl.notifyChange([&impl]{ impl.mCounting = false; });
+            callback(std::move(result));
+        });
+}
+
+void Buffer::filter(size_t start, size_t end, BufferId parentBufferId, Context& context, FinishedCallback callback)
+{
+    auto& impl = Impl::get(this);
+
+    impl.setBusy();
+
+    indexReaders.fetch_add(1, std::memory_order_relaxed);
+
+    async(
+        [start, end, callback = std::move(callback), parentBufferId, &context, &impl]
+        {
+            auto parentBuffer = getBuffer(parentBufferId, context);
+
+            if (not parentBuffer) [[unlikely]]
+            {
+                indexReaders.fetch_sub(1, std::memory_order_release);
+                impl.setAborted();
+                callback(std::unexpected(BufferError::aborted("Parent buffer has been closed")));
+                return;
+            }
+
+            impl.copyFromParent(*parentBuffer);
+
+            auto timer = utils::startTimeMeasurement();
+
+            impl.filter(start, end, *parentBuffer);
+
+            indexReaders.fetch_sub(1, std::memory_order_release);
+
+            impl.setIdle();
+            callback(timer.elapsed());
+        });
+}
+
+void Buffer::combine(SetOperation operation, BufferId firstBufferId, BufferId secondBufferId, Context& context, FinishedCallback callback)
+{
+    assert(isMainThread(), "combine called not on main thread");
+
+    auto& impl = Impl::get(this);
+
+    impl.setBusy();
+
+    async(
+        [operation, firstBufferId, secondBufferId, callback = std::move(callback), &context, &impl]
+        {
+            auto first = getBuffer(firstBufferId, context);
+            auto second = getBuffer(secondBufferId, context);
+
+            if (not first or not second) [[unlikely]]
+            {
+                impl.setAborted();
+                callback(std::unexpected(BufferError::aborted("Parent buffer has been closed")));
+                return;
+            }
+
+            assert(first->isFiltered() and second->isFiltered(), "combine called with not filtered buffers");
+            assert(first->sharesLinesWith(*second), "combine called with buffers of different files");
+
+            auto timer = utils::startTimeMeasurement();
+
+            impl.copyFromParent(*first);
+            impl.combine(operation, *first, *second);
+
+            impl.setIdle();
+            callback(timer.elapsed());
+        });
+}
+
+StringViewOrError Buffer::readLine(size_t i)
+{
+    auto& impl = Impl::get(this);
+    auto lineIndex = i;
+
+    if (mType == cast(BufferType::filtered))
+    {
+        lineIndex = (*mFilteredLines)[lineIndex];
+
+        // Followed parent file might have been truncated since filtering
+        if (lineIndex >= impl.baseLineCount()) [[unlikely]]
+        {
+            return "";
+        }
+    }
+
+    const auto [line, source] = impl.locate(lineIndex);
+
+    if (line.len == 0)
+    {
         return "";
     }
 
-    auto result = Impl::get(this).readInternal(line);
+    auto result = impl.readInternal(line, impl.sourceFile(source));
+
+    if (not result) [[unlikely]]
+    {
+        return std::unexpected(std::move(result.error()));
+    }
+
+    return *result;
+}
+
+void Buffer::search(SearchRequest req, FinishedSearchCallback callback)
+{
+    auto& impl = Impl::get(this);
+
+    impl.stopSearch();
+
+    mSearching = true;
+
+    indexReaders.fetch_add(1, std::memory_order_relaxed);
+
+    async(
+        [callback = std::move(callback), req = std::move(req), &impl]
+        {
+            auto files = impl.copyFiles();
+
+            // Backward search reads lines in reverse, for which kernel
+            // readahead doesn't help
+            for (auto& file : files)
+            {
+                file.setAccessPattern(req.direction == SearchDirection::forward
+                    ? sys::AccessPattern::sequential
+                    : sys::AccessPattern::normal);
+            }
+
+            auto timer = utils::startTimeMeasurement();
+            auto result = impl.search(req, files);
+            indexReaders.fetch_sub(1, std::memory_order_release);
+            impl.notifyChange([&impl]{ impl.mSearching = false; });
+            callback(result, timer.elapsed());
+        });
+}
+
+size_t Buffer::findClosestLine(size_t absoluteLineNumber)
+{
+    switch (mType)
+    {
+        case cast(BufferType::uninitialized):
+        case cast(BufferType::base):
+        case cast(BufferType::merged):
+            return absoluteLineNumber;
+        case cast(BufferType::filtered):
+            for (size_t i = 0; i < mFilteredLines->size(); ++i)
+            {
+                if (absoluteLineNumber <= (*mFilteredLines)[i])
+                {
+                    return i;
+                }
+            }
+            return mFilteredLines->size() - 1;
+    }
+    return 0;
+}
+
+bool Buffer::hasTimestamps() const
+{
+    if (mMerge)
+    {
+        for (const auto& source : mMerge->sources)
+        {
+            if (not source.timestamps.empty())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    return mFileTimestamps and not mFileTimestamps->empty();
+}
+
+utils::Maybe<Timestamp> Buffer::lineTimestamp(size_t lineIndex) const
+{
+    const auto timestamp = Impl::get(this).timestampOf(absoluteLineNumber(lineIndex));
+
+    if (timestamp == NO_TIMESTAMP)
+    {
+        return {};
+    }
+
+    return timestamp;
+}
+
+size_t Buffer::findTimestamp(Timestamp timestamp) const
+{
+    const auto& impl = Impl::get(this);
+
+    if (mType == cast(BufferType::base))
+    {
+        return utils::min(mFileTimestamps->lowerBound(timestamp), mLineCount);
+    }
+
+    // Lines of filtered buffer are in the order of file, and lines of merge
+    // are ordered by time
+    size_t first = 0;
+    size_t last = mLineCount;
+
+    while (first < last)
+    {
+        const auto middle = first + (last - first) / 2;
+
+        if (impl.timestampOf(absoluteLineNumber(middle)) < timestamp)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+
+    return first;
+}
+
+size_t Buffer::absoluteLineNumber(size_t lineIndex) const
+{
+    switch (mType)
+    {
+        case cast(BufferType::filtered):
+            return (*mFilteredLines)[lineIndex];
+        default:
+            return lineIndex;
+    }
+}
+
+size_t Buffer::sourceCount() const
+{
+    return mMerge ? mMerge->sources.size() : 1;
+}
+
+size_t Buffer::lineSource(size_t lineIndex) const
+{
+    return mMerge
+        ? mMerge->refs[absoluteLineNumber(lineIndex)] >> Merge::SOURCE_SHIFT
+        : 0;
+}
+
+const std::string& Buffer::sourceName(size_t source) const
+{
+    return mMerge ? mMerge->sources[source].name : mFile.path();
+}
+
+const std::string& Buffer::grepPrefilter() const
+{
+    return mGrepPrefilter;
+}
+
+bool Buffer::isGrepCached() const
+{
+    return mGrepCached;
+}
+
+const std::string& Buffer::filePath() const
+{
+    assert(mType != cast(BufferType::uninitialized), utils::format("Buffer {} type is uninitialized", this));
+    return mMerge ? mMerge->name : mFile.path();
+}
+
+size_t Buffer::fileSize() const
+{
+    assert(mType != cast(BufferType::uninitialized), utils::format("Buffer {} type is uninitialized", this));
+    return mFileSize;
+}
+
+bool Buffer::isBase() const
+{
+    return mType == cast(BufferType::base);
+}
+
+bool Buffer::isFiltered() const
+{
+    return mType == cast(BufferType::filtered);
+}
+
+bool Buffer::sharesLinesWith(const Buffer& other) const
+{
+    return mFileLines == other.mFileLines and mMerge == other.mMerge;
+}
+
+bool Buffer::isLoading() const
+{
+    return mState == cast(State::loading);
+}
+
+bool Buffer::isSearchable() const
+{
+    return mState != cast(State::loading) or mType == cast(BufferType::filtered);
+}
+
+bool Buffer::isCounting() const
+{
+    return mCounting;
+}
+
+bool Buffer::isCompressed() const
+{
+    return mFile.isCompressed();
+}
+
+bool Buffer::isFollowing() const
+{
+    return mFollowState == cast(FollowState::running);
+}
+
+float Buffer::firstChunkTime() const
+{
+    return mFirstChunkTime;
+}
+
+const Progress& Buffer::progress() const
+{
+    return mProgress;
+}
+
+size_t Buffer::indexMemoryUsage() const
+{
+    switch (mType)
+    {
+        case cast(BufferType::filtered):
+            return mFilteredLines->memoryUsage() + mBitmap->memoryUsage();
+        case cast(BufferType::merged):
+        {
+            auto total = mMerge->refs.memoryUsage();
+            for (const auto& source : mMerge->sources)
+            {
+                total += source.lines.memoryUsage() + source.timestamps.memoryUsage();
+            }
+            return total;
+        }
+        default:
+            return mFileLines->memoryUsage() + mFileTimestamps->memoryUsage();
+    }
+}
+
+size_t Buffer::fileLineCount() const
+{
+    return mMerge ? mMerge->refs.size() : mFileLines->size();
+}
+
+void Buffer::Impl::logProgress(const char* operation, const char* unit)
+{
+    const auto summary = mProgress.summary();
+
+    // Shows skew between threads, e.g. caused by uneven split of work
+    for (size_t i = 0; i < summary.size(); ++i)
+    {
+        const auto& thread = summary[i];
+        const auto throughput = thread.time > 0 ? static_cast<float>(thread.bytes) / MiB / thread.time : 0;
+
+        auto message = logger.info();
+
+        message << filePath() << ": " << operation << " thread " << i << ": ";
+
+        if (unit)
+        {
+            message << thread.units << ' ' << unit << ", ";
+        }
+
+        message << (static_cast<float>(thread.bytes) / MiB | utils::precision(1)) << " MiB in "
+            << (thread.time | utils::precision(3)) << " s busy (" << (throughput | utils::precision(1)) << " MiB/s)";
+    }
+
+    if (summary.size() > 1)
+    {
+        const auto [shortest, longest] = std::ranges::minmax(summary, {}, &Progress::ThreadSummary::time);
+
+        logger.info() << filePath() << ": " << operation << " threads busy from " << (shortest.time | utils::precision(3))
+            << " to " << (longest.time | utils::precision(3)) << " s";
+    }
+}
+
+Files Buffer::Impl::copyFiles() const
+{
+    if (not mMerge)
+    {
+        return Files{mFile};
+    }
+
+    Files files;
+
+    files.reserve(mMerge->sources.size());
+
+    for (const auto& source : mMerge->sources)
+    {
+        files.push_back(source.file);
+    }
+
+    return files;
+}
+
+void Buffer::Impl::copyFromParent(Buffer& parentBuffer)
+{
+    // Merged buffer has no file of its own, only files of the merge
+    if (not parentBuffer.mMerge)
+    {
+        mFile = parentBuffer.mFile;
+    }
+
+    mFileSize = parentBuffer.mFileSize;
+    mFileLines = parentBuffer.mFileLines;
+    mFileTimestamps = parentBuffer.mFileTimestamps;
+    mMerge = parentBuffer.mMerge;
+}
+
+void Buffer::Impl::initialize(Lines&& lines)
+{
+    mLineCount = lines.size();
+    utils::constructAt(&mOwnLines, std::move(lines));
+    mFileLines = &mOwnLines;
+    mFileTimestamps = &mOwnTimestamps;
+    setType(BufferType::base);
+}
+
+void Buffer::Impl::initialize(LineRefs&& lines, utils::RoaringBitmap&& bitmap)
+{
+    initialize(utils::makeShared<LineRefs>(std::move(lines)), utils::makeShared<utils::RoaringBitmap>(std::move(bitmap)));
+}
+
+void Buffer::Impl::initialize(LineRefsPtr lines, LineBitmapPtr bitmap)
+{
+    mLineCount = lines->size();
+    utils::constructAt(&mFilteredLines, std::move(lines));
+    mBitmap = std::move(bitmap);
+    setType(BufferType::filtered);
+}
+
+void Buffer::Impl::initialize(MergePtr merge)
+{
+    mLineCount = merge->refs.size();
+    utils::constructAt(&mOwnMerge, std::move(merge));
+    mMerge = mOwnMerge.get();
+    setType(BufferType::merged);
+}
+
+Result Buffer::Impl::loadFile(File& file, Context& context, const LoadProgressCallback& progressCallback, const Lines& index)
+{
+    if (file.isCompressed())
+    {
+        return loadCompressedFile(file, progressCallback, context);
+    }
+
+    file.setAccessPattern(sys::AccessPattern::sequential, context.config.prefetch);
+
+    if (file.backend() == FileBackend::read)
+    {
+        logger.info() << file.path() << ": reading without mapping";
+    }
+
+    const auto fileSize = file.size();
+    const auto format = timestampFormat(file, context);
+
+    // Cache keeps only line starts, so timestamps would have to be read from
+    // the whole file anyway
+    const bool useCache = context.config.indexCache
+        and fileSize >= context.config.indexCacheMinSize
+        and format == TimestampFormat::none;
+
+    // Followed file is indexed further in the same format
+    if (not mMerge)
+    {
+        mTimestampFormat = format;
+    }
+
+    Publisher publisher(progressCallback);
+    Lines lines;
+    Timestamps timestamps;
+    size_t start = 0;
+
+    if (useCache)
+    {
+        // Segments are published as they're verified, like chunks of a scan
+        const auto append =
+            [&](LineIndex&& segment)
+            {
+                lines.append(std::move(segment));
+                publisher.publish(lines, timestamps);
+            };
+
+        const IndexCacheOutput output(append);
+
+        start = indexCacheLoad(file, mStopFlag, output);
+    }
+
+    if (start == 0)
+    {
+        lines.append(0);
+
+        if (auto result = readTimestamp(file, 0, timestamps, format); not result) [[unlikely]]
+        {
+            return result;
+        }
+    }
+
+    if (start == fileSize)
+    {
+        publisher.finish(lines, timestamps, fileSize);
+        return true;
+    }
+
+    // Merge counts all of its files together
+    if (not mMerge)
+    {
+        mProgress.setTotal(fileSize - start);
+    }
+
+    bool runMultiThreaded = fileSize - start > chunkSize(context.config.bytesPerThread, MIN_LOAD_CHUNK_SIZE)
+        and context.config.maxThreads > 1;
+
+    auto result = runMultiThreaded
+        ? multiThreadedReadLines(file, start, lines, timestamps, format, publisher, context)
+        : readLines(file, start, fileSize, lines, timestamps, format, &publisher, &mProgress.counter(0));
+
+    if (not runMultiThreaded)
+    {
+        mProgress.finish(0);
+    }
+
+    if (not result)
+    {
+        return result;
+    }
+
+    publisher.finish(lines, timestamps, fileSize);
+
+    if (useCache)
+    {
+        // Whole index is only in the buffer, so it can be stored once all
+        // chunks have been applied; it's not modified later while loading
+        if (result = waitForChunks(publisher.count()); not result) [[unlikely]]
+        {
+            return result;
+        }
+
+        indexCacheStore(file, index, context.config.indexCacheSize);
+    }
+
+    return true;
+}
+
+Result Buffer::Impl::loadCompressedFile(File& file, const LoadProgressCallback& progressCallback, Context& context)
+{
+    auto timer = utils::startTimeMeasurement();
+
+    Publisher publisher(progressCallback);
+    Lines lines;
+    Timestamps timestamps;
+
+    // Decompressed data which hasn't been indexed yet, starting at offset
+    std::string pending;
+    size_t offset = 0;
+
+    // Format is known once enough data for detecting it has been seen
+    utils::Maybe<TimestampFormat> format;
+
+    std::vector<uint32_t> positions(NEWLINE_SCAN_WINDOW);
+
+    lines.append(0);
+
+    const auto scan =
+        [&](bool last)
+        {
+            if (not format)
+            {
+                if (not last and pending.size() < TIMESTAMP_DETECTION_LEN)
+                {
+                    return;
+                }
+
+                format = timestampFormat(file.path(), std::string_view(pending).substr(0, TIMESTAMP_DETECTION_LEN), context);
+
+                if (*format != TimestampFormat::none and not pending.empty())
+                {
+                    timestamps.append(parseTimestamp(std::string_view(pending).substr(0, MAX_TIMESTAMP_LENGTH), *format).value_or(NO_TIMESTAMP));
+                }
+            }
+
+            // Timestamp of line starting close to the end is parsed once the
+            // data following it has come
+            const auto keep = last or *format == TimestampFormat::none ? 0 : MAX_TIMESTAMP_LENGTH;
+
+            if (pending.size() <= keep)
+            {
+                return;
+            }
+
+            const auto len = pending.size() - keep;
+
+            for (size_t windowStart = 0; windowStart < len; windowStart += NEWLINE_SCAN_WINDOW)
+            {
+                const auto count = findNewlines(pending.data() + windowStart, utils::min(len - windowStart, NEWLINE_SCAN_WINDOW), positions.data());
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const auto lineOffset = windowStart + positions[i] + 1;
+
+                    lines.append(offset + lineOffset);
+
+                    // Newline at the end of file doesn't start a line
+                    if (*format != TimestampFormat::none and lineOffset < pending.size())
+                    {
+                        const auto timestampLen = utils::min(pending.size() - lineOffset, MAX_TIMESTAMP_LENGTH);
+                        timestamps.append(parseTimestamp(std::string_view(pending.data() + lineOffset, timestampLen), *format).value_or(NO_TIMESTAMP));
+                    }
+                }
+            }
+
+            pending.erase(0, len);
+            offset += len;
+        };
+
+    auto& counter = mProgress.counter(0);
+
+    const auto consume =
+        [&](std::string_view data)
+        {
+            pending.append(data);
+            counter.add(data.size(), data.size());
+
+            if (pending.size() >= NEWLINE_SCAN_WINDOW + MAX_TIMESTAMP_LENGTH)
+            {
+                scan(false);
+            }
+        };
+
+    const utils::FunctionRef<void(std::string_view)> output(consume);
+
+    auto result = file.buildCompressionIndex(mStopFlag, &output);
+
+    mProgress.finish(0);
 
     if (not result) [[unlikely]]
     {
-        return std::unexpected(std::move(result.error()));
+        return std::unexpected(mStopFlag
+            ? BufferError::aborted("Loading was aborted")
+            : BufferError::systemError(std::move(result.error())));
+    }
+
+    scan(true);
+
+    // Followed file is indexed further in the same format
+    if (not mMerge)
+    {
+        mTimestampFormat = *format;
+    }
+
+    logger.info() << file.path() << ": decompressed and indexed " << file.size() << " B in "
+        << (timer.elapsed() | utils::precision(3)) << " s";
+
+    // Lines can be read only once the compression index is complete, so
+    // they are published all at once
+    publisher.finish(lines, timestamps, file.size());
+
+    return true;
+}
+
+TimestampFormat Buffer::Impl::timestampFormat(File& file, Context& context)
+{
+    const auto len = utils::min(file.size(), TIMESTAMP_DETECTION_LEN);
+
+    if (len == 0)
+    {
+        return timestampFormat(file.path(), {}, context);
+    }
+
+    if (auto result = file.remap(0, len); not result) [[unlikely]]
+    {
+        logger.warning() << file.path() << ": " << result.error();
+        return TimestampFormat::none;
+    }
+
+    return timestampFormat(file.path(), std::string_view(file.at(0), len), context);
+}
+
+TimestampFormat Buffer::Impl::timestampFormat(const std::string& path, std::string_view head, Context& context)
+{
+    const auto name = context.config.timestampFormat.get();
+    const auto format = parseTimestampFormat(name);
+
+    if (not format) [[unlikely]]
+    {
+        logger.warning() << "unknown timestamp format: " << name;
+        return TimestampFormat::none;
+    }
+
+    if (*format != TimestampFormat::automatic or head.empty())
+    {
+        return *format;
+    }
+
+    const auto detected = detectTimestampFormat(head);
+
+    logger.info() << path << ": timestamp format: " << timestampFormatName(detected);
+
+    return detected;
+}
+
+Result Buffer::Impl::readTimestamp(File& file, size_t start, Timestamps& timestamps, TimestampFormat format)
+{
+    if (format == TimestampFormat::none or start >= file.size())
+    {
+        return true;
+    }
+
+    const auto len = utils::min(file.size() - start, MAX_TIMESTAMP_LENGTH);
+
+    if (auto result = file.remap(start, len); not result) [[unlikely]]
+    {
+        return std::unexpected(BufferError::systemError(std::move(result.error())));
+    }
+
+    timestamps.append(parseTimestamp(std::string_view(file.at(start), len), format).value_or(NO_TIMESTAMP));
+
+    return true;
+}
+
+Result Buffer::Impl::waitForChunks(unsigned count)
+{
+    std::unique_lock lock(mStateLock);
+
+    // Chunks are never applied if the app is quitting, so buffer being
+    // destroyed stops the wait
+    mStateChanged.wait(lock, [this, count]{ return mAppliedChunks.load(std::memory_order_acquire) == count or mStopFlag; });
+
+    if (mAppliedChunks.load(std::memory_order_acquire) != count) [[unlikely]]
+    {
+        return std::unexpected(BufferError::aborted("Loading was aborted"));
+    }
+
+    return true;
+}
+
+static bool endsWithNewline(File& file, size_t size)
+{
+    if (auto result = file.remap(size - 1, 1); not result) [[unlikely]]
+    {
+        return false;
+    }
+    return *file.at(size - 1) == '\n';
+}
+
+void Buffer::Impl::followFile(std::string path, FileBackend backend, sys::FileIdentity identity, size_t size, const FollowCallback& callback)
+{
+    // File is opened again, so that nothing is shared with the main thread
+    File file;
+
+    if (auto result = file.open(std::move(path), backend); not result) [[unlikely]]
+    {
+        logger.warning() << result.error();
+        return;
+    }
+
+    file.setAccessPattern(sys::AccessPattern::sequential);
+
+    // Set if file was truncated or replaced, so it has to be indexed again
+    bool reindex = not isSameFile(file.identity(), identity);
+
+    sys::FileWatch watch{.fd = -1, .wd = -1};
+
+    // Without notifications file is just checked every FOLLOW_INTERVAL_MS
+    const auto startWatching =
+        [&watch](const std::string& watchedPath)
+        {
+            if (auto result = sys::fileWatch(watchedPath); result) [[likely]]
+            {
+                watch = *result;
+            }
+            else
+            {
+                logger.warning() << watchedPath << ": cannot watch: " << sys::errorDescribe(result.error());
+            }
+        };
+
+    startWatching(file.path());
+
+    logger.info() << file.path() << ": following from " << size << " B";
+
+    while (mFollowState == cast(FollowState::running))
+    {
+        sys::fileWatchWait(watch, FOLLOW_INTERVAL_MS);
+
+        if (auto result = file.refresh(); not result) [[unlikely]]
+        {
+            logger.warning() << result.error();
+            continue;
+        }
+
+        if (not reindex and file.size() < size)
+        {
+            logger.info() << file.path() << ": truncated";
+            reindex = true;
+        }
+        else if (not reindex and file.size() == size)
+        {
+            // Path is checked only when the old file stopped growing, so
+            // that everything written to it before rotation is shown
+            auto pathIdentity = sys::fileIdentity(file.path());
+
+            if (pathIdentity and not isSameFile(*pathIdentity, file.identity()))
+            {
+                File newFile;
+
+                if (auto result = newFile.open(file.path(), backend); not result) [[unlikely]]
+                {
+                    logger.warning() << result.error();
+                    continue;
+                }
+
+                logger.info() << file.path() << ": replaced";
+
+                file = newFile;
+                reindex = true;
+
+                sys::fileUnwatch(watch);
+                startWatching(file.path());
+            }
+        }
+
+        FollowUpdate update{
+            .type = reindex ? FollowUpdate::Type::replaced : FollowUpdate::Type::grown,
+            .lines = {},
+            .fileSize = file.size(),
+            .identity = file.identity(),
+        };
+
+        if (not reindex and file.size() == size)
+        {
+            // Deferred update is applied only with the next one
+            if (mFollowDeferred)
+            {
+                callback(std::move(update));
+            }
+            continue;
+        }
+
+        const auto start = reindex ? 0 : size;
+
+        if (reindex)
+        {
+            update.lines.append(0);
+        }
+
+        // Line which was being written has its timestamp already; the one
+        // following the last newline is new
+        if (start == 0 or endsWithNewline(file, start))
+        {
+            if (auto result = readTimestamp(file, start, update.timestamps, mTimestampFormat); not result) [[unlikely]]
+            {
+                logger.warning() << file.path() << ": " << result.error();
+                continue;
+            }
+        }
+
+        if (auto result = readLines(file, start, file.size(), update.lines, update.timestamps, mTimestampFormat); not result) [[unlikely]]
+        {
+            if (mFollowState == cast(FollowState::running))
+            {
+                logger.warning() << file.path() << ": " << result.error();
+            }
+            continue;
+        }
+
+        reindex = false;
+        size = update.fileSize;
+
+        callback(std::move(update));
     }
 
-    return *result;
+    sys::fileUnwatch(watch);
+
+    logger.info() << file.path() << ": stopped following";
 }
 
-void Buffer::search(SearchRequest req, FinishedSearchCallback callback)
+Result Buffer::Impl::mergeFiles(Context& context)
 {
-    auto& impl = Impl::get(this);
+    auto& sources = mMerge->sources;
 
-    impl.stop();
-    impl.setBusy();
+    const auto totalSize =
+        [&sources]
+        {
+            size_t size = 0;
+            for (const auto& source : sources)
+            {
+                size += source.file.size();
+            }
+            return size;
+        };
 
-    async(
-        [callback = std::move(callback), req = std::move(req), &impl]
+    // Files are read twice: to be indexed, and then to be merged
+    mProgress.setTotal(2 * totalSize());
+
+    for (auto& source : sources)
+    {
+        // Nothing is shown until merge is done, so chunks are applied right
+        // away by the worker
+        const LoadProgressCallback applyChunk =
+            [&source, this](LoadProgress progress)
+            {
+                source.lines.append(std::move(progress.lines));
+                source.timestamps.append(std::move(progress.timestamps));
+                notifyChange([this]{ mAppliedChunks.fetch_add(1, std::memory_order_release); });
+            };
+
+        auto file = source.file;
+
+        mAppliedChunks = 0;
+
+        if (auto result = loadFile(file, context, applyChunk, source.lines); not result) [[unlikely]]
         {
-            auto file = impl.mFile;
-            auto timer = utils::startTimeMeasurement();
-            auto result = impl.search(req, file);
-            impl.setIdle();
-            callback(result, timer.elapsed());
-        });
+            return result;
+        }
+
+        source.lines.shrinkToFit();
+        source.timestamps.shrinkToFit();
+    }
+
+    // Size of compressed file is known only after it was decompressed
+    mFileSize = totalSize();
+    mProgress.setTotal(2 * mFileSize);
+
+    return mergeSources(context);
 }
 
-size_t Buffer::findClosestLine(size_t absoluteLineNumber)
+Result Buffer::Impl::mergeSources(Context& context)
 {
-    switch (mType)
+    const auto sourceCount = mMerge->sources.size();
+
+    size_t lineCount = 0;
+
+    for (const auto& source : mMerge->sources)
     {
-        case cast(BufferType::uninitialized):
-        case cast(BufferType::base):
-            return absoluteLineNumber;
-        case cast(BufferType::filtered):
-            for (size_t i = 0; i < mFilteredLines.size(); ++i)
+        lineCount += source.lines.size();
+    }
+
+    const size_t maxThreads = context.config.maxThreads;
+    const size_t linesPerThread = context.config.linesPerThread;
+
+    const auto threadCount = utils::max(
+        utils::min((lineCount + linesPerThread - 1) / linesPerThread, maxThreads),
+        size_t(1));
+
+    auto files = copyFiles();
+
+    // Merge is split between threads by timestamps, so each thread merges
+    // lines from all files which fall in its range of time; they are found
+    // with binary search, as each file is more or less sorted by time
+    std::vector<std::vector<size_t>> bounds(threadCount + 1, std::vector<size_t>(sourceCount, 0));
+
+    for (size_t s = 0; s < sourceCount; ++s)
+    {
+        bounds[threadCount][s] = mMerge->sources[s].lines.size();
+    }
+
+    if (threadCount > 1)
+    {
+        const auto pivots = mergePivots(files, threadCount);
+
+        for (size_t i = 1; i < threadCount; ++i)
+        {
+            for (size_t s = 0; s < sourceCount; ++s)
             {
-                if (absoluteLineNumber <= mFilteredLines[i])
-                {
-                    return i;
-                }
+                // File which isn't sorted could give bounds out of order
+                bounds[i][s] = utils::max(
+                    findFirstLineAfter(s, files[s], pivots[i - 1]),
+                    bounds[i - 1][s]);
             }
-            return mFilteredLines.size() - 1;
+        }
     }
-    return 0;
-}
 
-size_t Buffer::absoluteLineNumber(size_t lineIndex) const
-{
-    switch (mType)
+    logger.info() << "merging " << lineCount << " lines using " << threadCount << " threads";
+
+    Tasks tasks(threadCount);
+    Results results(threadCount);
+    std::vector<LineRefs> refsPerThread(threadCount);
+
+    for (auto& file : files)
     {
-        case cast(BufferType::filtered):
-            return mFilteredLines[lineIndex];
-        default:
-            return lineIndex;
+        file.setAccessPattern(sys::AccessPattern::sequential, context.config.prefetch);
     }
-}
 
-const std::string& Buffer::filePath() const
-{
-    assert(mType != cast(BufferType::uninitialized), utils::format("Buffer {} type is uninitialized", this));
-    return mFile.path();
-}
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        tasks[i] =
+            [i, &bounds, &refsPerThread, &results, threadFiles = files, this] mutable
+            {
+                results[i] = mergeRange(
+                    threadFiles,
+                    bounds[i],
+                    bounds[i + 1],
+                    refsPerThread[i],
+                    mProgress.counter(i));
+
+                mProgress.finish(i);
+            };
+    }
 
-void Buffer::Impl::copyFromParent(Buffer& parentBuffer)
-{
-    mFile = parentBuffer.mFile;
-    mFileLines = parentBuffer.mFileLines;
-}
+    executeInParallelAndWait(std::move(tasks));
 
-void Buffer::Impl::initialize(Lines&& lines)
-{
-    mLineCount = lines.size();
-    utils::constructAt(&mOwnLines, std::move(lines));
-    mFileLines = &mOwnLines;
-    setType(BufferType::base);
-}
+    for (auto& result : results)
+    {
+        if (not result) [[unlikely]]
+        {
+            return result;
+        }
+    }
 
-void Buffer::Impl::initialize(LineRefs&& lines)
-{
-    mLineCount = lines.size();
-    utils::constructAt(&mFilteredLines, std::move(lines));
-    setType(BufferType::filtered);
+    auto& refs = mMerge->refs;
+
+    for (auto& threadRefs : refsPerThread)
+    {
+        refs.append(std::move(threadRefs));
+    }
+
+    refs.shrinkToFit();
+
+    mLineCount = refs.size();
+
+    return true;
 }
 
-Result Buffer::Impl::singleThreadedLoadFile()
+Result Buffer::Impl::mergeRange(
+    Files& files,
+    const std::vector<size_t>& begin,
+    const std::vector<size_t>& end,
+    LineRefs& refs,
+    Progress::Counter& counter)
 {
-    Lines lines;
+    struct Cursor
+    {
+        size_t    line;
+        Timestamp timestamp;
+    };
 
-    auto result = readLines(mFile, 0, mFile.size(), lines);
+    const auto sourceCount = files.size();
 
-    if (not result)
+    std::vector<Cursor> cursors(sourceCount);
+
+    for (size_t s = 0; s < sourceCount; ++s)
     {
-        return result;
+        cursors[s] = Cursor{
+            .line = begin[s],
+            .timestamp = begin[s] < end[s] ? timestampAt(s, files[s], begin[s]) : 0,
+        };
     }
 
-    const auto nextLineStart = lines.empty()
-        ? 0
-        : lines.back().start + lines.back().len + 1;
-
-    if (nextLineStart < mFile.size()) [[unlikely]]
+    while (true)
     {
-        lines.emplace_back(Line{.start = nextLineStart, .len = mFile.size() - nextLineStart});
-    }
+        if (mStopFlag) [[unlikely]]
+        {
+            return std::unexpected(BufferError::aborted("Merging was aborted"));
+        }
+
+        // There are only a few files, so the one with the earliest line is
+        // simply looked for; on equal timestamps files keep their order
+        size_t next = sourceCount;
+
+        for (size_t s = 0; s < sourceCount; ++s)
+        {
+            if (cursors[s].line < end[s] and (next == sourceCount or cursors[s].timestamp < cursors[next].timestamp))
+            {
+                next = s;
+            }
+        }
+
+        if (next == sourceCount)
+        {
+            break;
+        }
+
+        auto& cursor = cursors[next];
+
+        refs.pushBack((next << Merge::SOURCE_SHIFT) | cursor.line);
+
+        if (++cursor.line == end[next])
+        {
+            continue;
+        }
+
+        const auto& source = mMerge->sources[next];
+        const auto line = source.lines[cursor.line];
 
-    initialize(std::move(lines));
+        counter.add(line.len + 1, line.len + 1);
+
+        // Indexed timestamps make reading lines unnecessary
+        if (not source.timestamps.empty())
+        {
+            cursor.timestamp = source.timestamps[cursor.line];
+            continue;
+        }
+
+        auto result = readInternal(line, files[next]);
+
+        if (not result) [[unlikely]]
+        {
+            return std::unexpected(std::move(result.error()));
+        }
+
+        // Line without timestamp stays with the preceding one
+        if (const auto timestamp = parseTimestamp(*result))
+        {
+            cursor.timestamp = *timestamp;
+        }
+    }
 
     return true;
 }
 
-Result Buffer::Impl::multiThreadedLoadFile(Context& context)
+std::vector<Timestamp> Buffer::Impl::mergePivots(Files& files, size_t threadCount)
 {
-    const auto fileSize = mFile.size();
-    const auto maxThreads = context.config.maxThreads.get();
-    const auto bytesPerThread = context.config.bytesPerThread.get();
+    size_t lineCount = 0;
 
-    const auto threadCount = utils::min(
-        (fileSize + bytesPerThread - 1) / bytesPerThread,
-        size_t(maxThreads));
+    for (const auto& source : mMerge->sources)
+    {
+        lineCount += source.lines.size();
+    }
 
-    logger.info() << "using " << threadCount << " threads";
+    // Lines are sampled with the same step in all files, so that each file
+    // has share of samples proportional to its size
+    const auto step = utils::max(lineCount / (threadCount * MERGE_SAMPLES_PER_THREAD), size_t(1));
 
-    Tasks tasks(threadCount);
-    Results results(threadCount);
-    std::vector<Lines> linesPerThread(threadCount);
+    std::vector<Timestamp> samples;
 
-    for (size_t i = 0; i < threadCount; ++i)
+    for (size_t s = 0; s < files.size(); ++s)
     {
-        const auto start = (fileSize / threadCount) * i;
-        const auto end = i == threadCount - 1
-            ? fileSize
-            : (fileSize / threadCount) * (i + 1);
+        const auto sourceLineCount = mMerge->sources[s].lines.size();
 
-        auto& threadLines = linesPerThread[i];
-        auto& threadResult = results[i];
+        for (size_t i = step / 2; i < sourceLineCount; i += step)
+        {
+            samples.push_back(timestampAt(s, files[s], i));
+        }
+    }
 
-        tasks[i] =
-            [start, end, &threadLines, &threadResult, threadFile = mFile, this] mutable
-            {
-                threadResult = readLines(
-                    threadFile,
-                    start,
-                    end,
-                    threadLines);
-            };
+    std::sort(samples.begin(), samples.end());
+
+    std::vector<Timestamp> pivots(threadCount - 1, std::numeric_limits<Timestamp>::max());
+
+    for (size_t i = 1; i < threadCount and not samples.empty(); ++i)
+    {
+        pivots[i - 1] = samples[i * samples.size() / threadCount];
     }
 
-    executeInParallelAndWait(std::move(tasks));
+    return pivots;
+}
 
-    Result result(true);
-    size_t lineCount = threadCount;
+size_t Buffer::Impl::findFirstLineAfter(size_t source, File& file, Timestamp timestamp)
+{
+    size_t first = 0;
+    size_t last = mMerge->sources[source].lines.size();
 
-    for (size_t i = 0; i < threadCount; ++i)
+    while (first < last)
     {
-        if (not results[i]) [[unlikely]]
+        const auto middle = first + (last - first) / 2;
+
+        if (timestampAt(source, file, middle) < timestamp)
         {
-            result = std::move(results[i]);
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
         }
-        lineCount += linesPerThread[i].size();
     }
 
-    if (not result)
+    return first;
+}
+
+Timestamp Buffer::Impl::timestampAt(size_t source, File& file, size_t lineIndex)
+{
+    const auto& lines = mMerge->sources[source].lines;
+    const auto& timestamps = mMerge->sources[source].timestamps;
+
+    if (not timestamps.empty())
     {
-        return result;
+        return timestamps[lineIndex];
     }
 
-    Lines lines(std::move(linesPerThread[0]));
-    lines.reserve(lineCount);
+    const auto first = lineIndex > MAX_CONTINUATION_LINES ? lineIndex - MAX_CONTINUATION_LINES : 0;
 
-    for (size_t i = 1; i < threadCount; ++i)
+    for (auto i = lineIndex + 1; i-- > first;)
     {
-        if (i < threadCount - 1 and not lines.empty())
+        auto result = readInternal(lines[i], file);
+
+        if (not result) [[unlikely]]
+        {
+            break;
+        }
+
+        if (const auto timestamp = parseTimestamp(*result))
+        {
+            return *timestamp;
+        }
+    }
+
+    // Lines before the first timestamp are merged first
+    return std::numeric_limits<Timestamp>::min();
+}
+
+Result Buffer::Impl::multiThreadedReadLines(
+    File& file,
+    size_t start,
+    Lines& lines,
+    Timestamps& timestamps,
+    TimestampFormat format,
+    Publisher& publisher,
+    Context& context)
+{
+    const auto fileSize = file.size();
+
+    ChunkQueue chunks(start, fileSize, chunkSize(context.config.bytesPerThread, MIN_LOAD_CHUNK_SIZE));
+
+    const auto threadCount = chunks.threadCount(context.config.maxThreads);
+
+    logger.info() << "using " << threadCount << " threads, " << chunks.count() << " chunks; newline scanner: " << newlineScannerName();
+
+    Tasks tasks(threadCount);
+    Results results(threadCount);
+    std::vector<Lines> linesPerChunk(chunks.count());
+    std::vector<Timestamps> timestampsPerChunk(chunks.count());
+    std::vector<bool> finished(chunks.count(), false);
+    std::mutex publishLock;
+    size_t published = 0;
+
+    // Each chunk has indexed only starts of lines following newlines in its
+    // range, so they can be simply published one after another and joined
+    // without copying by applyLoadProgress. A chunk is published as soon as
+    // all preceding ones are, so the following ones show up while loading;
+    // the last one is left for Publisher::finish. Lines in the beginning of
+    // chunk, which have no timestamp, take the last one of the preceding
+    // chunk when joined
+    const auto finishChunk =
+        [&](size_t index)
         {
-            auto& prevLine = lines.back();
-            auto& nextLine = linesPerThread[i].front();
+            std::lock_guard lock(publishLock);
 
-            if (prevLine.start + prevLine.len + 1 < nextLine.start)
+            finished[index] = true;
+
+            for (; published < chunks.count() and finished[published]; ++published)
             {
-                const auto diff = nextLine.start - (prevLine.start + prevLine.len + 1);
-                nextLine.start -= diff;
-                nextLine.len += diff;
+                // The first chunk has been publishing its lines on its own
+                if (published == 0)
+                {
+                    continue;
+                }
+
+                publisher.publish(lines, timestamps, true);
+                lines = std::move(linesPerChunk[published]);
+                timestamps = std::move(timestampsPerChunk[published]);
+
+                if (published != chunks.count() - 1)
+                {
+                    publisher.publish(lines, timestamps, true);
+                }
             }
-        }
+        };
+
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        auto& threadResult = results[i];
+
+        tasks[i] =
+            [i, format, &chunks, &lines, &timestamps, &linesPerChunk, &timestampsPerChunk, &publisher, &threadResult, &finishChunk, threadFile = file, this] mutable
+            {
+                mProgress.begin(i);
 
-        std::copy(
-            linesPerThread[i].begin(), linesPerThread[i].end(),
-            std::back_inserter(lines));
+                while (const auto chunk = chunks.next())
+                {
+                    // Only the first chunk extends the index prefix, so it's
+                    // the one which publishes its progress
+                    const bool first = chunk->index == 0;
+
+                    threadResult = readLines(
+                        threadFile,
+                        chunk->start,
+                        chunk->end,
+                        first ? lines : linesPerChunk[chunk->index],
+                        first ? timestamps : timestampsPerChunk[chunk->index],
+                        format,
+                        first ? &publisher : nullptr,
+                        &mProgress.counter(i));
+
+                    if (not threadResult) [[unlikely]]
+                    {
+                        chunks.cancel();
+                        break;
+                    }
+
+                    finishChunk(chunk->index);
+                }
 
-        linesPerThread[i] = Lines{};
+                mProgress.finish(i);
+            };
     }
 
-    const auto nextLineStart = lines.empty()
-        ? 0
-        : lines.back().start + lines.back().len + 1;
+    executeInParallelAndWait(std::move(tasks));
+
+    Result result(true);
 
-    if (nextLineStart < mFile.size()) [[unlikely]]
+    for (size_t i = 0; i < threadCount; ++i)
     {
-        lines.emplace_back(Line{.start = nextLineStart, .len = mFile.size() - nextLineStart});
+        if (not results[i]) [[unlikely]]
+        {
+            result = std::move(results[i]);
+        }
     }
 
-    initialize(std::move(lines));
-
-    return true;
+    return result;
 }
 
 Result Buffer::Impl::readLines(
     File& file,
     size_t start,
     size_t end,
-    Lines& lines)
+    Lines& lines,
+    Timestamps& timestamps,
+    TimestampFormat format,
+    Publisher* publisher,
+    Progress::Counter* counter)
 {
     auto sizeLeft{end - start};
     auto offset{start};
-    auto lineStart{start};
+    const auto fileSize = file.size();
+
+    std::vector<uint32_t> positions(NEWLINE_SCAN_WINDOW);
 
     while (sizeLeft)
     {
+        // Follower indexes the whole file again after it was replaced, so it
+        // has to be stoppable by unfollow as well
+        if (mStopFlag or mFollowState == cast(FollowState::stopping)) [[unlikely]]
+        {
+            return std::unexpected(BufferError::aborted("Loading was aborted"));
+        }
+
         auto toRead = utils::min(sizeLeft, BLOCK_SIZE);
 
-        if (auto result = file.remap(offset, toRead); not result) [[unlikely]]
+        // Timestamp of line starting close to the end of block is parsed from
+        // the same mapping, so it's extended past the block
+        const auto toMap = format == TimestampFormat::none
+            ? toRead
+            : utils::min(toRead + MAX_TIMESTAMP_LENGTH, fileSize - offset);
+
+        if (auto result = file.remap(offset, toMap); not result) [[unlikely]]
         {
             return std::unexpected(BufferError::systemError(std::move(result.error())));
         }
 
         const auto text = file.at(offset);
 
-        for (size_t i = 0; i < toRead; ++i)
+        for (size_t windowStart = 0; windowStart < toRead; windowStart += NEWLINE_SCAN_WINDOW)
         {
-            if (text[i] == '\n')
+            const auto windowLen = utils::min(toRead - windowStart, NEWLINE_SCAN_WINDOW);
+            const auto windowOffset = offset + windowStart;
+            const auto count = findNewlines(text + windowStart, windowLen, positions.data());
+
+            if (format == TimestampFormat::none) [[likely]]
             {
-                if (mStopFlag) [[unlikely]]
+                for (size_t i = 0; i < count; ++i)
                 {
-                    return std::unexpected(BufferError::aborted("Loading was aborted"));
+                    lines.append(windowOffset + positions[i] + 1);
                 }
+                continue;
+            }
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const auto lineOffset = windowStart + positions[i] + 1;
 
-                lines.emplace_back(Line{.start = lineStart, .len = offset + i - lineStart});
-                lineStart = offset + i + 1;
+                lines.append(offset + lineOffset);
+
+                // Newline at the end of file doesn't start a line
+                if (lineOffset < toMap)
+                {
+                    const auto len = utils::min(toMap - lineOffset, MAX_TIMESTAMP_LENGTH);
+                    timestamps.append(parseTimestamp(std::string_view(text + lineOffset, len), format).value_or(NO_TIMESTAMP));
+                }
             }
         }
 
         sizeLeft -= toRead;
         offset += toRead;
-    }
 
-    return true;
-}
-
-static bool caseSensitiveCheck(const std::string_view& line, const std::string& pattern)
-{
-    return line.contains(pattern);
-}
+        if (counter)
+        {
+            counter->add(toRead, toRead);
+        }
 
-static bool caseInsensitiveCheck(const std::string_view& line, const std::string& pattern)
-{
-    return std::search(
-        line.begin(), line.end(),
-        pattern.begin(), pattern.end(),
-        [](char c1, char c2)
+        if (publisher)
         {
-            return std::tolower(c1) == std::tolower(c2);
-        }) != line.end();
+            publisher->publish(lines, timestamps);
+        }
+    }
+
+    return true;
 }
 
 Result Buffer::Impl::singleThreadedGrep(
     std::string pattern,
     GrepOptions options,
-    Buffer& parentBuffer)
+    Buffer& parentBuffer,
+    const GrepProgressCallback& progressCallback,
+    Context& context)
 {
-    LineRefs lines;
+    std::vector<LineRefs> parts(1);
+    GrepPublisher publisher(progressCallback, parts);
+
+    auto files = copyFiles();
+
+    for (auto& file : files)
+    {
+        file.setAccessPattern(sys::AccessPattern::sequential, context.config.prefetch);
+    }
 
     auto result = grep(
         std::move(pattern),
         options,
         parentBuffer,
-        mFile,
+        files,
         0,
         parentBuffer.lineCount(),
-        lines);
+        parts[0],
+        mProgress.counter(0),
+        publisher,
+        0);
+
+    mProgress.finish(0);
 
     if (not result) [[unlikely]]
     {
         return result;
     }
 
-    initialize(std::move(lines));
+    publisher.finish(0);
 
-    return result;
+    // Grep is finished once all matches are in the buffer
+    return waitForChunks(publisher.count());
 }
 
 Result Buffer::Impl::multiThreadedGrep(
     std::string pattern,
     GrepOptions options,
     Buffer& parentBuffer,
+    const GrepProgressCallback& progressCallback,
     Context& context)
 {
     const auto lineCount = parentBuffer.mLineCount;
-    const uint8_t maxThreads = context.config.maxThreads;
-    const size_t linesPerThread = context.config.linesPerThread;
 
-    const auto threadCount = utils::min(
-        (lineCount + linesPerThread - 1) / linesPerThread,
-        size_t(maxThreads));
+    ChunkQueue chunks(0, lineCount, chunkSize(context.config.linesPerThread, MIN_GREP_CHUNK_LINES));
+
+    const auto threadCount = chunks.threadCount(context.config.maxThreads);
 
-    logger.info() << "using " << threadCount << " threads";
+    logger.info() << "using " << threadCount << " threads, " << chunks.count() << " chunks";
 
     Tasks tasks(threadCount);
     Results results(threadCount);
-    std::vector<LineRefs> lineRefsPerThread(threadCount);
+    std::vector<LineRefs> lineRefsPerChunk(chunks.count());
+    GrepPublisher publisher(progressCallback, lineRefsPerChunk);
 
-    for (size_t i = 0; i < threadCount; ++i)
+    auto files = copyFiles();
+
+    for (auto& file : files)
     {
-        const auto start = (lineCount / threadCount) * i;
-        const auto end = i == threadCount - 1
-            ? lineCount
-            : (lineCount / threadCount) * (i + 1);
+        file.setAccessPattern(sys::AccessPattern::sequential, context.config.prefetch);
+    }
 
-        auto& threadLines = lineRefsPerThread[i];
+    for (size_t i = 0; i < threadCount; ++i)
+    {
         auto& threadResult = results[i];
 
         tasks[i] =
-            [pattern, options, &parentBuffer, start, end,
-                &threadLines, &threadResult,
-                threadFile = mFile,
+            [i, &pattern, options, &parentBuffer, &chunks, &lineRefsPerChunk,
+                &threadResult, &publisher,
+                threadFiles = files,
                 this] mutable
             {
-                threadResult = grep(
-                    std::move(pattern),
-                    options,
-                    parentBuffer,
-                    threadFile,
-                    start,
-                    end,
-                    threadLines);
+                mProgress.begin(i);
+
+                while (const auto chunk = chunks.next())
+                {
+                    threadResult = grep(
+                        pattern,
+                        options,
+                        parentBuffer,
+                        threadFiles,
+                        chunk->start,
+                        chunk->end,
+                        lineRefsPerChunk[chunk->index],
+                        mProgress.counter(i),
+                        publisher,
+                        chunk->index);
+
+                    // Matches following the failed chunk are never published
+                    if (not threadResult) [[unlikely]]
+                    {
+                        chunks.cancel();
+                        break;
+                    }
+
+                    publisher.finish(chunk->index);
+                }
+
+                mProgress.finish(i);
             };
     }
 
     executeInParallelAndWait(std::move(tasks));
 
     Result result(true);
-    size_t summedLineCount = 0;
 
     for (size_t i = 0; i < threadCount; ++i)
     {
@@ -673,7 +2701,6 @@ Result Buffer::Impl::multiThreadedGrep(
         {
             result = std::move(results[i]);
         }
-        summedLineCount += lineRefsPerThread[i].size();
     }
 
     if (not result)
@@ -681,39 +2708,175 @@ Result Buffer::Impl::multiThreadedGrep(
         return result;
     }
 
-    LineRefs lines(std::move(lineRefsPerThread[0]));
-    lines.reserve(summedLineCount);
+    // Grep is finished once all matches are in the buffer
+    return waitForChunks(publisher.count());
+}
+
+GrepCountOrError Buffer::Impl::count(std::string pattern, GrepOptions options, Context& context)
+{
+    const auto lineCount = mLineCount;
+
+    ChunkQueue chunks(0, lineCount, chunkSize(context.config.linesPerThread, MIN_GREP_CHUNK_LINES));
+
+    const auto threadCount = chunks.threadCount(context.config.maxThreads);
+
+    // Lines matching any pattern are matched once again against each of them;
+    // as counting pays off mostly for rare matches, there are few such lines
+    const auto patterns = options.multiple and not options.inverted
+        ? pattern | utils::splitBy("\n")
+        : utils::Strings{};
+
+    std::vector<LiteralSearch> literals;
+
+    if (not options.regex)
+    {
+        for (const auto& p : patterns)
+        {
+            literals.emplace_back(p, options.caseInsensitive);
+        }
+    }
+
+    Progress progress;
+    progress.start(threadCount);
+
+    Tasks tasks(threadCount);
+    Results results(threadCount);
+    std::vector<GrepCount> counts(threadCount, GrepCount{.lines = 0, .patterns = std::vector<size_t>(patterns.size()), .time = 0});
+
+    auto files = copyFiles();
 
-    for (size_t i = 1; i < threadCount; ++i)
+    for (auto& file : files)
     {
-        std::copy(
-            lineRefsPerThread[i].begin(), lineRefsPerThread[i].end(),
-            std::back_inserter(lines));
+        file.setAccessPattern(sys::AccessPattern::sequential, context.config.prefetch);
+    }
+
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        auto& threadMatches = counts[i];
+        auto& threadResult = results[i];
+
+        tasks[i] =
+            [i, &pattern, options, &chunks, &patterns, &literals, &progress,
+                &threadMatches, &threadResult,
+                threadFiles = files,
+                this] mutable
+            {
+                utils::UniquePtr<RegexSet> set;
+                std::vector<int> matched;
+
+                if (options.regex and not patterns.empty())
+                {
+                    set = utils::makeUnique<RegexSet>(patterns, options.caseInsensitive);
+                }
+
+                const auto countPerPattern = [&](size_t lineIndex)
+                {
+                    const auto [line, source] = locate(lineIndex);
+                    const auto text = readInternal(line, threadFiles[source]);
+
+                    // Line has just been read by grep
+                    if (not text) [[unlikely]]
+                    {
+                        return;
+                    }
+
+                    if (set)
+                    {
+                        set->match(*text, matched);
+
+                        for (const auto index : matched)
+                        {
+                            ++threadMatches.patterns[index];
+                        }
+
+                        return;
+                    }
+
+                    for (size_t j = 0; j < literals.size(); ++j)
+                    {
+                        threadMatches.patterns[j] += literals[j].contains(*text);
+                    }
+                };
+
+                const utils::FunctionRef<void(size_t)> attribute(countPerPattern);
 
-        lineRefsPerThread[i] = LineRefs{};
+                GrepCounter counter{.lines = 0, .attribute = patterns.empty() ? nullptr : &attribute};
+                NullPublisher publisher;
+
+                progress.begin(i);
+
+                while (const auto chunk = chunks.next())
+                {
+                    threadResult = grep(
+                        pattern,
+                        options,
+                        *this,
+                        threadFiles,
+                        chunk->start,
+                        chunk->end,
+                        counter,
+                        progress.counter(i),
+                        publisher,
+                        chunk->index);
+
+                    if (not threadResult) [[unlikely]]
+                    {
+                        chunks.cancel();
+                        break;
+                    }
+                }
+
+                progress.finish(i);
+
+                threadMatches.lines = counter.lines;
+            };
     }
 
-    initialize(std::move(lines));
+    executeInParallelAndWait(std::move(tasks));
+
+    progress.stop();
 
-    return true;
+    GrepCount total{.lines = 0, .patterns = std::vector<size_t>(patterns.size()), .time = 0};
+
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        if (not results[i]) [[unlikely]]
+        {
+            return std::unexpected(std::move(results[i].error()));
+        }
+
+        total.lines += counts[i].lines;
+
+        for (size_t j = 0; j < patterns.size(); ++j)
+        {
+            total.patterns[j] += counts[i].patterns[j];
+        }
+    }
+
+    logger.info() << filePath() << ": counted " << total.lines << " lines of " << lineCount << " using " << threadCount << " threads";
+
+    return total;
 }
 
+template <typename Sink, typename Publisher>
 Result Buffer::Impl::grep(
     std::string pattern,
     GrepOptions options,
     Buffer& parentBuffer,
-    File& file,
+    Files& files,
     size_t start,
     size_t end,
-    LineRefs& lines)
+    Sink& lines,
+    Progress::Counter& counter,
+    Publisher& publisher,
+    size_t part)
 {
     #define FILE_LINE_INDEX_TRANSFORM(I) I
-    #define FILTERED_LINE_INDEX_TRANSFORM(I) parentBuffer.mFilteredLines[I]
+    #define FILTERED_LINE_INDEX_TRANSFORM(I) (*parentBuffer.mFilteredLines)[I]
 
     #define GREP_LOOP(CONDITION, LINE_INDEX_TRANSFORM) \
         do \
         { \
-            auto& fileLines = *mFileLines; \
             for (size_t i = start; i < end; ++i) \
             { \
                 if (mStopFlag) [[unlikely]] \
@@ -721,45 +2884,138 @@ Result Buffer::Impl::grep(
                     return std::unexpected(BufferError::aborted("Loading was aborted")); \
                 } \
                 auto lineIndex = LINE_INDEX_TRANSFORM(i); \
-                auto result = readInternal(fileLines[lineIndex], file); \
+                const auto [line, source] = locate(lineIndex); \
+                auto result = readInternal(line, files[source]); \
                 if (not result) [[unlikely]] \
                 { \
                     return std::unexpected(std::move(result.error())); \
                 } \
+                counter.add(1, result->size()); \
                 if (CONDITION) \
                 { \
-                    lines.emplace_back(lineIndex); \
+                    lines.pushBack(lineIndex); \
+                } \
+                if ((i & (GREP_PUBLISH_LINES - 1)) == 0) [[unlikely]] \
+                { \
+                    publisher.publish(part); \
                 } \
             } \
         } \
         while (0)
 
-    if (not options.regex)
+    // Lines of merged files are interleaved, so there's no single range
+    if (start < end and not mMerge)
+    {
+        const bool filtered = parentBuffer.mType == cast(BufferType::filtered);
+        const auto first = (*mFileLines)[filtered ? (*parentBuffer.mFilteredLines)[start] : start];
+        const auto last = (*mFileLines)[filtered ? (*parentBuffer.mFilteredLines)[end - 1] : end - 1];
+
+        files[0].advise(first.start, last.start + last.len - first.start);
+    }
+
+    if (options.multiple)
+    {
+        const auto patterns = pattern | utils::splitBy("\n");
+
+        if (not options.regex)
+        {
+            // Automaton goes over each byte once, whatever the number of patterns
+            const AhoCorasick automaton(patterns, options.caseInsensitive);
+
+            if (parentBuffer.mType == cast(BufferType::base) and not mMerge)
+            {
+                return blockGrep(automaton, nullptr, options.inverted, files[0], start, end, lines, counter, publisher, part);
+            }
+
+            if (options.inverted)
+            {
+                if (parentBuffer.mType == cast(BufferType::filtered))
+                {
+                    GREP_LOOP(not automaton.contains(*result), FILTERED_LINE_INDEX_TRANSFORM);
+                }
+                else
+                {
+                    GREP_LOOP(not automaton.contains(*result), FILE_LINE_INDEX_TRANSFORM);
+                }
+            }
+            else
+            {
+                if (parentBuffer.mType == cast(BufferType::filtered))
+                {
+                    GREP_LOOP(automaton.contains(*result), FILTERED_LINE_INDEX_TRANSFORM);
+                }
+                else
+                {
+                    GREP_LOOP(automaton.contains(*result), FILE_LINE_INDEX_TRANSFORM);
+                }
+            }
+        }
+        else
+        {
+            RegexSet set(patterns, options.caseInsensitive);
+
+            if (not set.ok()) [[unlikely]]
+            {
+                return std::unexpected(BufferError::regexError(set.error()));
+            }
+
+            if (options.inverted)
+            {
+                if (parentBuffer.mType == cast(BufferType::filtered))
+                {
+                    GREP_LOOP(not set.partialMatch(*result), FILTERED_LINE_INDEX_TRANSFORM);
+                }
+                else
+                {
+                    GREP_LOOP(not set.partialMatch(*result), FILE_LINE_INDEX_TRANSFORM);
+                }
+            }
+            else
+            {
+                if (parentBuffer.mType == cast(BufferType::filtered))
+                {
+                    GREP_LOOP(set.partialMatch(*result), FILTERED_LINE_INDEX_TRANSFORM);
+                }
+                else
+                {
+                    GREP_LOOP(set.partialMatch(*result), FILE_LINE_INDEX_TRANSFORM);
+                }
+            }
+        }
+    }
+    else if (not options.regex)
     {
-        auto lineCheck = options.caseInsensitive
-            ? &caseInsensitiveCheck
-            : &caseSensitiveCheck;
+        const LiteralSearch literal(std::move(pattern), options.caseInsensitive);
+
+        // Pattern with newline could match across lines in a block
+        if (parentBuffer.mType == cast(BufferType::base)
+            and not mMerge
+            and not literal.pattern().empty()
+            and not literal.pattern().contains('\n'))
+        {
+            return blockGrep(literal, nullptr, options.inverted, files[0], start, end, lines, counter, publisher, part);
+        }
 
         if (options.inverted)
         {
             if (parentBuffer.mType == cast(BufferType::filtered))
             {
-                GREP_LOOP(not lineCheck(*result, pattern), FILTERED_LINE_INDEX_TRANSFORM);
+                GREP_LOOP(not literal.contains(*result), FILTERED_LINE_INDEX_TRANSFORM);
             }
             else
             {
-                GREP_LOOP(not lineCheck(*result, pattern), FILE_LINE_INDEX_TRANSFORM);
+                GREP_LOOP(not literal.contains(*result), FILE_LINE_INDEX_TRANSFORM);
             }
         }
         else
         {
             if (parentBuffer.mType == cast(BufferType::filtered))
             {
-                GREP_LOOP(lineCheck(*result, pattern), FILTERED_LINE_INDEX_TRANSFORM);
+                GREP_LOOP(literal.contains(*result), FILTERED_LINE_INDEX_TRANSFORM);
             }
             else
             {
-                GREP_LOOP(lineCheck(*result, pattern), FILE_LINE_INDEX_TRANSFORM);
+                GREP_LOOP(literal.contains(*result), FILE_LINE_INDEX_TRANSFORM);
             }
         }
     }
@@ -772,7 +3028,54 @@ Result Buffer::Impl::grep(
             return std::unexpected(BufferError::regexError(re.error()));
         }
 
-        if (options.inverted)
+        const auto required = re.requiredLiteral();
+        const bool prefilter = required.text.size() >= MIN_PREFILTER_LEN;
+
+        // All workers find the same literal, so it's reported by the first
+        // one; count runs on the buffer itself, which keeps its own
+        if (start == 0 and prefilter and std::is_same_v<Sink, LineRefs>)
+        {
+            mGrepPrefilter = required.text;
+        }
+
+        if (prefilter)
+        {
+            // Regex runs only on lines with the literal
+            const LiteralSearch literal(required.text, required.caseInsensitive);
+
+            #define PREFILTERED_MATCH (literal.contains(*result) and re.partialMatch(*result))
+
+            if (parentBuffer.mType == cast(BufferType::base)
+                and not mMerge
+                and not literal.pattern().contains('\n'))
+            {
+                return blockGrep(literal, &re, options.inverted, files[0], start, end, lines, counter, publisher, part);
+            }
+
+            if (options.inverted)
+            {
+                if (parentBuffer.mType == cast(BufferType::filtered))
+                {
+                    GREP_LOOP(not PREFILTERED_MATCH, FILTERED_LINE_INDEX_TRANSFORM);
+                }
+                else
+                {
+                    GREP_LOOP(not PREFILTERED_MATCH, FILE_LINE_INDEX_TRANSFORM);
+                }
+            }
+            else
+            {
+                if (parentBuffer.mType == cast(BufferType::filtered))
+                {
+                    GREP_LOOP(PREFILTERED_MATCH, FILTERED_LINE_INDEX_TRANSFORM);
+                }
+                else
+                {
+                    GREP_LOOP(PREFILTERED_MATCH, FILE_LINE_INDEX_TRANSFORM);
+                }
+            }
+        }
+        else if (options.inverted)
         {
             if (parentBuffer.mType == cast(BufferType::filtered))
             {
@@ -799,36 +3102,223 @@ Result Buffer::Impl::grep(
     return true;
 }
 
+template <typename Matcher, typename Sink, typename Publisher>
+Result Buffer::Impl::blockGrep(
+    const Matcher& matcher,
+    Regex* re,
+    bool inverted,
+    File& file,
+    size_t start,
+    size_t end,
+    Sink& lines,
+    Progress::Counter& counter,
+    Publisher& publisher,
+    size_t part)
+{
+    const auto& index = *mFileLines;
+    const auto sampleEnd = utils::min(end, start + GREP_SAMPLE_LINES);
+    size_t hits = 0;
+    size_t i = start;
+
+    // Lines are checked one by one for a while to estimate how often they
+    // match; with many hits mapping each of them back to line costs more
+    // than it saves
+    for (; i < end; ++i)
+    {
+        if (i == sampleEnd and hits * GREP_SPARSE_RATIO <= i - start)
+        {
+            break;
+        }
+
+        if (mStopFlag) [[unlikely]]
+        {
+            return std::unexpected(BufferError::aborted("Loading was aborted"));
+        }
+
+        auto result = readInternal(index[i], file);
+
+        if (not result) [[unlikely]]
+        {
+            return std::unexpected(std::move(result.error()));
+        }
+
+        counter.add(1, result->size());
+
+        const bool candidate = matcher.contains(*result);
+        const bool hit = candidate and (not re or re->partialMatch(*result));
+
+        hits += candidate;
+
+        if (hit != inverted)
+        {
+            lines.pushBack(i);
+        }
+
+        if ((i & (GREP_PUBLISH_LINES - 1)) == 0) [[unlikely]]
+        {
+            publisher.publish(part);
+        }
+    }
+
+    while (i < end)
+    {
+        if (mStopFlag) [[unlikely]]
+        {
+            return std::unexpected(BufferError::aborted("Loading was aborted"));
+        }
+
+        // Block ends with the line containing its GREP_BLOCK_SIZE-th byte
+        const auto blockStart = index.start(i);
+        const auto blockEnd = findLine(blockStart + GREP_BLOCK_SIZE, i, end) + 1;
+        const auto blockLen = index.start(blockEnd) - 1 - blockStart;
+
+        auto result = readInternal(Line{.start = blockStart, .len = blockLen}, file);
+
+        if (not result) [[unlikely]]
+        {
+            return std::unexpected(std::move(result.error()));
+        }
+
+        counter.add(blockEnd - i, blockLen);
+
+        const auto text = *result;
+        size_t line = i;
+
+        while (line < blockEnd)
+        {
+            const auto offset = matcher.find(text, index.start(line) - blockStart);
+
+            if (offset == Matcher::npos)
+            {
+                break;
+            }
+
+            // Search continues from the line following the one with hit
+            const auto hitLine = findLine(blockStart + offset, line, blockEnd);
+            const auto hitLineRef = index[hitLine];
+            const bool hit = not re or re->partialMatch(text.substr(hitLineRef.start - blockStart, hitLineRef.len));
+
+            if (inverted)
+            {
+                for (; line < hitLine; ++line)
+                {
+                    lines.pushBack(line);
+                }
+
+                if (not hit)
+                {
+                    lines.pushBack(hitLine);
+                }
+            }
+            else if (hit)
+            {
+                lines.pushBack(hitLine);
+            }
+
+            line = hitLine + 1;
+        }
+
+        if (inverted)
+        {
+            for (; line < blockEnd; ++line)
+            {
+                lines.pushBack(line);
+            }
+        }
+
+        i = blockEnd;
+
+        publisher.publish(part);
+    }
+
+    return true;
+}
+
+size_t Buffer::Impl::findLine(size_t offset, size_t first, size_t last) const
+{
+    const auto& index = *mFileLines;
+
+    // Last line in range which starts at offset or before it
+    while (last - first > 1)
+    {
+        const auto middle = first + (last - first) / 2;
+
+        if (index.start(middle) <= offset)
+        {
+            first = middle;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+
+    return first;
+}
+
 void Buffer::Impl::filter(
     size_t start,
     size_t end,
     Buffer& parentBuffer)
 {
     LineRefs lines;
+    utils::RoaringBitmap bitmap;
     for (size_t i = start; i <= end; ++i)
     {
         auto lineIndex = i;
 
         if (parentBuffer.mType == cast(BufferType::filtered))
         {
-            lineIndex = parentBuffer.mFilteredLines[lineIndex];
+            lineIndex = (*parentBuffer.mFilteredLines)[lineIndex];
         }
 
-        lines.push_back(lineIndex);
+        lines.pushBack(lineIndex);
+        bitmap.append(lineIndex);
+    }
+
+    initialize(std::move(lines), std::move(bitmap));
+}
+
+void Buffer::Impl::combine(SetOperation operation, const Buffer& first, const Buffer& second)
+{
+    const auto& lhs = *first.mBitmap;
+    const auto& rhs = *second.mBitmap;
+
+    utils::RoaringBitmap result;
+
+    switch (operation)
+    {
+        case SetOperation::intersection:
+            result = lhs & rhs;
+            break;
+        case SetOperation::sum:
+            result = lhs | rhs;
+            break;
+        case SetOperation::difference:
+            result = lhs - rhs;
+            break;
     }
 
-    initialize(std::move(lines));
+    // Lines are still read through line refs; bitmap is kept for combining
+    // the result further
+    LineRefs lines;
+
+    result.forEach([&lines](uint64_t line){ lines.pushBack(line); });
+
+    lines.shrinkToFit();
+
+    initialize(std::move(lines), std::move(result));
 }
 
-SearchResult Buffer::Impl::search(const SearchRequest& req, File& file)
+SearchResult Buffer::Impl::search(const SearchRequest& req, Files& files)
 {
     const auto lineCount = mLineCount;
 
     utils::FunctionRef<size_t(size_t)> lineIndexTransform;
 
-    std::string_view pattern = req.pattern;
+    const LiteralSearch literal(req.pattern, req.caseInsensitive);
 
-    auto filteredLinesTransform = [this](size_t i){ return mFilteredLines[i]; };
+    auto filteredLinesTransform = [this](size_t i){ return (*mFilteredLines)[i]; };
     auto fileLinesTransform = [](size_t i){ return i; };
 
     if (mType == cast(BufferType::filtered))
@@ -840,10 +3330,22 @@ SearchResult Buffer::Impl::search(const SearchRequest& req, File& file)
         lineIndexTransform = fileLinesTransform;
     }
 
-    auto& fileLines = *mFileLines;
+    const auto readLine =
+        [&](size_t i)
+        {
+            const auto [line, source] = locate(lineIndexTransform(i));
+            return readInternal(line, files[source]);
+        };
+
+    if (req.direction == SearchDirection::forward and not mMerge)
+    {
+        auto& file = files[0];
+        const auto startOffset = (*mFileLines)[lineIndexTransform(req.startLineIndex)].start;
+        file.advise(startOffset, file.size() - startOffset);
+    }
 
     {
-        auto result = readInternal(fileLines[lineIndexTransform(req.startLineIndex)], file);
+        auto result = readLine(req.startLineIndex);
 
         if (not result) [[unlikely]]
         {
@@ -855,7 +3357,7 @@ SearchResult Buffer::Impl::search(const SearchRequest& req, File& file)
         if (req.direction == SearchDirection::forward)
         {
             auto startLinePosition = req.startLinePosition + static_cast<int>(req.continuation);
-            auto it = line.find(pattern, startLinePosition);
+            auto it = literal.find(line, startLinePosition);
 
             if (it != line.npos)
             {
@@ -871,7 +3373,7 @@ SearchResult Buffer::Impl::search(const SearchRequest& req, File& file)
             if (req.startLinePosition > 1)
             {
                 auto startLinePosition = req.startLinePosition - static_cast<int>(req.continuation);
-                auto it = line.rfind(pattern, startLinePosition);
+                auto it = literal.rfind(line, startLinePosition);
 
                 if (it != line.npos)
                 {
@@ -889,12 +3391,12 @@ SearchResult Buffer::Impl::search(const SearchRequest& req, File& file)
     {
         for (size_t i = req.startLineIndex + 1; i < lineCount; ++i)
         {
-            if (mStopFlag) [[unlikely]]
+            if (mStopFlag or mSearchStopFlag) [[unlikely]]
             {
                 return SearchResult{.aborted = true};
             }
 
-            auto result = readInternal(fileLines[lineIndexTransform(i)], file);
+            auto result = readLine(i);
 
             if (not result) [[unlikely]]
             {
@@ -903,7 +3405,7 @@ SearchResult Buffer::Impl::search(const SearchRequest& req, File& file)
 
             const auto& line = *result;
 
-            auto it = line.find(pattern);
+            auto it = literal.find(line);
 
             if (it != line.npos)
             {
@@ -919,12 +3421,12 @@ SearchResult Buffer::Impl::search(const SearchRequest& req, File& file)
     {
         for (size_t i = req.startLineIndex - 1; static_cast<long>(i) >= 0; --i)
         {
-            if (mStopFlag) [[unlikely]]
+            if (mStopFlag or mSearchStopFlag) [[unlikely]]
             {
                 return SearchResult{.aborted = true};
             }
 
-            auto result = readInternal(fileLines[lineIndexTransform(i)], file);
+            auto result = readLine(i);
 
             if (not result) [[unlikely]]
             {
@@ -932,7 +3434,7 @@ SearchResult Buffer::Impl::search(const SearchRequest& req, File& file)
             }
 
             const auto& line = *result;
-            auto it = line.rfind(pattern, result->size());
+            auto it = literal.rfind(line);
 
             if (it != line.npos)
             {
@@ -948,11 +3450,6 @@ SearchResult Buffer::Impl::search(const SearchRequest& req, File& file)
     return {};
 }
 
-StringViewOrError Buffer::Impl::readInternal(Line line)
-{
-    return readInternal(line, mFile);
-}
-
 StringViewOrError Buffer::Impl::readInternal(Line line, File& file)
 {
     if (line.len == 0)
@@ -962,9 +3459,23 @@ StringViewOrError Buffer::Impl::readInternal(Line line, File& file)
 
     if (not file.isAreaMapped(line.start, line.len)) [[unlikely]]
     {
-        auto mappingLen = utils::min(BLOCK_SIZE, file.size() - line.start);
+        const auto end = line.start + line.len;
+        auto offset = line.start;
+
+        // Reading backwards, e.g. in backward search or scrolling up, block
+        // ends with the line, so that preceding lines are read with it and
+        // not each with a block of its own
+        if (file.isBeforeMapping(line.start))
+        {
+            offset = end - utils::min(end, utils::max(line.len, BLOCK_SIZE));
+        }
+
+        // Size of file may be outdated if it's followed, but the line is
+        // known to be within the file
+        const auto sizeLeft = file.size() > offset ? file.size() - offset : 0;
+        const auto mappingLen = utils::max(end - offset, utils::min(BLOCK_SIZE, sizeLeft));
 
-        if (auto result = file.remap(line.start, mappingLen); not result) [[unlikely]]
+        if (auto result = file.remap(offset, mappingLen); not result) [[unlikely]]
         {
             return std::unexpected(BufferError::systemError(std::move(result.error())));
         }
@@ -1,17 +1,25 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdlib>
 #include <expected>
 #include <functional>
+#include <mutex>
+#include <vector>
 
 #include "core/buffers.hpp"
 #include "core/file.hpp"
 #include "core/fwd.hpp"
+#include "core/grep_cache.hpp"
 #include "core/grep_options.hpp"
-#include "core/line.hpp"
+#include "core/line_index.hpp"
+#include "core/progress.hpp"
+#include "core/timestamp.hpp"
+#include "core/timestamp_index.hpp"
 #include "utils/fwd.hpp"
 #include "utils/immobile.hpp"
+#include "utils/unique_ptr.hpp"
 
 namespace core
 {
@@ -61,38 +69,191 @@ struct SearchRequest
 {
     const SearchDirection direction;
     const bool            continuation;
+    const bool            caseInsensitive;
     const size_t          startLineIndex;
     const size_t          startLinePosition;
     std::string           pattern;
 };
 
+// Chunk of line index published by Buffer::load while it's still running,
+// with timestamps of its lines if they're indexed
+struct LoadProgress
+{
+    Lines      lines;
+    Timestamps timestamps;
+    float      time;
+    bool       last;
+};
+
+// Matches found by Buffer::grep while it's still running; chunks follow
+// each other in the order of lines. Bitmap holds the same lines, so that
+// combining grep results doesn't need to build it from them
+struct GrepProgress
+{
+    LineRefs              lines;
+    utils::RoaringBitmap  bitmap;
+    float                 time;
+    bool                  last;
+};
+
+// Numbers of lines grep would find, which are counted instead of being kept.
+// Lines matched by each of multiple patterns are counted too, unless grep is
+// inverted
+struct GrepCount
+{
+    size_t              lines;
+    std::vector<size_t> patterns;
+    float               time;
+};
+
+// Change of followed file found by Buffer::follow. Lines are starts of lines
+// past the previously indexed part of file, or, if file was truncated or
+// replaced, the whole new index; in both cases without the final sentinel
+struct FollowUpdate
+{
+    enum class Type : char
+    {
+        grown,
+        replaced,
+    };
+
+    Type              type;
+    Lines             lines;
+    Timestamps        timestamps;
+    size_t            fileSize;
+    sys::FileIdentity identity;
+};
+
+using FollowUpdatePtr = utils::UniquePtr<FollowUpdate>;
+
+enum class SetOperation : char
+{
+    intersection,
+    sum,
+    difference,
+};
+
 using TimeOrError = std::expected<float, BufferError>;
 using StringViewOrError = std::expected<std::string_view, BufferError>;
+using GrepCountOrError = std::expected<GrepCount, BufferError>;
 using FinishedCallback = std::function<void(TimeOrError)>;
 using FinishedSearchCallback = std::function<void(SearchResult, float)>;
+using FinishedCountCallback = std::function<void(GrepCountOrError)>;
+using LoadProgressCallback = std::function<void(LoadProgress)>;
+using GrepProgressCallback = std::function<void(GrepProgress)>;
+using FollowCallback = std::function<void(FollowUpdate)>;
 
 struct Buffer : utils::Immobile
 {
+    constexpr static size_t MAX_MERGED_FILES = 256;
+
     Buffer();
     ~Buffer();
 
-    void load(std::string path, Context& context, FinishedCallback callback);
-    void grep(std::string pattern, GrepOptions options, BufferId parentBufferId, Context& context, FinishedCallback callback);
+    void load(std::string path, FileBackend backend, Context& context, LoadProgressCallback progressCallback, FinishedCallback callback);
+
+    // Appends chunk of index published by load; must be called on the main
+    // thread, in the order in which chunks were published
+    void applyLoadProgress(LoadProgress progress);
+
+    // Watches loaded file for changes and reports them to callback until
+    // unfollow is called. Only the appended part of file is scanned
+    void follow(FollowCallback callback);
+    void unfollow();
+
+    // Applies update reported by follow; must be called on the main thread.
+    // Returns false if update has been deferred, as some worker is reading
+    // the index; it's applied together with the next one. Buffers derived
+    // from this one are no longer valid once an update of type replaced has
+    // been applied, so they have to be destroyed by the caller
+    std::expected<bool, BufferError> applyFollowUpdate(FollowUpdate update);
+
+    // Interleaves lines of given files by their timestamps into a single
+    // buffer; lines without timestamp are kept with the preceding line
+    void merge(std::vector<std::string> paths, FileBackend backend, Context& context, FinishedCallback callback);
+
+    void grep(std::string pattern, GrepOptions options, BufferId parentBufferId, Context& context, GrepProgressCallback progressCallback, FinishedCallback callback);
+
+    // Appends chunk of matches published by grep; must be called on the main
+    // thread, in the order in which chunks were published. Chunks are deferred
+    // while the buffer is being searched; they're applied together with the
+    // next one, or by calling it with empty chunk once the search has
+    // finished. Returns whether any chunks have been applied
+    bool applyGrepProgress(GrepProgress progress);
+
+    // Counts lines of this buffer which grep would find, running the same
+    // matchers, but without creating a buffer with them; like search it runs
+    // aside of other operations
+    void count(std::string pattern, GrepOptions options, Context& context, FinishedCountCallback callback);
+
     void filter(size_t start, size_t end, BufferId parentBufferId, Context& context, FinishedCallback callback);
+
+    // Fills buffer with lines which are in both, in any, or only in the first
+    // of given filtered buffers, which must share lines. Sets are computed
+    // on compressed bitmaps of line numbers, which filtered buffers keep
+    // along with their lines, in the background; must be called on the main
+    // thread, once neither is loading
+    void combine(SetOperation operation, BufferId firstBufferId, BufferId secondBufferId, Context& context, FinishedCallback callback);
     StringViewOrError readLine(size_t i);
 
     void search(SearchRequest req, FinishedSearchCallback callback);
 
     size_t findClosestLine(size_t absoluteLineNumber);
 
+    // Timestamps of lines are indexed while loading if timestampFormat is
+    // set; lines before the first timestamp have none
+    bool hasTimestamps() const;
+    utils::Maybe<Timestamp> lineTimestamp(size_t lineIndex) const;
+
+    // Index of the first line which timestamp is not earlier than the given
+    // one, or lineCount() if there's none
+    size_t findTimestamp(Timestamp timestamp) const;
+
     size_t absoluteLineNumber(size_t lineIndex) const;
 
+    // Files which lines come from; there's more than one only in merged
+    // buffers and buffers derived from them
+    size_t sourceCount() const;
+    size_t lineSource(size_t lineIndex) const;
+    const std::string& sourceName(size_t source) const;
+
     const std::string& filePath() const;
 
-    constexpr size_t fileLineCount() const
-    {
-        return mFileLines->size();
-    }
+    // Literal required by regex of grep, which was looked for before running
+    // the regex on a line; it's empty if there was none or it was too short
+    const std::string& grepPrefilter() const;
+
+    // Matches of grep were taken from the cache instead of grepping parent
+    bool isGrepCached() const;
+
+    size_t fileSize() const;
+
+    bool isBase() const;
+
+    bool isFiltered() const;
+
+    // Both buffers are derived from the same file, or the same merge
+    bool sharesLinesWith(const Buffer& other) const;
+
+    bool isLoading() const;
+
+    // Matches of running grep can be searched, unlike partially loaded file
+    bool isSearchable() const;
+
+    bool isCounting() const;
+
+    bool isCompressed() const;
+
+    bool isFollowing() const;
+
+    float firstChunkTime() const;
+
+    // Progress of load or grep; it's kept after the operation has finished
+    const Progress& progress() const;
+
+    size_t indexMemoryUsage() const;
+
+    size_t fileLineCount() const;
 
     constexpr size_t lineCount() const
     {
@@ -101,17 +262,49 @@ struct Buffer : utils::Immobile
 
 private:
     struct Impl;
+    struct Merge;
+
+    using MergePtr = utils::UniquePtr<Merge>;
 
     std::atomic_bool mStopFlag;
     std::atomic_char mState;
     std::atomic_char mType;
+    std::atomic_char mFollowState;
+    std::atomic_bool mFollowDeferred;
+    std::mutex       mFollowLock;
+    std::condition_variable mFollowStopped;
+    std::mutex       mStateLock;
+    std::condition_variable mStateChanged;
+    std::atomic_uint mAppliedChunks;
+    std::atomic_bool mSearching;
+    std::atomic_bool mSearchStopFlag;
+    std::atomic_bool mCounting;
+    bool             mDeferredLast;
+    bool             mGrepCached;
+    TimestampFormat  mTimestampFormat;
     File             mFile;
+    size_t           mFileSize;
     size_t           mLineCount;
+    float            mFirstChunkTime;
     Lines*           mFileLines;
+    Timestamps*      mFileTimestamps;
+    Merge*           mMerge;
+    FollowUpdatePtr  mPendingUpdate;
+    Progress         mProgress;
+    Timestamps       mOwnTimestamps;
+    std::string      mGrepPrefilter;
+    LineRefs         mDeferredLines;
+    utils::RoaringBitmap mDeferredBitmap;
+    unsigned         mDeferredChunks;
+    uint64_t         mVersion;
+    size_t           mGrepCacheLimit;
+    utils::UniquePtr<GrepCacheKey> mGrepCacheKey;
+    LineBitmapPtr    mBitmap;
     union
     {
         Lines        mOwnLines;
-        LineRefs     mFilteredLines;
+        LineRefsPtr  mFilteredLines;
+        MergePtr     mOwnMerge;
     };
 };
 
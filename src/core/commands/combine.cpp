@@ -0,0 +1,154 @@
+#include <string_view>
+
+#include "core/buffer.hpp"
+#include "core/event.hpp"
+#include "core/events/buffer_loaded.hpp"
+#include "core/interpreter/command.hpp"
+#include "core/main_view.hpp"
+#include "core/message_line.hpp"
+#include "utils/buffer.hpp"
+
+namespace core
+{
+
+struct CombineOperation
+{
+    std::string_view name;
+    std::string_view infix;
+    SetOperation     operation;
+};
+
+constexpr static CombineOperation operations[] = {
+    {"and",    " and ",     SetOperation::intersection},
+    {"or",     " or ",      SetOperation::sum},
+    {"andnot", " and not ", SetOperation::difference},
+};
+
+// Window given either by its index in the tabline of current window, or by
+// its name; it's looked for among all windows of the current file
+static WindowNode* findWindow(const interpreter::Value& arg, WindowNode& current)
+{
+    if (const auto index = arg.integer())
+    {
+        auto parent = current.parent();
+        return parent and *index >= 0 ? parent->childAt(*index) : nullptr;
+    }
+
+    const auto name = arg.string();
+
+    if (not name)
+    {
+        return nullptr;
+    }
+
+    WindowNode* found = nullptr;
+
+    current.base().forEachRecursive(
+        [&found, &name](WindowNode& node)
+        {
+            if (not found and node.type() == WindowNode::Type::window and node.name() == *name)
+            {
+                found = &node;
+            }
+        });
+
+    return found;
+}
+
+DEFINE_COMMAND(combine)
+{
+    HELP() = "create window with lines which are in both (and), in any (or), or only in current (andnot) of current and given grep window";
+
+    FLAGS()
+    {
+        return {};
+    }
+
+    ARGUMENTS()
+    {
+        return {
+            {Type::string, "operation"},
+            {Type::any, "window"}
+        };
+    }
+
+    EXECUTOR()
+    {
+        const auto operationName = *args[0].string();
+
+        const CombineOperation* operation = nullptr;
+
+        for (const auto& o : operations)
+        {
+            if (o.name == operationName)
+            {
+                operation = &o;
+            }
+        }
+
+        if (not operation)
+        {
+            context.messageLine.error() << "Unknown operation: " << operationName << "; expected and, or or andnot";
+            return false;
+        }
+
+        auto firstWindow = context.mainView.currentWindowNode();
+
+        if (not firstWindow) [[unlikely]]
+        {
+            context.messageLine.error() << "No buffer loaded yet";
+            return false;
+        }
+
+        auto secondWindow = findWindow(args[1], *firstWindow);
+
+        if (not secondWindow or secondWindow->type() != WindowNode::Type::window)
+        {
+            context.messageLine.error() << "No such window";
+            return false;
+        }
+
+        for (auto window : {firstWindow, secondWindow})
+        {
+            auto buffer = window->buffer();
+
+            if (not window->loaded() or not buffer or buffer->isLoading())
+            {
+                context.messageLine.error() << "Buffer is still loading";
+                return false;
+            }
+
+            if (not buffer->isFiltered())
+            {
+                context.messageLine.error() << window->name() << " is not a grep window";
+                return false;
+            }
+        }
+
+        if (not firstWindow->buffer()->sharesLinesWith(*secondWindow->buffer()))
+        {
+            context.messageLine.error() << "Windows show different files";
+            return false;
+        }
+
+        utils::Buffer buf;
+
+        buf << firstWindow->name() << operation->infix << secondWindow->name();
+
+        auto& newWindow = context.mainView.createWindow(buf.str(), MainView::Parent::currentWindow, context);
+
+        newWindow.buffer()->combine(
+            operation->operation,
+            firstWindow->bufferId(),
+            secondWindow->bufferId(),
+            context,
+            [&newWindow, &context](TimeOrError result)
+            {
+                sendEvent<events::BufferLoaded>(InputSource::internal, context, std::move(result), newWindow);
+            });
+
+        return true;
+    }
+}
+
+}  // namespace core
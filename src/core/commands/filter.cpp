@@ -32,6 +32,12 @@ DEFINE_COMMAND(filter)
             return false;
         }
 
+        if (auto parentBuffer = parentWindow->buffer(); not parentWindow->loaded() or not parentBuffer or parentBuffer->isLoading())
+        {
+            context.messageLine.error() << "Buffer is still loading";
+            return false;
+        }
+
         auto& w = parentWindow->window();
 
         if (not w.selectionMode)
@@ -0,0 +1,74 @@
+#include "core/buffer.hpp"
+#include "core/event.hpp"
+#include "core/events/buffer_follow_update.hpp"
+#include "core/interpreter/command.hpp"
+#include "core/main_view.hpp"
+#include "core/message_line.hpp"
+
+namespace core
+{
+
+DEFINE_COMMAND(follow)
+{
+    HELP() = "toggle following changes of current file";
+
+    FLAGS()
+    {
+        return {};
+    }
+
+    ARGUMENTS()
+    {
+        return {};
+    }
+
+    EXECUTOR()
+    {
+        auto window = context.mainView.currentWindowNode();
+
+        if (not window) [[unlikely]]
+        {
+            context.messageLine.error() << "No buffer loaded yet";
+            return false;
+        }
+
+        auto buffer = window->buffer();
+
+        if (not window->loaded() or not buffer or buffer->isLoading())
+        {
+            context.messageLine.error() << "Buffer is still loading";
+            return false;
+        }
+
+        if (not buffer->isBase())
+        {
+            context.messageLine.error() << "Only file buffers can be followed";
+            return false;
+        }
+
+        if (buffer->isCompressed())
+        {
+            context.messageLine.error() << "Compressed files cannot be followed";
+            return false;
+        }
+
+        if (buffer->isFollowing())
+        {
+            buffer->unfollow();
+            context.messageLine.info() << buffer->filePath() << ": not following";
+            return true;
+        }
+
+        buffer->follow(
+            [bufferId = window->bufferId(), &context](FollowUpdate update)
+            {
+                sendEvent<events::BufferFollowUpdate>(InputSource::internal, context, std::move(update), bufferId);
+            });
+
+        context.messageLine.info() << buffer->filePath() << ": following";
+
+        return true;
+    }
+}
+
+}  // namespace core
@@ -0,0 +1,41 @@
+#include "core/buffer.hpp"
+#include "core/interpreter/command.hpp"
+#include "core/main_view.hpp"
+#include "core/message_line.hpp"
+
+namespace core
+{
+
+DEFINE_COMMAND(gotoTime)
+{
+    HELP() = "go to the first line not earlier than given time, like \"2024-01-15 10:23\" or \"10:23\"; requires timestampFormat";
+
+    FLAGS()
+    {
+        return {};
+    }
+
+    ARGUMENTS()
+    {
+        return {
+            {Type::string, "time"},
+        };
+    };
+
+    EXECUTOR()
+    {
+        auto window = context.mainView.currentWindowNode();
+
+        if (not window or not window->loaded() or not window->buffer()) [[unlikely]]
+        {
+            context.messageLine.error() << "No buffer loaded yet";
+            return false;
+        }
+
+        context.mainView.scrollToTime(*args[0].string(), context);
+
+        return true;
+    }
+}
+
+}  // namespace core
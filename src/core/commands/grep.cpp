@@ -1,13 +1,21 @@
+#include <expected>
+#include <string>
+
 #include "core/buffer.hpp"
 #include "core/event.hpp"
+#include "core/events/buffer_grep_progress.hpp"
 #include "core/events/buffer_loaded.hpp"
+#include "core/events/grep_count_finished.hpp"
 #include "core/grep_options.hpp"
 #include "core/interpreter/command.hpp"
 #include "core/interpreter/interpreter.hpp"
 #include "core/main_view.hpp"
 #include "core/message_line.hpp"
+#include "sys/system.hpp"
 #include "utils/bitflag.hpp"
 #include "utils/buffer.hpp"
+#include "utils/string.hpp"
+#include "utils/units.hpp"
 
 namespace core
 {
@@ -17,17 +25,145 @@ DEFINE_BITFLAG(GrepFlags, uint8_t,
     regex,
     caseInsensitive,
     inverted,
+    multiple,
+    file,
+    count,
 });
 
+// Splits list of patterns separated by '|'. In a regex only the top level
+// ones separate patterns, as matching any of them is what the alternation
+// would do anyway; in a list of literals "\|" stands for '|'
+static utils::Strings splitPatternList(std::string_view list, bool regex)
+{
+    utils::Strings patterns;
+    std::string current;
+    int depth = 0;
+    bool inClass = false;
+
+    for (size_t i = 0; i < list.size(); ++i)
+    {
+        const auto c = list[i];
+
+        if (c == '\\' and i + 1 < list.size())
+        {
+            const auto next = list[++i];
+
+            if (regex or (next != '|' and next != '\\'))
+            {
+                current += c;
+            }
+
+            current += next;
+            continue;
+        }
+
+        if (regex)
+        {
+            if (inClass)
+            {
+                inClass = c != ']';
+            }
+            else if (c == '[')
+            {
+                inClass = true;
+            }
+            else if (c == '(')
+            {
+                ++depth;
+            }
+            else if (c == ')')
+            {
+                --depth;
+            }
+        }
+
+        if (c == '|' and depth == 0 and not inClass)
+        {
+            if (not current.empty())
+            {
+                patterns.push_back(std::move(current));
+            }
+            current.clear();
+            continue;
+        }
+
+        current += c;
+    }
+
+    if (not current.empty())
+    {
+        patterns.push_back(std::move(current));
+    }
+
+    return patterns;
+}
+
+// Patterns are all kept in memory and matched against every line, so a
+// larger list is more likely a wrong file than patterns
+constexpr static size_t MAX_PATTERN_LIST_SIZE = 1_MiB;
+
+static std::expected<utils::Strings, std::string> readPatternList(const std::string& path)
+{
+    utils::Buffer buf;
+
+    auto file = sys::fileOpen(path);
+
+    if (not file) [[unlikely]]
+    {
+        buf << path << ": cannot open: " << sys::errorDescribe(file.error());
+        return std::unexpected(buf.str());
+    }
+
+    const auto size = file->size;
+
+    if (size > MAX_PATTERN_LIST_SIZE) [[unlikely]]
+    {
+        sys::fileClose(*file);
+        buf << path << ": pattern list has " << size << " B, which is more than the limit of " << MAX_PATTERN_LIST_SIZE / MiB << " MiB";
+        return std::unexpected(buf.str());
+    }
+
+    std::string text(size, '\0');
+
+    const auto result = sys::fileRead(*file, text.data(), 0, size);
+
+    sys::fileClose(*file);
+
+    if (not result) [[unlikely]]
+    {
+        buf << path << ": cannot read: " << sys::errorDescribe(result.error());
+        return std::unexpected(buf.str());
+    }
+
+    text.resize(*result);
+
+    auto patterns = text | utils::splitBy("\n");
+
+    for (auto& pattern : patterns)
+    {
+        if (pattern.ends_with('\r'))
+        {
+            pattern.pop_back();
+        }
+    }
+
+    std::erase_if(patterns, [](const auto& pattern){ return pattern.empty(); });
+
+    return patterns;
+}
+
 DEFINE_COMMAND(grep)
 {
-    HELP() = "grep current buffer";
+    HELP() = "grep current buffer; with -m pattern is a list of patterns separated by '|', with -f a file with one per line; with -n matching lines are only counted";
 
     FLAGS()
     {
         return {
             {"c", GrepFlags::caseInsensitive},
+            {"f", GrepFlags::file},
             {"i", GrepFlags::inverted},
+            {"m", GrepFlags::multiple},
+            {"n", GrepFlags::count},
             {"r", GrepFlags::regex},
         };
     }
@@ -51,6 +187,14 @@ DEFINE_COMMAND(grep)
             return false;
         }
 
+        auto parentBuffer = parentWindow->buffer();
+
+        if (not parentWindow->loaded() or not parentBuffer or parentBuffer->isLoading())
+        {
+            context.messageLine.error() << "Buffer is still loading";
+            return false;
+        }
+
         auto pattern = *args[0].string();
 
         GrepOptions options;
@@ -72,6 +216,52 @@ DEFINE_COMMAND(grep)
             optionsString += 'i';
         }
 
+        std::string patterns;
+
+        if (flags[GrepFlags::file] or flags[GrepFlags::multiple])
+        {
+            utils::Strings list;
+
+            if (flags[GrepFlags::file])
+            {
+                auto result = readPatternList(pattern);
+
+                if (not result) [[unlikely]]
+                {
+                    context.messageLine.error() << result.error();
+                    return false;
+                }
+
+                list = std::move(*result);
+            }
+            else
+            {
+                list = splitPatternList(pattern, options.regex);
+            }
+
+            if (list.empty())
+            {
+                context.messageLine.error() << "No patterns given in: " << pattern;
+                return false;
+            }
+
+            // Lines never contain newlines, so they're safe as separators
+            for (const auto& p : list)
+            {
+                patterns += p;
+                patterns += '\n';
+            }
+
+            patterns.pop_back();
+
+            options.multiple = true;
+            optionsString += flags[GrepFlags::file] ? 'f' : 'm';
+        }
+        else
+        {
+            patterns = pattern;
+        }
+
         utils::Buffer buf;
 
         buf << pattern;
@@ -81,15 +271,39 @@ DEFINE_COMMAND(grep)
             buf << " [" << optionsString << ']';
         }
 
+        if (flags[GrepFlags::count])
+        {
+            if (parentBuffer->isCounting())
+            {
+                context.messageLine.error() << "Count is already running";
+                return false;
+            }
+
+            parentBuffer->count(
+                patterns,
+                options,
+                context,
+                [&context, patterns, name = buf.str()](GrepCountOrError result)
+                {
+                    sendEvent<events::GrepCountFinished>(InputSource::internal, context, std::move(result), patterns, name);
+                });
+
+            return true;
+        }
+
         auto& newWindow = context.mainView.createWindow(buf.str(), MainView::Parent::currentWindow, context);
 
         auto newBuffer = newWindow.buffer();
 
         newBuffer->grep(
-            std::move(pattern),
+            std::move(patterns),
             options,
             parentWindow->bufferId(),
             context,
+            [&newWindow, &context](GrepProgress progress)
+            {
+                sendEvent<events::BufferGrepProgress>(InputSource::internal, context, std::move(progress), newWindow);
+            },
             [&newWindow, &context, bufferName = buf.str()](TimeOrError result)
             {
                 sendEvent<events::BufferLoaded>(InputSource::internal, context, std::move(result), newWindow);
@@ -118,6 +332,10 @@ bool grep(const std::string& pattern, const GrepOptions& options, Context& conte
     {
         command += "-i ";
     }
+    if (options.multiple)
+    {
+        command += "-m ";
+    }
 
     command += '\"';
     command += pattern;
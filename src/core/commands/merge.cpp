@@ -0,0 +1,98 @@
+#include "core/buffer.hpp"
+#include "core/event.hpp"
+#include "core/events/buffer_loaded.hpp"
+#include "core/interpreter/command.hpp"
+#include "core/main_view.hpp"
+#include "core/message_line.hpp"
+#include "utils/bitflag.hpp"
+
+namespace core
+{
+
+DEFINE_BITFLAG(MergeFlags, uint8_t,
+{
+    mmap,
+    read,
+});
+
+DEFINE_COMMAND(merge)
+{
+    HELP() = "open files with lines interleaved by timestamps; -m maps them, -r reads them with pread, otherwise chosen by filesystem";
+
+    FLAGS()
+    {
+        return {
+            {"m", MergeFlags::mmap},
+            {"r", MergeFlags::read},
+        };
+    }
+
+    ARGUMENTS()
+    {
+        return {
+            {Type::string, "path"},
+            {Type::variadic, "paths"},
+        };
+    };
+
+    EXECUTOR()
+    {
+        MergeFlags flags(flagsMask);
+
+        if (flags[MergeFlags::mmap] and flags[MergeFlags::read]) [[unlikely]]
+        {
+            context.messageLine.error() << "Flags -m and -r are exclusive";
+            return false;
+        }
+
+        if (args.size() > Buffer::MAX_MERGED_FILES) [[unlikely]]
+        {
+            context.messageLine.error() << "At most " << Buffer::MAX_MERGED_FILES << " files can be merged";
+            return false;
+        }
+
+        const auto backend = flags[MergeFlags::mmap]
+            ? FileBackend::mmap
+            : flags[MergeFlags::read]
+                ? FileBackend::read
+                : FileBackend::automatic;
+
+        std::vector<std::string> paths;
+
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            auto path = args[i].string();
+
+            if (not path) [[unlikely]]
+            {
+                context.messageLine.error() << "Argument " << i << "; expected " << Type::string << ", got " << args[i].type();
+                return false;
+            }
+
+            paths.emplace_back(std::move(*path));
+        }
+
+        std::string name;
+
+        for (const auto& path : paths)
+        {
+            name += name.empty() ? "" : " + ";
+            name += path;
+        }
+
+        auto& newWindow = context.mainView.createWindow(std::move(name), MainView::Parent::root, context);
+
+        newWindow.buffer()->merge(
+            std::move(paths),
+            backend,
+            context,
+            [&newWindow, &context](TimeOrError result)
+            {
+                sendEvent<events::BufferLoaded>(InputSource::internal, context, std::move(result), newWindow);
+            });
+
+        return true;
+    }
+}
+
+}  // namespace core
@@ -3,22 +3,36 @@
 #include "core/alias.hpp"
 #include "core/buffer.hpp"
 #include "core/event.hpp"
+#include "core/events/buffer_load_progress.hpp"
 #include "core/events/buffer_loaded.hpp"
 #include "core/interpreter/command.hpp"
 #include "core/interpreter/interpreter.hpp"
 #include "core/main_view.hpp"
+#include "core/message_line.hpp"
+#include "utils/bitflag.hpp"
 #include "utils/buffer.hpp"
 
 namespace core
 {
 
+DEFINE_BITFLAG(OpenFlags, uint8_t,
+{
+    mmap,
+    read,
+    follow,
+});
+
 DEFINE_COMMAND(open)
 {
-    HELP() = "open a file";
+    HELP() = "open a file; -m maps it, -r reads it with pread, otherwise chosen by filesystem; -f follows it once loaded";
 
     FLAGS()
     {
-        return {};
+        return {
+            {"f", OpenFlags::follow},
+            {"m", OpenFlags::mmap},
+            {"r", OpenFlags::read},
+        };
     }
 
     ARGUMENTS()
@@ -30,6 +44,20 @@ DEFINE_COMMAND(open)
 
     EXECUTOR()
     {
+        OpenFlags flags(flagsMask);
+
+        if (flags[OpenFlags::mmap] and flags[OpenFlags::read]) [[unlikely]]
+        {
+            context.messageLine.error() << "Flags -m and -r are exclusive";
+            return false;
+        }
+
+        const auto backend = flags[OpenFlags::mmap]
+            ? FileBackend::mmap
+            : flags[OpenFlags::read]
+                ? FileBackend::read
+                : FileBackend::automatic;
+
         auto path = *args[0].string();
 
         auto& newWindow = context.mainView.createWindow(path, MainView::Parent::root, context);
@@ -38,10 +66,15 @@ DEFINE_COMMAND(open)
 
         newBuffer->load(
             std::move(path),
+            backend,
             context,
-            [&newWindow, &context](TimeOrError result)
+            [&newWindow, &context](LoadProgress progress)
+            {
+                sendEvent<events::BufferLoadProgress>(InputSource::internal, context, std::move(progress), newWindow);
+            },
+            [&newWindow, &context, follow = flags[OpenFlags::follow]](TimeOrError result)
             {
-                sendEvent<events::BufferLoaded>(InputSource::internal, context, std::move(result), newWindow);
+                sendEvent<events::BufferLoaded>(InputSource::internal, context, std::move(result), newWindow, follow);
             });
 
         return true;
@@ -53,10 +86,10 @@ DEFINE_ALIAS(e, open);
 namespace commands
 {
 
-bool open(const std::string& path, Context& context)
+bool open(const std::string& path, Context& context, bool follow)
 {
     utils::Buffer buf;
-    buf << open::Command::name << " \"" << path << "\"";
+    buf << open::Command::name << (follow ? " -f" : "") << " \"" << path << "\"";
     return interpreter::execute(buf.str(), context);
 }
 
@@ -7,6 +7,6 @@
 namespace core::commands
 {
 
-bool open(const std::string& path, Context& context);
+bool open(const std::string& path, Context& context, bool follow = false);
 
 }  // namespace core::commands
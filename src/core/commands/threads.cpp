@@ -0,0 +1,36 @@
+#include "core/interpreter/command.hpp"
+#include "core/message_line.hpp"
+#include "core/thread.hpp"
+#include "utils/buffer.hpp"
+
+namespace core
+{
+
+DEFINE_COMMAND(threads)
+{
+    HELP() = "print thread pool statistics";
+
+    FLAGS()
+    {
+        return {};
+    }
+
+    ARGUMENTS()
+    {
+        return {};
+    }
+
+    EXECUTOR()
+    {
+        const auto stats = threadPoolStats();
+
+        context.messageLine.info() << "workers: " << stats.workers << "; tasks: " << stats.tasks
+            << "; queued: " << stats.queued << " (max " << stats.maxQueued << "); latency: "
+            << (stats.averageLatency * 1000 | utils::precision(3)) << " ms avg, "
+            << (stats.maxLatency * 1000 | utils::precision(3)) << " ms max";
+
+        return true;
+    }
+}
+
+}  // namespace core
@@ -105,9 +105,17 @@ Config::Config()
     : maxThreads{hardwareThreadCount(), 0, hardwareThreadCount()}
     , linesPerThread{5000000, 0, LONG_MAX}
     , bytesPerThread{1_GiB, 0, LONG_MAX}
+    , indexCache{true}
+    , indexCacheMinSize{64_MiB, 0, LONG_MAX}
+    , indexCacheSize{2_GiB, 0, LONG_MAX}
+    , grepCacheSize{256_MiB, 0, LONG_MAX}
+    , prefetch{false}
+    , timestampFormat{"none"}
+    , timeJump{1, 1, LONG_MAX}
     , showLineNumbers{false}
     , absoluteLineNumbers{false}
     , highlightSearch{true}
+    , ignoreCase{false}
     , scrollJump{5, 0, 16}
     , scrollOff{3, 0, 8}
     , fastMoveLen{16, 0, UCHAR_MAX}
@@ -123,11 +131,19 @@ Config::Config()
     initialized = true;
 
     Symbols::add("maxThreads", maxThreads.setHelp("Number of threads used for parallel grep"));
-    Symbols::add("linesPerThread", linesPerThread.setHelp("Number of lines processed per thread in parallel grep"));
-    Symbols::add("bytesPerThread", bytesPerThread.setHelp("Number of bytes processed per thread in parallel file loading"));
+    Symbols::add("linesPerThread", linesPerThread.setHelp("Number of lines per thread in parallel grep; threads take lines in smaller chunks, 8 per thread, and as many threads run as there are chunks, up to maxThreads"));
+    Symbols::add("bytesPerThread", bytesPerThread.setHelp("Number of bytes per thread in parallel file loading; threads take bytes in smaller chunks, 8 per thread, and as many threads run as there are chunks, up to maxThreads"));
+    Symbols::add("indexCache", indexCache.setHelp("Cache line indexes of loaded files on disk"));
+    Symbols::add("indexCacheMinSize", indexCacheMinSize.setHelp("Minimal size of a file for which line index is cached"));
+    Symbols::add("indexCacheSize", indexCacheSize.setHelp("Disk space for cached line indexes; least recently used ones are removed when it's exceeded"));
+    Symbols::add("grepCacheSize", grepCacheSize.setHelp("Amount of memory for matches of recent greps kept to show them again without grepping; 0 disables it"));
+    Symbols::add("prefetch", prefetch.setHelp("Start reading next block of file in the background when scanning it in loading and grep"));
+    Symbols::add("timestampFormat", timestampFormat.setHelp("Format of line timestamps indexed when loading a file: none, auto, iso, syslog or epoch"));
+    Symbols::add("timeJump", timeJump.setHelp("Number of minutes to jump by in time"));
     Symbols::add("showLineNumbers", showLineNumbers.setFlag(ConfigFlags::reloadAllWindows).setHelp("Show line numbers on the left"));
     Symbols::add("absoluteLineNumbers", absoluteLineNumbers.setHelp("Print file absolute line numbers"));
     Symbols::add("highlightSearch", highlightSearch.setFlag(ConfigFlags::reloadAllWindows).setHelp("Highlight searched text"));
+    Symbols::add("ignoreCase", ignoreCase.setHelp("Ignore case of ASCII letters in search"));
     Symbols::add("scrollJump", scrollJump.setHelp("Minimal number of lines to scroll when the cursor gets off the screen"));
     Symbols::add("scrollOff", scrollOff.setHelp("Minimal number of screen lines to keep above and below the cursor"));
     Symbols::add("fastMoveLen", fastMoveLen.setHelp("Amount of characters to jump in fast forward/backward movement"));
@@ -130,9 +130,17 @@ struct Config : utils::Immobile
     Size   maxThreads;
     Size   linesPerThread;
     Size   bytesPerThread;
+    Bool   indexCache;
+    Size   indexCacheMinSize;
+    Size   indexCacheSize;
+    Size   grepCacheSize;
+    Bool   prefetch;
+    String timestampFormat;
+    Size   timeJump;
     Bool   showLineNumbers;
     Bool   absoluteLineNumbers;
     Bool   highlightSearch;
+    Bool   ignoreCase;
     Uint8  scrollJump;
     Uint8  scrollOff;
     Uint8  fastMoveLen;
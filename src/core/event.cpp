@@ -23,7 +23,11 @@ utils::Buffer& operator<<(utils::Buffer& buf, Event::Type type)
     switch (type)
     {
         PRINT(BufferLoaded);
+        PRINT(BufferLoadProgress);
+        PRINT(BufferGrepProgress);
+        PRINT(BufferFollowUpdate);
         PRINT(SearchFinished);
+        PRINT(GrepCountFinished);
         PRINT(KeyPress);
         PRINT(Resize);
         case Event::Type::_Size:
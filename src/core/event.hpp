@@ -17,7 +17,11 @@ struct Event
     enum class Type : uint8_t
     {
         BufferLoaded,
+        BufferLoadProgress,
+        BufferGrepProgress,
+        BufferFollowUpdate,
         SearchFinished,
+        GrepCountFinished,
         KeyPress,
         Resize,
         _Size
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "core/buffer.hpp"
+#include "core/buffers.hpp"
+#include "core/event.hpp"
+
+namespace core::events
+{
+
+struct BufferFollowUpdate : Event
+{
+    constexpr BufferFollowUpdate(FollowUpdate u, BufferId id)
+        : Event(Type::BufferFollowUpdate)
+        , update(std::move(u))
+        , bufferId(id)
+    {
+    }
+
+    // Handlers get a const event, but the update is moved out of it
+    mutable FollowUpdate update;
+    BufferId             bufferId;
+};
+
+}  // namespace core::events
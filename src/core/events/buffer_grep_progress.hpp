@@ -0,0 +1,24 @@
+#pragma once
+
+#include "core/buffer.hpp"
+#include "core/event.hpp"
+#include "core/window_node.hpp"
+
+namespace core::events
+{
+
+struct BufferGrepProgress : Event
+{
+    constexpr BufferGrepProgress(GrepProgress p, WindowNode& n)
+        : Event(Type::BufferGrepProgress)
+        , progress(std::move(p))
+        , node(n)
+    {
+    }
+
+    // Handlers get a const event, but matches are moved out of it
+    mutable GrepProgress progress;
+    WindowNode&          node;
+};
+
+}  // namespace core::events
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "core/buffer.hpp"
+#include "core/event.hpp"
+#include "core/window_node.hpp"
+
+namespace core::events
+{
+
+struct BufferLoadProgress : Event
+{
+    constexpr BufferLoadProgress(LoadProgress p, WindowNode& n)
+        : Event(Type::BufferLoadProgress)
+        , progress(std::move(p))
+        , node(n)
+    {
+    }
+
+    // Handlers get a const event, but the index chunk is moved out of it
+    mutable LoadProgress progress;
+    WindowNode&          node;
+};
+
+}  // namespace core::events
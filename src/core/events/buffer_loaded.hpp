@@ -9,15 +9,17 @@ namespace core::events
 
 struct BufferLoaded : Event
 {
-    constexpr BufferLoaded(TimeOrError r, WindowNode& n)
+    constexpr BufferLoaded(TimeOrError r, WindowNode& n, bool f = false)
         : Event(Type::BufferLoaded)
         , result(r)
         , node(n)
+        , follow(f)
     {
     }
 
     TimeOrError result;
     WindowNode& node;
+    bool        follow;
 };
 
 }  // namespace core::events
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+#include "core/buffer.hpp"
+#include "core/event.hpp"
+
+namespace core::events
+{
+
+struct GrepCountFinished : Event
+{
+    constexpr GrepCountFinished(GrepCountOrError r, std::string p, std::string n)
+        : Event(Type::GrepCountFinished)
+        , result(std::move(r))
+        , patterns(std::move(p))
+        , name(std::move(n))
+    {
+    }
+
+    GrepCountOrError result;
+    std::string      patterns;
+    std::string      name;
+};
+
+}  // namespace core::events
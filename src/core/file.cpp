@@ -1,18 +1,129 @@
 #include "file.hpp"
 
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <expected>
+#include <mutex>
+#include <string_view>
 
 #include "core/assert.hpp"
+#include "core/gzip.hpp"
 #include "sys/system.hpp"
 #include "utils/buffer.hpp"
+#include "utils/math.hpp"
+#include "utils/units.hpp"
 
 namespace core
 {
 
+// Shared by all copies of a file; each copy has its own reader, which holds
+// the block it has decompressed last
+struct File::Compressed final
+{
+    Compressed(sys::Mapping input, bool mapped)
+        : input(input)
+        , mapped(mapped)
+        , index(input.ptrAt<const char*>(0), input.len)
+    {
+    }
+
+    ~Compressed()
+    {
+        if (mapped)
+        {
+            sys::unmap(input);
+        }
+        else
+        {
+            std::free(input.ptr);
+        }
+    }
+
+    sys::Mapping input;
+    bool         mapped;
+    GzipIndex    index;
+};
+
+// On 64-bit address space is not an issue, so file is mapped whole, once for
+// all copies, and nothing is remapped when reading from different places
+constexpr static bool MAP_WHOLE_FILE = sizeof(void*) >= 8;
+
+struct File::SharedMapping final
+{
+    SharedMapping(sys::Mapping mapping)
+        : mapping(mapping)
+        , refCount(1)
+    {
+    }
+
+    ~SharedMapping()
+    {
+        sys::unmap(mapping);
+    }
+
+    void acquire()
+    {
+        refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release()
+    {
+        if (refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this;
+        }
+    }
+
+    sys::Mapping     mapping;
+    std::atomic_uint refCount;
+};
+
+// Mapping of the whole file shared by all copies. If file grows, mapping
+// of the new size replaces it; the old one is unmapped once no copy uses it
+struct File::Mappings final
+{
+    ~Mappings()
+    {
+        if (current)
+        {
+            current->release();
+        }
+    }
+
+    std::mutex     lock;
+    SharedMapping* current = nullptr;
+};
+
+// Used with FileBackend::read; aligning reads to pages lets the kernel copy
+// whole pages from page cache
+constexpr static size_t READ_ALIGNMENT = 4_KiB;
+
+struct File::ReadBuffer final
+{
+    ~ReadBuffer()
+    {
+        std::free(data);
+    }
+
+    char*  data = nullptr;
+    size_t capacity = 0;
+};
+
 File::File()
     : mFile(std::unexpected(0))
     , mMapping{.ptr = nullptr, .offset = 0, .len = 0}
     , mRefCount(nullptr)
+    , mCompressed(nullptr)
+    , mReader(nullptr)
+    , mMappings(nullptr)
+    , mShared(nullptr)
+    , mReadBuffer(nullptr)
+    , mBackend(FileBackend::mmap)
+    , mAccessPattern(sys::AccessPattern::normal)
+    , mPrefetch(false)
 {
 }
 
@@ -25,8 +136,17 @@ File::File(const File& other)
     : mFile(other.mFile)
     , mMapping{.ptr = nullptr, .offset = 0, .len = 0}
     , mRefCount(other.mRefCount)
+    , mCompressed(other.mCompressed)
+    , mReader(nullptr)
+    , mMappings(other.mMappings)
+    , mShared(nullptr)
+    , mReadBuffer(nullptr)
+    , mBackend(other.mBackend)
+    , mAccessPattern(other.mAccessPattern)
+    , mPrefetch(other.mPrefetch)
 {
-    ++*mRefCount;
+    mRefCount->fetch_add(1, std::memory_order_relaxed);
+    share(other);
 }
 
 File& File::operator=(const File& other)
@@ -35,7 +155,13 @@ File& File::operator=(const File& other)
     mFile = other.mFile;
     assert(other.mRefCount);
     mRefCount = other.mRefCount;
-    ++*mRefCount;
+    mCompressed = other.mCompressed;
+    mMappings = other.mMappings;
+    mBackend = other.mBackend;
+    mAccessPattern = other.mAccessPattern;
+    mPrefetch = other.mPrefetch;
+    mRefCount->fetch_add(1, std::memory_order_relaxed);
+    share(other);
     return *this;
 }
 
@@ -53,7 +179,7 @@ static std::string getErrorMessage(const sys::File& file, size_t blockSize, size
     return buf.str();
 }
 
-std::expected<bool, std::string> File::open(std::string path)
+std::expected<bool, std::string> File::open(std::string path, FileBackend backend)
 {
     mFile = sys::fileOpen(path);
 
@@ -62,19 +188,292 @@ std::expected<bool, std::string> File::open(std::string path)
         return std::unexpected(getErrorMessage(path, mFile.error()));
     }
 
-    mRefCount = new int(1);
+    mRefCount = new std::atomic_uint(1);
+
+    if (backend == FileBackend::automatic)
+    {
+        backend = sys::fileIsRemote(*mFile) ? FileBackend::read : FileBackend::mmap;
+    }
+
+    mBackend = backend;
+
+    if (auto error = detectCompression(); error) [[unlikely]]
+    {
+        return std::unexpected(getErrorMessage(path, error));
+    }
+
+    if (MAP_WHOLE_FILE and mBackend == FileBackend::mmap and not mCompressed)
+    {
+        mMappings = new Mappings;
+    }
 
     return true;
 }
 
+sys::Error File::detectCompression()
+{
+    constexpr static uint8_t GZIP_MAGIC[] = {0x1f, 0x8b};
+
+    const auto& file = *mFile;
+
+    if (file.size < sizeof(GZIP_MAGIC))
+    {
+        return 0;
+    }
+
+    char magic[sizeof(GZIP_MAGIC)];
+
+    if (auto result = sys::fileRead(file, magic, 0, sizeof(magic)); not result) [[unlikely]]
+    {
+        return result.error();
+    }
+    else if (*result < sizeof(magic) or std::memcmp(magic, GZIP_MAGIC, sizeof(magic)))
+    {
+        return 0;
+    }
+
+    // Compressed data is kept whole in memory, as it's read by many readers
+    // from many places
+    sys::Mapping input{.ptr = nullptr, .offset = 0, .len = 0};
+
+    if (mBackend == FileBackend::read)
+    {
+        input.ptr = std::malloc(file.size);
+
+        if (not input.ptr) [[unlikely]]
+        {
+            return ENOMEM;
+        }
+
+        auto result = sys::fileRead(file, static_cast<char*>(input.ptr), 0, file.size);
+
+        if (not result) [[unlikely]]
+        {
+            std::free(input.ptr);
+            return result.error();
+        }
+
+        input.len = *result;
+    }
+    else if (auto error = sys::remap(file, input, 0, file.size)) [[unlikely]]
+    {
+        return error;
+    }
+
+    mCompressed = new Compressed(input, mBackend != FileBackend::read);
+
+    return 0;
+}
+
 std::expected<bool, std::string> File::remap(size_t offset, size_t len)
 {
-    if (const auto error = sys::remap(mFile.value(), mMapping, offset, len)) [[unlikely]]
+    if (mCompressed)
+    {
+        if (not mReader)
+        {
+            mReader = new GzipReader(mCompressed->index);
+        }
+
+        auto result = mReader->read(offset, len);
+
+        if (not result) [[unlikely]]
+        {
+            utils::Buffer buf;
+            buf << mFile->path << ": cannot decompress block of size " << len << " at offset " << offset << ": " << result.error();
+            return std::unexpected(buf.str());
+        }
+
+        // Everything reader has decompressed is mapped, so that preceding
+        // lines within it are read without decompressing them again
+        const auto buffer = mReader->buffer();
+
+        mMapping = sys::Mapping{
+            .ptr = const_cast<char*>(buffer.data()),
+            .offset = mReader->bufferOffset(),
+            .len = buffer.size()
+        };
+
+        return true;
+    }
+
+    const auto& file = mFile.value();
+
+    if (mBackend == FileBackend::read)
+    {
+        if (auto result = readBlock(offset, len); not result) [[unlikely]]
+        {
+            return result;
+        }
+    }
+    else if (mMappings)
     {
-        auto errorMessage = getErrorMessage(mFile.value(), len, offset, error);
+        if (offset + len > mMapping.len)
+        {
+            if (const auto error = mapWhole(offset + len)) [[unlikely]]
+            {
+                auto errorMessage = getErrorMessage(file, len, offset, error);
+                return std::unexpected(std::move(errorMessage));
+            }
+        }
+        advise(offset, len);
+    }
+    else if (const auto error = sys::remap(file, mMapping, offset, len, mAccessPattern)) [[unlikely]]
+    {
+        auto errorMessage = getErrorMessage(file, len, offset, error);
         return std::unexpected(std::move(errorMessage));
     }
 
+    if (mPrefetch and mAccessPattern == sys::AccessPattern::sequential and offset + len < file.size)
+    {
+        sys::prefetch(file, offset + len, utils::min(len, file.size - offset - len));
+    }
+
+    return true;
+}
+
+std::expected<bool, std::string> File::readBlock(size_t offset, size_t len)
+{
+    const auto& file = mFile.value();
+    const auto start = offset & ~(READ_ALIGNMENT - 1);
+    const auto end = (offset + len + READ_ALIGNMENT - 1) & ~(READ_ALIGNMENT - 1);
+    const auto readLen = end - start;
+
+    const auto error =
+        [&](std::string_view reason)
+        {
+            utils::Buffer buf;
+            buf << file.path << ": cannot read block of size " << len << " at offset " << offset << ": " << reason;
+            return std::unexpected(buf.str());
+        };
+
+    if (not mReadBuffer)
+    {
+        mReadBuffer = new ReadBuffer;
+    }
+
+    if (mReadBuffer->capacity < readLen)
+    {
+        std::free(mReadBuffer->data);
+
+        mReadBuffer->data = static_cast<char*>(std::aligned_alloc(READ_ALIGNMENT, readLen));
+        mReadBuffer->capacity = mReadBuffer->data ? readLen : 0;
+    }
+
+    // Block which was read is lost either way
+    mMapping = sys::Mapping{.ptr = nullptr, .offset = 0, .len = 0};
+
+    if (not mReadBuffer->data) [[unlikely]]
+    {
+        return error(sys::errorDescribe(ENOMEM));
+    }
+
+    // Last page of file is usually not whole, so less than readLen is fine
+    auto result = sys::fileRead(file, mReadBuffer->data, start, readLen);
+
+    if (not result) [[unlikely]]
+    {
+        return error(sys::errorDescribe(result.error()));
+    }
+
+    if (*result < offset + len - start) [[unlikely]]
+    {
+        return error("file has been truncated");
+    }
+
+    mMapping = sys::Mapping{.ptr = mReadBuffer->data, .offset = start, .len = *result};
+
+    return true;
+}
+
+sys::Error File::mapWhole(size_t minSize)
+{
+    std::lock_guard lock(mMappings->lock);
+
+    auto current = mMappings->current;
+
+    // Some other copy might have already mapped enough
+    if (not current or current->mapping.len < minSize)
+    {
+        const auto& file = mFile.value();
+        sys::Mapping mapping{.ptr = nullptr, .offset = 0, .len = 0};
+
+        // Hints are applied by each copy only to the part it reads
+        if (const auto error = sys::remap(file, mapping, 0, utils::max(minSize, file.size))) [[unlikely]]
+        {
+            return error;
+        }
+
+        if (current)
+        {
+            current->release();
+        }
+
+        current = mMappings->current = new SharedMapping(mapping);
+    }
+
+    current->acquire();
+
+    if (mShared)
+    {
+        mShared->release();
+    }
+
+    mShared = current;
+    mMapping = current->mapping;
+
+    return 0;
+}
+
+void File::share(const File& other)
+{
+    if (other.mShared)
+    {
+        other.mShared->acquire();
+        mShared = other.mShared;
+        mMapping = other.mShared->mapping;
+    }
+}
+
+void File::advise(size_t offset, size_t len)
+{
+    if (mShared and mAccessPattern != sys::AccessPattern::normal and offset < mMapping.len)
+    {
+        sys::advise(mMapping, offset, utils::min(len, mMapping.len - offset), mAccessPattern);
+    }
+}
+
+void File::setAccessPattern(sys::AccessPattern pattern, bool prefetch)
+{
+    mAccessPattern = pattern;
+    mPrefetch = prefetch;
+}
+
+std::expected<bool, std::string> File::refresh()
+{
+    if (const auto error = sys::fileRefresh(mFile.value())) [[unlikely]]
+    {
+        utils::Buffer buf;
+        buf << mFile->path << ": cannot stat: " << sys::errorDescribe(error);
+        return std::unexpected(buf.str());
+    }
+
+    return true;
+}
+
+std::expected<bool, std::string> File::buildCompressionIndex(const std::atomic_bool& stopFlag, const utils::FunctionRef<void(std::string_view)>* output)
+{
+    if (not mCompressed)
+    {
+        return true;
+    }
+
+    if (auto result = mCompressed->index.build(stopFlag, GZIP_SPAN, output); not result) [[unlikely]]
+    {
+        utils::Buffer buf;
+        buf << mFile->path << ": cannot decompress: " << result.error();
+        return std::unexpected(buf.str());
+    }
+
     return true;
 }
 
@@ -85,17 +484,61 @@ const std::string& File::path() const
 
 size_t File::size() const
 {
-    return mFile->size;
+    return mCompressed ? mCompressed->index.size() : mFile->size;
+}
+
+const sys::FileIdentity& File::identity() const
+{
+    return mFile->identity;
+}
+
+bool File::isCompressed() const
+{
+    return mCompressed;
+}
+
+FileBackend File::backend() const
+{
+    return mBackend;
 }
 
 void File::free()
 {
-    sys::unmap(mMapping);
-    if (mFile and --*mRefCount == 0)
+    if (mReader)
     {
+        delete mReader;
+        mReader = nullptr;
+        mMapping = sys::Mapping{.ptr = nullptr, .offset = 0, .len = 0};
+    }
+    else if (mReadBuffer)
+    {
+        delete mReadBuffer;
+        mReadBuffer = nullptr;
+        mMapping = sys::Mapping{.ptr = nullptr, .offset = 0, .len = 0};
+    }
+    else if (mShared)
+    {
+        mShared->release();
+        mShared = nullptr;
+        mMapping = sys::Mapping{.ptr = nullptr, .offset = 0, .len = 0};
+    }
+    else
+    {
+        sys::unmap(mMapping);
+    }
+
+    // Copies are destroyed concurrently by workers, so the last one has to
+    // see everything done by the others before freeing what they shared
+    if (mFile and mRefCount->fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete mCompressed;
+        delete mMappings;
         sys::fileClose(*mFile);
         delete mRefCount;
     }
+
+    mCompressed = nullptr;
+    mMappings = nullptr;
 }
 
 }  // namespace core
@@ -1,14 +1,36 @@
 #pragma once
 
+#include <atomic>
 #include <expected>
 #include <string>
+#include <string_view>
 
 #include "sys/file.hpp"
 #include "sys/mapping.hpp"
+#include "utils/function_ref.hpp"
 
 namespace core
 {
 
+struct GzipReader;
+
+enum class FileBackend : char
+{
+    automatic,  // read on network and FUSE filesystems, mmap elsewhere
+    mmap,
+    read,
+};
+
+// Read-only file accessed through mappings of its blocks. On 64-bit the
+// whole file is mapped once and the mapping is shared by all copies, so
+// remap only extends it if file has grown.
+//
+// With FileBackend::read, blocks are read with pread into a buffer of each
+// copy instead, which avoids slow page faults of network filesystems and
+// SIGBUS if file is truncated while it's read.
+//
+// Gzip compressed files are supported transparently - offsets, sizes and
+// mapped blocks refer to decompressed data, which is decompressed on demand
 struct File final
 {
     File();
@@ -17,14 +39,44 @@ struct File final
     File(const File& other);
     File& operator=(const File& other);
 
-    std::expected<bool, std::string> open(std::string path);
+    std::expected<bool, std::string> open(std::string path, FileBackend backend = FileBackend::automatic);
     std::expected<bool, std::string> remap(size_t offset, size_t len);
+
+    // Sets how following remaps are going to be read; copies inherit it.
+    // With prefetch, reading of the block which follows the one mapped for
+    // a sequential scan is started in the background. Compressed data is
+    // decompressed from memory, so hints don't apply to it
+    void setAccessPattern(sys::AccessPattern pattern, bool prefetch = false);
+
+    // Applies access pattern to a range which is going to be read without
+    // remapping, as it's already within the mapping shared with other copies
+    void advise(size_t offset, size_t len);
+
+    // Reads again size and identity of the opened file; it's not propagated
+    // to other copies
+    std::expected<bool, std::string> refresh();
+
+    // Decompresses whole file once to make random access possible; must be
+    // done for compressed file before anything else is read from it. The
+    // decompressed data is passed to output, if given, on the way
+    std::expected<bool, std::string> buildCompressionIndex(const std::atomic_bool& stopFlag, const utils::FunctionRef<void(std::string_view)>* output = nullptr);
+
     const std::string& path() const;
     size_t size() const;
+    const sys::FileIdentity& identity() const;
+    bool isCompressed() const;
+    FileBackend backend() const;
 
     constexpr bool isAreaMapped(size_t start, size_t len) const
     {
-        return start >= mMapping.offset and len + start < mMapping.len + mMapping.offset;
+        return start >= mMapping.offset and len + start <= mMapping.len + mMapping.offset;
+    }
+
+    // Tells if offset precedes the block mapped last, i.e. file is read
+    // backwards
+    constexpr bool isBeforeMapping(size_t offset) const
+    {
+        return mMapping.len and offset < mMapping.offset;
     }
 
     constexpr const char* at(size_t offset)
@@ -33,11 +85,29 @@ struct File final
     }
 
 private:
+    struct Compressed;
+    struct Mappings;
+    struct ReadBuffer;
+    struct SharedMapping;
+
+    sys::Error detectCompression();
+    std::expected<bool, std::string> readBlock(size_t offset, size_t len);
+    sys::Error mapWhole(size_t minSize);
+    void share(const File& other);
     void free();
 
-    sys::MaybeFile mFile;
-    sys::Mapping   mMapping;
-    int*           mRefCount;
+    sys::MaybeFile    mFile;
+    sys::Mapping      mMapping;
+    std::atomic_uint* mRefCount;
+    Compressed*       mCompressed;
+    GzipReader*       mReader;
+    Mappings*         mMappings;
+    SharedMapping*    mShared;
+    ReadBuffer*       mReadBuffer;
+
+    FileBackend        mBackend;
+    sys::AccessPattern mAccessPattern;
+    bool               mPrefetch;
 };
 
 }  // namespace core
@@ -11,6 +11,7 @@ struct Context;
 struct File;
 struct Grepper;
 struct InputState;
+struct LiteralSearch;
 struct MainLoop;
 struct MainPicker;
 struct MainView;
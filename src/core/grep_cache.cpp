@@ -0,0 +1,89 @@
+#include "grep_cache.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace core
+{
+
+// Entries are looked for by scanning all of them, so their number is bounded
+// too, regardless of how little memory they take
+constexpr static size_t MAX_ENTRIES = 64;
+
+struct GrepCacheEntry
+{
+    GrepCacheKey   key;
+    GrepCacheValue value;
+    size_t         size;
+    uint64_t       lastUse;
+};
+
+static std::vector<GrepCacheEntry> entries;
+static size_t memoryUsage;
+static uint64_t useCounter;
+
+static void evict(size_t limit)
+{
+    while (not entries.empty() and (memoryUsage > limit or entries.size() > MAX_ENTRIES))
+    {
+        auto leastRecent = std::ranges::min_element(entries, {}, &GrepCacheEntry::lastUse);
+        memoryUsage -= leastRecent->size;
+        entries.erase(leastRecent);
+    }
+}
+
+GrepCacheValue grepCacheFind(const GrepCacheKey& key)
+{
+    for (auto& entry : entries)
+    {
+        if (entry.key == key)
+        {
+            entry.lastUse = ++useCounter;
+            return entry.value;
+        }
+    }
+    return {};
+}
+
+void grepCacheStore(GrepCacheKey key, GrepCacheValue value, size_t limit)
+{
+    const auto size = value.lines->memoryUsage() + value.bitmap->memoryUsage();
+
+    if (size > limit or grepCacheFind(key).lines.get())
+    {
+        return;
+    }
+
+    entries.push_back(GrepCacheEntry{
+        .key = std::move(key),
+        .value = std::move(value),
+        .size = size,
+        .lastUse = ++useCounter,
+    });
+
+    memoryUsage += size;
+
+    evict(limit);
+}
+
+void grepCacheInvalidate(uint64_t parentVersion)
+{
+    std::erase_if(
+        entries,
+        [parentVersion](const GrepCacheEntry& entry)
+        {
+            if (entry.key.parentVersion == parentVersion)
+            {
+                memoryUsage -= entry.size;
+                return true;
+            }
+            return false;
+        });
+}
+
+size_t grepCacheMemoryUsage()
+{
+    return memoryUsage;
+}
+
+}  // namespace core
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "core/grep_options.hpp"
+#include "core/line.hpp"
+#include "utils/roaring_bitmap.hpp"
+#include "utils/shared_ptr.hpp"
+
+namespace core
+{
+
+using LineRefsPtr = utils::SharedPtr<LineRefs>;
+using LineBitmapPtr = utils::SharedPtr<utils::RoaringBitmap>;
+
+// In-memory cache of matches of recent greps, so that repeating a grep
+// doesn't scan its parent again. Matches are kept for a version of parent
+// buffer, which is unique and changes whenever its lines do, and are shared
+// with buffers showing them, as they're never modified once grep finished.
+// Least recently used entries are evicted if all of them take more than the
+// limit. It must be used on the main thread only
+
+struct GrepCacheKey
+{
+    uint64_t    parentVersion;
+    std::string pattern;
+    GrepOptions options;
+
+    bool operator==(const GrepCacheKey&) const = default;
+};
+
+// Matches of grep, both as line refs and as bitmap of the same lines,
+// together with the literal which lines were prefiltered by before running
+// its regex, if any
+struct GrepCacheValue
+{
+    LineRefsPtr   lines;
+    LineBitmapPtr bitmap;
+    std::string   prefilter;
+};
+
+// Returns value with null lines if there's no entry for key
+GrepCacheValue grepCacheFind(const GrepCacheKey& key);
+
+void grepCacheStore(GrepCacheKey key, GrepCacheValue value, size_t limit);
+
+// Drops entries of parent buffer which has changed or has been closed
+void grepCacheInvalidate(uint64_t parentVersion);
+
+size_t grepCacheMemoryUsage();
+
+}  // namespace core
@@ -8,6 +8,12 @@ struct GrepOptions
     bool regex           = false;
     bool inverted        = false;
     bool caseInsensitive = false;
+
+    // Pattern is a list of patterns separated by newlines, and lines
+    // matching any of them match
+    bool multiple        = false;
+
+    bool operator==(const GrepOptions&) const = default;
 };
 
 }  // namespace core
@@ -34,6 +34,9 @@ bool Grepper::handleKeyPress(KeyPress keyPress, InputSource source, Context& con
             case 'i':
                 options.inverted ^= true;
                 return false;
+            case 'm':
+                options.multiple ^= true;
+                return false;
         }
     }
 
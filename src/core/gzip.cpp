@@ -0,0 +1,394 @@
+#include "gzip.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "utils/math.hpp"
+
+namespace core
+{
+
+// 15 bits window, with gzip header and trailer
+constexpr static int GZIP_WINDOW_BITS = 15 + 16;
+constexpr static int RAW_WINDOW_BITS = -15;
+constexpr static size_t GZIP_TRAILER_SIZE = 8;
+
+// zlib takes sizes as unsigned int, so input and output are split into chunks
+constexpr static size_t MAX_CHUNK = 1_GiB;
+
+static std::string zlibError(const z_stream& stream, int ret)
+{
+    return stream.msg ? std::string("corrupted data: ") + stream.msg : std::string("zlib error: ") + zError(ret);
+}
+
+static bool isGzipMemberAt(const char* data, size_t size, size_t offset)
+{
+    return size - offset >= 2
+        and static_cast<uint8_t>(data[offset]) == 0x1f
+        and static_cast<uint8_t>(data[offset + 1]) == 0x8b;
+}
+
+static void feedInput(z_stream& stream, const char* data, size_t size, size_t offset)
+{
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + offset));
+    stream.avail_in = static_cast<uInt>(utils::min(size - offset, MAX_CHUNK));
+}
+
+static size_t inputOffset(const z_stream& stream, const char* data)
+{
+    return reinterpret_cast<const char*>(stream.next_in) - data;
+}
+
+GzipIndex::GzipIndex(const char* data, size_t size)
+    : mData(data)
+    , mCompressedSize(size)
+    , mSize(0)
+{
+}
+
+std::expected<bool, std::string> GzipIndex::build(const std::atomic_bool& stopFlag, size_t span, const Output* output)
+{
+    z_stream stream{};
+
+    if (auto ret = inflateInit2(&stream, GZIP_WINDOW_BITS); ret != Z_OK) [[unlikely]]
+    {
+        return std::unexpected(zlibError(stream, ret));
+    }
+
+    mCheckpoints.clear();
+
+    auto& first = mCheckpoints.emplace_back();
+    first.in = 0;
+    first.out = 0;
+    first.bits = 0;
+    first.memberStart = true;
+
+    // Output goes round a buffer of window size, so that last 32 KiB of
+    // output needed for a checkpoint is always there
+    uint8_t window[WINDOW_SIZE];
+
+    size_t totalIn = 0;
+    size_t totalOut = 0;
+    size_t last = 0;
+
+    stream.avail_out = 0;
+
+    const auto error =
+        [&stream](std::string message)
+        {
+            inflateEnd(&stream);
+            return std::unexpected(std::move(message));
+        };
+
+    while (true)
+    {
+        if (stopFlag) [[unlikely]]
+        {
+            return error("aborted");
+        }
+
+        if (stream.avail_in == 0)
+        {
+            if (totalIn == mCompressedSize) [[unlikely]]
+            {
+                return error("unexpected end of data");
+            }
+            feedInput(stream, mData, mCompressedSize, totalIn);
+        }
+
+        if (stream.avail_out == 0)
+        {
+            stream.next_out = window;
+            stream.avail_out = WINDOW_SIZE;
+        }
+
+        totalIn += stream.avail_in;
+        totalOut += stream.avail_out;
+
+        const auto outputStart = stream.next_out;
+
+        auto ret = inflate(&stream, Z_BLOCK);
+
+        totalIn -= stream.avail_in;
+        totalOut -= stream.avail_out;
+
+        if (ret == Z_NEED_DICT or ret == Z_DATA_ERROR or ret == Z_MEM_ERROR or ret == Z_STREAM_ERROR) [[unlikely]]
+        {
+            return error(zlibError(stream, ret));
+        }
+
+        if (output and stream.next_out != outputStart)
+        {
+            (*output)(std::string_view(reinterpret_cast<const char*>(outputStart), stream.next_out - outputStart));
+        }
+
+        if (ret == Z_STREAM_END)
+        {
+            // Anything after the last member which doesn't look like another
+            // one is ignored, like gzip does with trailing garbage
+            if (not isGzipMemberAt(mData, mCompressedSize, totalIn))
+            {
+                break;
+            }
+
+            inflateReset(&stream);
+
+            auto& checkpoint = mCheckpoints.emplace_back();
+            checkpoint.in = totalIn;
+            checkpoint.out = totalOut;
+            checkpoint.bits = 0;
+            checkpoint.memberStart = true;
+
+            last = totalOut;
+            continue;
+        }
+
+        // At the end of deflate block, but not the last one
+        if ((stream.data_type & 128) and not (stream.data_type & 64) and totalOut - last >= span)
+        {
+            auto& checkpoint = mCheckpoints.emplace_back();
+            checkpoint.in = totalIn;
+            checkpoint.out = totalOut;
+            checkpoint.bits = stream.data_type & 7;
+            checkpoint.memberStart = false;
+
+            const auto left = stream.avail_out;
+
+            if (left)
+            {
+                std::memcpy(checkpoint.window, window + WINDOW_SIZE - left, left);
+            }
+            if (left < WINDOW_SIZE)
+            {
+                std::memcpy(checkpoint.window + left, window, WINDOW_SIZE - left);
+            }
+
+            last = totalOut;
+        }
+    }
+
+    inflateEnd(&stream);
+
+    mCheckpoints.shrink_to_fit();
+    mSize = totalOut;
+
+    return true;
+}
+
+const GzipIndex::Checkpoint& GzipIndex::closestCheckpoint(size_t offset) const
+{
+    auto it = std::upper_bound(
+        mCheckpoints.begin(),
+        mCheckpoints.end(),
+        offset,
+        [](size_t value, const Checkpoint& checkpoint)
+        {
+            return value < checkpoint.out;
+        });
+
+    return *(it - 1);
+}
+
+GzipReader::GzipReader(const GzipIndex& index)
+    : mIndex(index)
+    , mStream{}
+    , mActive(false)
+    , mRaw(false)
+    , mPosition(0)
+    , mBufferOffset(0)
+    , mBufferLen(0)
+{
+}
+
+GzipReader::~GzipReader()
+{
+    reset();
+}
+
+std::expected<const char*, std::string> GzipReader::read(size_t offset, size_t len)
+{
+    if (offset > mIndex.size() or len > mIndex.size() - offset) [[unlikely]]
+    {
+        return std::unexpected("read past the end of data");
+    }
+
+    if (offset >= mBufferOffset and offset + len <= mBufferOffset + mBufferLen)
+    {
+        return reinterpret_cast<const char*>(mBuffer.data() + offset - mBufferOffset);
+    }
+
+    if (not mActive or offset < mPosition or mIndex.closestCheckpoint(offset).out > mPosition)
+    {
+        if (auto result = seek(offset); not result) [[unlikely]]
+        {
+            return std::unexpected(std::move(result.error()));
+        }
+    }
+
+    // Data preceding offset has to be decompressed anyway, so it's kept
+    // instead of being skipped
+    const auto start = mPosition;
+    const auto total = offset + len - start;
+
+    mBufferLen = 0;
+
+    if (mBuffer.size() < total)
+    {
+        mBuffer.resize(total);
+    }
+
+    if (auto result = inflateInto(mBuffer.data(), total); not result) [[unlikely]]
+    {
+        return std::unexpected(std::move(result.error()));
+    }
+
+    mBufferOffset = start;
+    mBufferLen = total;
+
+    return reinterpret_cast<const char*>(mBuffer.data() + offset - start);
+}
+
+std::string_view GzipReader::buffer() const
+{
+    return std::string_view(reinterpret_cast<const char*>(mBuffer.data()), mBufferLen);
+}
+
+std::expected<bool, std::string> GzipReader::seek(size_t offset)
+{
+    const auto& checkpoint = mIndex.closestCheckpoint(offset);
+    const auto data = mIndex.data();
+
+    reset();
+
+    mRaw = not checkpoint.memberStart;
+
+    if (auto ret = inflateInit2(&mStream, mRaw ? RAW_WINDOW_BITS : GZIP_WINDOW_BITS); ret != Z_OK) [[unlikely]]
+    {
+        return std::unexpected(zlibError(mStream, ret));
+    }
+
+    mActive = true;
+    mPosition = checkpoint.out;
+
+    feedInput(mStream, data, mIndex.compressedSize(), checkpoint.in);
+
+    if (mRaw)
+    {
+        // Checkpoint can be in the middle of a byte
+        if (checkpoint.bits)
+        {
+            const auto byte = static_cast<uint8_t>(data[checkpoint.in - 1]);
+            inflatePrime(&mStream, checkpoint.bits, byte >> (8 - checkpoint.bits));
+        }
+
+        inflateSetDictionary(&mStream, checkpoint.window, GzipIndex::WINDOW_SIZE);
+    }
+
+    return true;
+}
+
+std::expected<bool, std::string> GzipReader::inflateInto(uint8_t* buffer, size_t len)
+{
+    const auto data = mIndex.data();
+    const auto size = mIndex.compressedSize();
+
+    mStream.next_out = buffer;
+    mStream.avail_out = 0;
+
+    while (len or mStream.avail_out)
+    {
+        if (mStream.avail_out == 0)
+        {
+            const auto toInflate = utils::min(len, MAX_CHUNK);
+            mStream.avail_out = static_cast<uInt>(toInflate);
+            len -= toInflate;
+        }
+
+        if (mStream.avail_in == 0)
+        {
+            const auto offset = inputOffset(mStream, data);
+
+            if (offset == size) [[unlikely]]
+            {
+                reset();
+                return std::unexpected("unexpected end of data");
+            }
+
+            feedInput(mStream, data, size, offset);
+        }
+
+        const auto before = mStream.avail_out;
+        const auto ret = inflate(&mStream, Z_NO_FLUSH);
+
+        mPosition += before - mStream.avail_out;
+
+        if (ret == Z_STREAM_END and (len or mStream.avail_out))
+        {
+            if (auto result = nextMember(); not result) [[unlikely]]
+            {
+                return result;
+            }
+        }
+        else if (ret != Z_OK and ret != Z_BUF_ERROR and ret != Z_STREAM_END) [[unlikely]]
+        {
+            auto message = zlibError(mStream, ret);
+            reset();
+            return std::unexpected(std::move(message));
+        }
+    }
+
+    return true;
+}
+
+std::expected<bool, std::string> GzipReader::nextMember()
+{
+    const auto data = mIndex.data();
+    const auto size = mIndex.compressedSize();
+
+    auto offset = inputOffset(mStream, data);
+
+    // Raw stream ends with the deflate data, the gzip trailer follows
+    if (mRaw)
+    {
+        offset = utils::min(offset + GZIP_TRAILER_SIZE, size);
+    }
+
+    if (not isGzipMemberAt(data, size, offset)) [[unlikely]]
+    {
+        reset();
+        return std::unexpected("unexpected end of data");
+    }
+
+    const auto nextOut = mStream.next_out;
+    const auto availOut = mStream.avail_out;
+
+    inflateEnd(&mStream);
+
+    mStream = z_stream{};
+    mRaw = false;
+
+    if (auto ret = inflateInit2(&mStream, GZIP_WINDOW_BITS); ret != Z_OK) [[unlikely]]
+    {
+        mActive = false;
+        return std::unexpected(zlibError(mStream, ret));
+    }
+
+    mStream.next_out = nextOut;
+    mStream.avail_out = availOut;
+
+    feedInput(mStream, data, size, offset);
+
+    return true;
+}
+
+void GzipReader::reset()
+{
+    if (mActive)
+    {
+        inflateEnd(&mStream);
+        mActive = false;
+    }
+    mStream = z_stream{};
+}
+
+}  // namespace core
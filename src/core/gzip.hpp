@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <zlib.h>
+
+#include "utils/function_ref.hpp"
+#include "utils/noncopyable.hpp"
+#include "utils/units.hpp"
+
+namespace core
+{
+
+constexpr static size_t GZIP_SPAN = 4_MiB;
+
+// Random access to gzip compressed data, like zran.c from zlib examples.
+// Data is decompressed once to record checkpoints - decompressor state at
+// deflate block boundaries, roughly every span bytes of output - so that
+// reading from any offset only needs decompressing from the closest
+// preceding checkpoint. Multi-member files (e.g. concatenated .gz) are
+// supported as well
+struct GzipIndex final : utils::NonCopyable
+{
+    constexpr static size_t WINDOW_SIZE = 32_KiB;
+
+    struct Checkpoint
+    {
+        uint64_t in;           // offset in compressed data
+        uint64_t out;          // offset in decompressed data
+        uint8_t  bits;         // bits of byte in - 1 still to be decompressed
+        bool     memberStart;  // at gzip header, no window needed
+        uint8_t  window[WINDOW_SIZE];
+    };
+
+    // Receives consecutive parts of decompressed data while index is built
+    using Output = utils::FunctionRef<void(std::string_view)>;
+
+    // Compressed data has to outlive the index
+    GzipIndex(const char* data, size_t size);
+
+    // Decompresses whole data, passing it to output if given, so that it can
+    // be processed without decompressing it again; can be aborted by setting
+    // stopFlag
+    std::expected<bool, std::string> build(const std::atomic_bool& stopFlag, size_t span = GZIP_SPAN, const Output* output = nullptr);
+
+    const Checkpoint& closestCheckpoint(size_t offset) const;
+
+    constexpr const char* data() const { return mData; }
+    constexpr size_t compressedSize() const { return mCompressedSize; }
+    constexpr size_t size() const { return mSize; }
+    constexpr size_t checkpointCount() const { return mCheckpoints.size(); }
+
+private:
+    const char*             mData;
+    size_t                  mCompressedSize;
+    size_t                  mSize;
+    std::vector<Checkpoint> mCheckpoints;
+};
+
+// Reads decompressed data using checkpoints of GzipIndex. Reading just
+// after the end of the previous read continues decompression instead of
+// going back to a checkpoint, so sequential reads cost nothing extra.
+// Everything decompressed by a read, from the checkpoint or the end of the
+// previous read, is kept, so reads of preceding data within it, e.g. when
+// going backwards, don't decompress anything
+struct GzipReader final : utils::NonCopyable
+{
+    GzipReader(const GzipIndex& index);
+    ~GzipReader();
+
+    // Returns pointer to decompressed [offset, offset + len), valid until
+    // the next read. Reading past the end of data is an error
+    std::expected<const char*, std::string> read(size_t offset, size_t len);
+
+    // Data kept from the last read, starting at bufferOffset()
+    std::string_view buffer() const;
+    constexpr size_t bufferOffset() const { return mBufferOffset; }
+
+private:
+    std::expected<bool, std::string> seek(size_t offset);
+    std::expected<bool, std::string> inflateInto(uint8_t* buffer, size_t len);
+    std::expected<bool, std::string> nextMember();
+    void reset();
+
+    const GzipIndex&     mIndex;
+    z_stream             mStream;
+    bool                 mActive;
+    bool                 mRaw;
+    size_t               mPosition;
+    size_t               mBufferOffset;
+    size_t               mBufferLen;
+    std::vector<uint8_t> mBuffer;
+};
+
+}  // namespace core
@@ -0,0 +1,572 @@
+#define LOG_HEADER "core::IndexCache"
+#include "index_cache.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/logger.hpp"
+#include "sys/system.hpp"
+#include "utils/buffer.hpp"
+#include "utils/math.hpp"
+#include "utils/time.hpp"
+#include "utils/units.hpp"
+
+namespace core
+{
+
+constexpr static char MAGIC[8] = {'L', 'V', 'I', 'N', 'D', 'E', 'X', '\0'};
+constexpr static uint32_t VERSION = 4;
+constexpr static size_t FINGERPRINT_SIZE = 4_KiB;
+
+// Temporary file of an entry is written continuously, so one that hasn't been
+// modified for this long was left by a writer which has crashed
+constexpr static auto STALE_TEMPORARY_AGE = std::chrono::hours(1);
+
+// Cache file layout: header, segment headers, and for each segment of the
+// index its blocks, wide offsets and deltas, padded to 8 bytes; each array
+// is naturally aligned, so that the file can be used directly after mapping.
+// Segment header holds checksum of its arrays, so that only headers have to
+// be read to open the entry, and segments are verified as they're used
+struct Header final
+{
+    char              magic[8];
+    uint32_t          version;
+    uint32_t          blockLines;
+    sys::FileIdentity identity;
+    uint64_t          fileSize;
+    uint64_t          headHash;
+    uint64_t          tailHash;
+    uint64_t          segmentCount;
+};
+
+struct SegmentHeader final
+{
+    uint64_t blockCount;
+    uint64_t wideCount;
+    uint64_t deltaCount;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(Header) % alignof(uint64_t) == 0);
+static_assert(sizeof(SegmentHeader) % alignof(uint64_t) == 0);
+static_assert(sizeof(LineIndex::Block) % alignof(uint64_t) == 0);
+
+struct MappedStorage final : LineIndex::Storage
+{
+    MappedStorage(sys::Mapping mapping)
+        : mapping(mapping)
+    {
+    }
+
+    ~MappedStorage() override
+    {
+        sys::unmap(mapping);
+    }
+
+    sys::Mapping mapping;
+};
+
+template <typename T>
+static const T* mappedAt(sys::Mapping& mapping, size_t offset)
+{
+    return reinterpret_cast<const T*>(mapping.ptrAt<const char*>(offset));
+}
+
+static size_t padding(size_t len)
+{
+    return (alignof(uint64_t) - len % alignof(uint64_t)) % alignof(uint64_t);
+}
+
+static size_t segmentLen(const SegmentHeader& segment)
+{
+    const auto deltasLen = segment.deltaCount * sizeof(uint16_t);
+
+    return segment.blockCount * sizeof(LineIndex::Block)
+        + segment.wideCount * sizeof(uint64_t)
+        + deltasLen + padding(deltasLen);
+}
+
+static std::string cachePath(const File& file)
+{
+    auto directory = sys::getCacheDirectory();
+
+    if (directory.empty()) [[unlikely]]
+    {
+        return directory;
+    }
+
+    utils::Buffer buf;
+    buf << directory << "/index-" << (file.identity().device | utils::hex) << '-' << (file.identity().inode | utils::hex);
+    return buf.str();
+}
+
+static bool removeFile(const std::string& path)
+{
+    if (auto error = sys::fileRemove(path); error) [[unlikely]]
+    {
+        logger.warning() << path << ": cannot remove: " << sys::errorDescribe(error);
+        return false;
+    }
+
+    logger.info() << "removed " << path;
+    return true;
+}
+
+// Removes least recently used entries until the cache fits in limit, and
+// stale temporary files; the entry which was just stored is never removed
+static void prune(const std::string& stored, size_t limit)
+{
+    const auto directory = sys::getCacheDirectory();
+
+    auto entries = sys::directoryRead(directory);
+
+    if (not entries) [[unlikely]]
+    {
+        logger.warning() << directory << ": cannot read: " << sys::errorDescribe(entries.error());
+        return;
+    }
+
+    const auto prefix = directory + "/index-";
+    const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch());
+    const auto staleTime = (now - STALE_TEMPORARY_AGE).count();
+    size_t total = 0;
+
+    std::erase_if(
+        *entries,
+        [&](const sys::DirectoryEntry& entry)
+        {
+            if (not entry.path.starts_with(prefix))
+            {
+                return true;
+            }
+
+            // Temporary files aren't counted, and the ones which may still
+            // be written by other instances are left alone
+            if (entry.path.find(".tmp-", prefix.size()) != std::string::npos)
+            {
+                if (entry.mtime < staleTime)
+                {
+                    removeFile(entry.path);
+                }
+                return true;
+            }
+
+            return false;
+        });
+
+    for (const auto& entry : *entries)
+    {
+        total += entry.size;
+    }
+
+    std::ranges::sort(*entries, {}, &sys::DirectoryEntry::mtime);
+
+    for (const auto& entry : *entries)
+    {
+        if (total <= limit)
+        {
+            break;
+        }
+
+        if (entry.path == stored)
+        {
+            continue;
+        }
+
+        if (removeFile(entry.path))
+        {
+            total -= entry.size;
+        }
+    }
+}
+
+static uint64_t hash(const char* data, size_t len)
+{
+    // FNV-1a
+    uint64_t value = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < len; ++i)
+    {
+        value = (value ^ static_cast<uint8_t>(data[i])) * 0x100000001b3ull;
+    }
+    return value;
+}
+
+// Word at a time, so that verifying a segment costs little more than reading it
+static uint64_t checksum(std::span<const char> data, uint64_t value)
+{
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= data.size(); i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, data.data() + i, sizeof(word));
+        value = (value ^ word) * 0x100000001b3ull;
+        value ^= value >> 32;
+    }
+
+    for (; i < data.size(); ++i)
+    {
+        value = (value ^ static_cast<uint8_t>(data[i])) * 0x100000001b3ull;
+    }
+
+    return value;
+}
+
+static uint64_t checksum(const LineIndex::SegmentView& segment)
+{
+    const auto bytes =
+        [](const auto& span)
+        {
+            return std::span<const char>(reinterpret_cast<const char*>(span.data()), span.size_bytes());
+        };
+
+    auto value = checksum(bytes(segment.blocks), 0xcbf29ce484222325ull);
+    value = checksum(bytes(segment.wide), value);
+    return checksum(bytes(segment.deltas), value);
+}
+
+static std::expected<uint64_t, std::string> fingerprint(File& file, size_t offset, size_t len)
+{
+    if (len == 0)
+    {
+        return hash(nullptr, 0);
+    }
+
+    if (auto result = file.remap(offset, len); not result) [[unlikely]]
+    {
+        return std::unexpected(std::move(result.error()));
+    }
+
+    return hash(file.at(offset), len);
+}
+
+struct Fingerprints final
+{
+    uint64_t head;
+    uint64_t tail;
+};
+
+static std::expected<Fingerprints, std::string> fingerprints(File& file, size_t size)
+{
+    const auto len = utils::min(size, FINGERPRINT_SIZE);
+
+    auto head = fingerprint(file, 0, len);
+
+    if (not head) [[unlikely]]
+    {
+        return std::unexpected(std::move(head.error()));
+    }
+
+    auto tail = fingerprint(file, size - len, len);
+
+    if (not tail) [[unlikely]]
+    {
+        return std::unexpected(std::move(tail.error()));
+    }
+
+    return Fingerprints{.head = *head, .tail = *tail};
+}
+
+static bool validate(const Header& header, size_t mappingLen, File& file)
+{
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC))
+        or header.version != VERSION
+        or header.blockLines != LineIndex::BLOCK_LINES)
+    {
+        logger.info() << file.path() << ": cache entry has incompatible format";
+        return false;
+    }
+
+    const auto corrupted =
+        [&file]
+        {
+            logger.warning() << file.path() << ": cache entry is corrupted";
+            return false;
+        };
+
+    if (header.segmentCount == 0
+        or header.segmentCount > (mappingLen - sizeof(Header)) / sizeof(SegmentHeader))
+    {
+        return corrupted();
+    }
+
+    const auto segments = reinterpret_cast<const SegmentHeader*>(&header + 1);
+    auto expectedLen = sizeof(Header) + header.segmentCount * sizeof(SegmentHeader);
+
+    for (size_t i = 0; i < header.segmentCount; ++i)
+    {
+        const auto& segment = segments[i];
+
+        if (segment.deltaCount == 0
+            or segment.deltaCount > mappingLen
+            or segment.wideCount > mappingLen
+            or segment.blockCount != (segment.deltaCount + LineIndex::BLOCK_LINES - 1) / LineIndex::BLOCK_LINES)
+        {
+            return corrupted();
+        }
+
+        expectedLen += segmentLen(segment);
+    }
+
+    if (expectedLen != mappingLen)
+    {
+        return corrupted();
+    }
+
+    const auto& identity = file.identity();
+
+    if (header.identity.device != identity.device or header.identity.inode != identity.inode)
+    {
+        return false;
+    }
+
+    if (header.fileSize > file.size()
+        or (header.fileSize == file.size() and header.identity.mtime != identity.mtime))
+    {
+        logger.info() << file.path() << ": cache entry is stale";
+        return false;
+    }
+
+    auto result = fingerprints(file, header.fileSize);
+
+    if (not result) [[unlikely]]
+    {
+        logger.warning() << result.error();
+        return false;
+    }
+
+    if (result->head != header.headHash or result->tail != header.tailHash)
+    {
+        logger.info() << file.path() << ": cache entry fingerprint mismatch";
+        return false;
+    }
+
+    return true;
+}
+
+size_t indexCacheLoad(File& file, const std::atomic_bool& stopFlag, const IndexCacheOutput& output)
+{
+    const auto path = cachePath(file);
+
+    if (path.empty()) [[unlikely]]
+    {
+        return 0;
+    }
+
+    auto cacheFile = sys::fileOpen(path);
+
+    if (not cacheFile)
+    {
+        return 0;
+    }
+
+    sys::Mapping mapping{.ptr = nullptr, .offset = 0, .len = 0};
+
+    const auto error = cacheFile->size >= sizeof(Header)
+        ? sys::remap(*cacheFile, mapping, 0, cacheFile->size)
+        : EINVAL;
+
+    sys::fileClose(*cacheFile);
+
+    if (error) [[unlikely]]
+    {
+        logger.warning() << path << ": cannot map: " << sys::errorDescribe(error);
+        return 0;
+    }
+
+    const auto& header = *mappedAt<Header>(mapping, 0);
+
+    if (not validate(header, mapping.len, file))
+    {
+        sys::unmap(mapping);
+        return 0;
+    }
+
+    // Mapping is owned by the first segment passed to output, and so by the
+    // index it's appended to; the following ones only refer to it
+    utils::UniquePtr<LineIndex::Storage> storage(new MappedStorage(mapping));
+
+    const auto segments = mappedAt<SegmentHeader>(mapping, sizeof(Header));
+    auto offset = sizeof(Header) + header.segmentCount * sizeof(SegmentHeader);
+    size_t covered = 0;
+
+    for (size_t i = 0; i < header.segmentCount; ++i)
+    {
+        if (stopFlag) [[unlikely]]
+        {
+            return covered;
+        }
+
+        const auto& segment = segments[i];
+        auto current = offset;
+
+        const auto blocks = mappedAt<LineIndex::Block>(mapping, current);
+        current += segment.blockCount * sizeof(LineIndex::Block);
+
+        const auto wide = mappedAt<uint64_t>(mapping, current);
+        current += segment.wideCount * sizeof(uint64_t);
+
+        const auto deltas = mappedAt<uint16_t>(mapping, current);
+
+        const LineIndex::SegmentView view{
+            .blocks = {blocks, segment.blockCount},
+            .deltas = {deltas, segment.deltaCount},
+            .wide = {wide, segment.wideCount},
+        };
+
+        // Lines of the verified segments are used, and the rest of file is
+        // scanned from the last of their starts
+        if (checksum(view) != segment.checksum) [[unlikely]]
+        {
+            logger.warning() << file.path() << ": cache entry is corrupted at segment " << i;
+            return covered;
+        }
+
+        if (i == 0)
+        {
+            // Entries are evicted in order of mtime, so mark this one as
+            // recently used
+            sys::fileTouch(path);
+        }
+
+        LineIndex lines;
+        lines.view(std::move(storage), {&view, 1});
+
+        if (i == header.segmentCount - 1)
+        {
+            if (header.fileSize < file.size())
+            {
+                logger.info() << file.path() << ": using cached index of first " << header.fileSize << " B";
+                lines.unfinalize(header.fileSize);
+            }
+            else
+            {
+                logger.info() << file.path() << ": using cached index";
+            }
+
+            covered = header.fileSize;
+        }
+        else
+        {
+            covered = lines.lastStart();
+        }
+
+        output(std::move(lines));
+
+        offset += segmentLen(segment);
+    }
+
+    return covered;
+}
+
+void indexCacheStore(File& file, const LineIndex& lines, size_t limit)
+{
+    const auto path = cachePath(file);
+
+    if (path.empty()) [[unlikely]]
+    {
+        return;
+    }
+
+    size_t len = sizeof(Header) + lines.segmentCount() * sizeof(SegmentHeader);
+
+    for (size_t i = 0; i < lines.segmentCount(); ++i)
+    {
+        const auto segment = lines.segment(i);
+
+        len += segmentLen(SegmentHeader{
+            .blockCount = segment.blocks.size(),
+            .wideCount = segment.wide.size(),
+            .deltaCount = segment.deltas.size(),
+            .checksum = 0,
+        });
+    }
+
+    if (len > limit)
+    {
+        logger.info() << file.path() << ": index of " << len << " B exceeds cache size";
+        return;
+    }
+
+    auto timer = utils::startTimeMeasurement();
+
+    auto result = fingerprints(file, file.size());
+
+    if (not result) [[unlikely]]
+    {
+        logger.warning() << result.error();
+        return;
+    }
+
+    Header header{
+        .version = VERSION,
+        .blockLines = LineIndex::BLOCK_LINES,
+        .identity = file.identity(),
+        .fileSize = file.size(),
+        .headHash = result->head,
+        .tailHash = result->tail,
+        .segmentCount = lines.segmentCount(),
+    };
+
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+
+    const auto asChars =
+        [](const auto* data, size_t size)
+        {
+            return std::string_view(reinterpret_cast<const char*>(data), size * sizeof(*data));
+        };
+
+    constexpr static char zeros[alignof(uint64_t)] = {};
+
+    std::vector<SegmentHeader> segments;
+    std::vector<std::string_view> parts;
+
+    segments.reserve(lines.segmentCount());
+    parts.reserve(2 + lines.segmentCount() * 4);
+
+    for (size_t i = 0; i < lines.segmentCount(); ++i)
+    {
+        const auto segment = lines.segment(i);
+
+        segments.push_back(SegmentHeader{
+            .blockCount = segment.blocks.size(),
+            .wideCount = segment.wide.size(),
+            .deltaCount = segment.deltas.size(),
+            .checksum = checksum(segment),
+        });
+    }
+
+    parts.push_back(asChars(&header, 1));
+    parts.push_back(asChars(segments.data(), segments.size()));
+
+    for (size_t i = 0; i < lines.segmentCount(); ++i)
+    {
+        const auto segment = lines.segment(i);
+
+        parts.push_back(asChars(segment.blocks.data(), segment.blocks.size()));
+        parts.push_back(asChars(segment.wide.data(), segment.wide.size()));
+        parts.push_back(asChars(segment.deltas.data(), segment.deltas.size()));
+        parts.push_back(std::string_view(zeros, padding(segment.deltas.size_bytes())));
+    }
+
+    const auto error = sys::fileWrite(path, parts);
+
+    if (error) [[unlikely]]
+    {
+        logger.warning() << path << ": cannot write: " << sys::errorDescribe(error);
+        return;
+    }
+
+    logger.info() << file.path() << ": stored index in " << path << "; took " << (timer.elapsed() | utils::precision(3)) << " s";
+
+    prune(path, limit);
+}
+
+}  // namespace core
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "core/file.hpp"
+#include "core/line_index.hpp"
+#include "utils/function_ref.hpp"
+
+namespace core
+{
+
+// On-disk cache of line indexes, kept in sys::getCacheDirectory(). Entry is
+// named after device and inode of the indexed file and records its size and
+// mtime, together with a fingerprint of the first and the last indexed bytes.
+// Loading an entry updates its mtime, so that least recently used entries are
+// removed first when the cache grows over its size limit
+
+// Receives consecutive segments of cached index
+using IndexCacheOutput = utils::FunctionRef<void(LineIndex&&)>;
+
+// Maps cached index of file and passes it to output segment by segment, each
+// once it's been verified against its checksum, so that only headers of the
+// entry are read before the first segment can be used. Returns number of
+// bytes of file covered by the passed segments - the last start they hold -
+// or 0 if there's no valid entry. If file has grown since the index was
+// stored, or the entry is corrupted after some segments, the passed index is
+// not finalized and can be extended by scanning the remaining part
+size_t indexCacheLoad(File& file, const std::atomic_bool& stopFlag, const IndexCacheOutput& output);
+
+// Stores finalized index of the whole file, unless it's larger than limit,
+// and then removes least recently used entries until the cache fits in limit
+void indexCacheStore(File& file, const LineIndex& lines, size_t limit);
+
+}  // namespace core
@@ -1,7 +1,8 @@
 #pragma once
 
 #include <cstddef>
-#include <vector>
+
+#include "utils/segmented_array.hpp"
 
 namespace core
 {
@@ -12,7 +13,6 @@ struct Line final
     size_t len;
 };
 
-using Lines = std::vector<Line>;
-using LineRefs = std::vector<size_t>;
+using LineRefs = utils::SegmentedArray<size_t>;
 
 }  // namespace core
@@ -0,0 +1,243 @@
+#include "line_index.hpp"
+
+#include <limits>
+#include <utility>
+
+namespace core
+{
+
+LineIndex::LineIndex() = default;
+
+LineIndex::~LineIndex() = default;
+
+void LineIndex::view(utils::UniquePtr<Storage> storage, std::span<const SegmentView> segments)
+{
+    clear();
+
+    for (const auto& view : segments)
+    {
+        auto& segment = mSegments.emplace_back();
+
+        segment.blocks.borrow(view.blocks.data(), view.blocks.size());
+        segment.deltas.borrow(view.deltas.data(), view.deltas.size());
+        segment.wide.borrow(view.wide.data(), view.wide.size());
+        segment.last = view.deltas.empty() ? 0 : segment.start(view.deltas.size() - 1);
+
+        mMap.addSegment();
+        mMap.grow(view.deltas.size());
+    }
+
+    mStorage.emplace_back(std::move(storage));
+}
+
+void LineIndex::append(size_t offset)
+{
+    if (mSegments.empty()) [[unlikely]]
+    {
+        mSegments.emplace_back();
+        mMap.addSegment();
+    }
+
+    mSegments.back().append(offset);
+    mMap.grow(1);
+}
+
+void LineIndex::append(LineIndex&& other)
+{
+    const auto count = other.startCount();
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (startCount() == 0)
+    {
+        *this = std::move(other);
+        return;
+    }
+
+    if (count < MIN_SEGMENT_STARTS)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            append(other.start(i));
+        }
+    }
+    else
+    {
+        for (auto& segment : other.mSegments)
+        {
+            mMap.addSegment();
+            mMap.grow(segment.deltas.size());
+            mSegments.emplace_back(std::move(segment));
+        }
+    }
+
+    // Storage may be referred to by views appended later, even if this one
+    // has been copied
+    for (auto& storage : other.mStorage)
+    {
+        mStorage.emplace_back(std::move(storage));
+    }
+
+    other.clear();
+}
+
+void LineIndex::finalize(size_t fileSize)
+{
+    if (startCount() == 0)
+    {
+        append(0);
+    }
+
+    if (lastStart() < fileSize)
+    {
+        append(fileSize + 1);
+    }
+}
+
+void LineIndex::unfinalize(size_t fileSize)
+{
+    if (startCount() and lastStart() == fileSize + 1)
+    {
+        popBack();
+    }
+}
+
+void LineIndex::clear()
+{
+    mSegments.clear();
+    mMap.clear();
+    mStorage.clear();
+}
+
+void LineIndex::shrinkToFit()
+{
+    for (auto& segment : mSegments)
+    {
+        segment.blocks.shrinkToFit();
+        segment.deltas.shrinkToFit();
+        segment.wide.shrinkToFit();
+    }
+
+    mMap.shrinkToFit();
+}
+
+size_t LineIndex::memoryUsage() const
+{
+    const auto bytes =
+        [](const auto& array)
+        {
+            return (array.borrowed() ? array.size() : array.capacity()) * sizeof(array[0]);
+        };
+
+    size_t total = mMap.memoryUsage();
+
+    for (const auto& segment : mSegments)
+    {
+        total += bytes(segment.blocks) + bytes(segment.deltas) + bytes(segment.wide);
+    }
+
+    return total;
+}
+
+LineIndex::SegmentView LineIndex::segment(size_t i) const
+{
+    const auto& segment = mSegments[i];
+
+    return SegmentView{
+        .blocks = {segment.blocks.data(), segment.blocks.size()},
+        .deltas = {segment.deltas.data(), segment.deltas.size()},
+        .wide = {segment.wide.data(), segment.wide.size()},
+    };
+}
+
+void LineIndex::popBack()
+{
+    auto& segment = mSegments.back();
+
+    segment.popBack();
+    mMap.shrink(1);
+
+    if (segment.deltas.empty())
+    {
+        mSegments.pop_back();
+        mMap.removeSegment();
+    }
+}
+
+void LineIndex::Segment::append(size_t offset)
+{
+    const auto i = deltas.size();
+    const auto delta = offset - last;
+
+    last = offset;
+
+    if ((i & (BLOCK_LINES - 1)) == 0)
+    {
+        blocks.pushBack(Block{.anchor = offset, .wideIndex = NARROW, .groups = {}});
+        deltas.pushBack(0);
+        return;
+    }
+
+    auto& block = blocks.back();
+
+    if (block.wideIndex == NARROW) [[likely]]
+    {
+        if (delta <= std::numeric_limits<uint16_t>::max()) [[likely]]
+        {
+            // Lines of narrow block are shorter than 64 KiB, so offset of its
+            // group always fits
+            if ((i & (GROUP_LINES - 1)) == 0)
+            {
+                block.groups[((i >> GROUP_SHIFT) & (BLOCK_GROUPS - 1)) - 1] = static_cast<uint32_t>(offset - block.anchor);
+                deltas.pushBack(0);
+            }
+            else
+            {
+                deltas.pushBack(static_cast<uint16_t>(delta));
+            }
+            return;
+        }
+
+        widenLastBlock();
+    }
+
+    wide.pushBack(offset);
+    deltas.pushBack(0);
+}
+
+void LineIndex::Segment::widenLastBlock()
+{
+    const auto blockStart = (deltas.size() - 1) & ~(BLOCK_LINES - 1);
+    const auto wideIndex = static_cast<uint32_t>(wide.size());
+
+    for (size_t i = blockStart; i < deltas.size(); ++i)
+    {
+        wide.pushBack(start(i));
+    }
+
+    blocks.back().wideIndex = wideIndex;
+}
+
+void LineIndex::Segment::popBack()
+{
+    const auto i = deltas.size() - 1;
+
+    if (std::as_const(blocks).back().wideIndex != NARROW)
+    {
+        wide.popBack();
+    }
+
+    if ((i & (BLOCK_LINES - 1)) == 0)
+    {
+        blocks.popBack();
+    }
+
+    deltas.popBack();
+
+    last = i ? start(i - 1) : 0;
+}
+
+}  // namespace core
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "core/line.hpp"
+#include "utils/noncopyable.hpp"
+#include "utils/pod_array.hpp"
+#include "utils/segment_map.hpp"
+#include "utils/unique_ptr.hpp"
+
+namespace core
+{
+
+// Compact index of line start offsets. Starts are grouped in blocks of
+// BLOCK_LINES; each block keeps an absolute anchor, and 32-bit offsets from
+// it of its groups of GROUP_LINES starts. Every other start is stored as a
+// 16-bit delta from the previous one, i.e. the length of the previous line,
+// so a start is the sum of at most GROUP_LINES - 1 deltas. A block with a
+// line which is 64 KiB or longer falls back to absolute 64-bit offsets.
+//
+// The last start is a sentinel - it's the offset at which the line
+// following the last one would begin - so line i spans
+// [start(i), start(i + 1) - 1) and the length is never stored.
+//
+// Index is made of segments, each encoded independently, so that indexes
+// of consecutive parts of file built by separate threads are joined
+// without copying; utils::SegmentMap keeps the access O(1).
+//
+// Index can also be a read-only view of external storage, e.g. a mapped
+// cache file (see index_cache.hpp); it's copied to memory only if modified
+struct LineIndex final : utils::NonCopyable
+{
+    constexpr static size_t BLOCK_SHIFT = 6;
+    constexpr static size_t BLOCK_LINES = 1 << BLOCK_SHIFT;
+    constexpr static size_t GROUP_SHIFT = 3;
+    constexpr static size_t GROUP_LINES = 1 << GROUP_SHIFT;
+    constexpr static size_t BLOCK_GROUPS = BLOCK_LINES / GROUP_LINES;
+    constexpr static uint32_t NARROW = UINT32_MAX;
+    constexpr static size_t MIN_SEGMENT_STARTS = utils::SegmentMap::PAGE_SIZE;
+
+    struct Block
+    {
+        uint64_t anchor;
+        uint32_t wideIndex;
+        uint32_t groups[BLOCK_GROUPS - 1];  // first group starts at anchor
+    };
+
+    struct Storage
+    {
+        virtual ~Storage() = default;
+    };
+
+    struct SegmentView
+    {
+        std::span<const Block>    blocks;
+        std::span<const uint16_t> deltas;
+        std::span<const uint64_t> wide;
+    };
+
+    LineIndex();
+    ~LineIndex();
+
+    LineIndex(LineIndex&&) = default;
+    LineIndex& operator=(LineIndex&&) = default;
+
+    // Makes index a view of segments kept in storage and takes its ownership
+    void view(utils::UniquePtr<Storage> storage, std::span<const SegmentView> segments);
+
+    // Appends a line start; offsets must be given in ascending order
+    void append(size_t offset);
+
+    // Appends all starts from other, which must begin after last start.
+    // Segments of other are taken over, unless it's shorter than
+    // MIN_SEGMENT_STARTS, in which case it's copied
+    void append(LineIndex&& other);
+
+    // Adds sentinel for the last line if it's not terminated by newline
+    void finalize(size_t fileSize);
+
+    // Reverts finalize, so that index can be extended if file has grown
+    void unfinalize(size_t fileSize);
+
+    void clear();
+    void shrinkToFit();
+
+    size_t memoryUsage() const;
+
+    SegmentView segment(size_t i) const;
+
+    constexpr size_t segmentCount() const
+    {
+        return mSegments.size();
+    }
+
+    constexpr size_t startCount() const
+    {
+        return mMap.size();
+    }
+
+    constexpr size_t size() const
+    {
+        return startCount() ? startCount() - 1 : 0;
+    }
+
+    constexpr bool empty() const
+    {
+        return size() == 0;
+    }
+
+    constexpr size_t start(size_t i) const
+    {
+        const auto location = mMap.locate(i);
+        return mSegments[location.segment].start(location.offset);
+    }
+
+    constexpr size_t lastStart() const
+    {
+        return start(startCount() - 1);
+    }
+
+    constexpr Line operator[](size_t i) const
+    {
+        const auto lineStart = start(i);
+        return Line{.start = lineStart, .len = start(i + 1) - lineStart - 1};
+    }
+
+private:
+    struct Segment
+    {
+        void append(size_t offset);
+        void widenLastBlock();
+        void popBack();
+
+        constexpr size_t start(size_t i) const
+        {
+            const auto& block = blocks[i >> BLOCK_SHIFT];
+
+            if (block.wideIndex == NARROW) [[likely]]
+            {
+                const auto group = (i >> GROUP_SHIFT) & (BLOCK_GROUPS - 1);
+                size_t offset = block.anchor + (group ? block.groups[group - 1] : 0);
+
+                for (auto j = (i & ~(GROUP_LINES - 1)) + 1; j <= i; ++j)
+                {
+                    offset += deltas[j];
+                }
+
+                return offset;
+            }
+
+            return wide[block.wideIndex + (i & (BLOCK_LINES - 1))];
+        }
+
+        utils::PodArray<Block>    blocks;
+        utils::PodArray<uint16_t> deltas;
+        utils::PodArray<uint64_t> wide;
+        size_t                    last = 0;
+    };
+
+    void popBack();
+
+    std::vector<Segment>                   mSegments;
+    utils::SegmentMap                      mMap;
+    std::vector<utils::UniquePtr<Storage>> mStorage;
+};
+
+using Lines = LineIndex;
+
+}  // namespace core
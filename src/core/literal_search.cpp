@@ -0,0 +1,424 @@
+#include "literal_search.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "utils/inline.hpp"
+
+namespace core
+{
+
+constexpr static size_t npos = LiteralSearch::npos;
+
+// Pattern as seen by kernels; it's at least 1 byte long and text is not
+// shorter than it. Pattern of case insensitive search is in lower case and
+// anchor fold masks are 0x20 for letters: a byte ORed with it equals the
+// lower case letter only if it's this letter in either case. Bytes which are
+// not ASCII letters, including all bytes of UTF-8 sequences, have mask 0 and
+// are compared as they are
+struct Needle
+{
+    const char* data;
+    size_t      len;
+    size_t      second;
+    char        firstFold;
+    char        secondFold;
+};
+
+using FindFn = size_t(*)(const char* data, size_t len, const Needle& needle);
+
+struct LiteralSearcher
+{
+    const char* name;
+    FindFn      find[2];
+    FindFn      rfind[2];
+};
+
+constexpr static char toLowerAscii(char c)
+{
+    return c >= 'A' and c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+constexpr static auto lowerTable =
+    []
+    {
+        std::array<char, 256> table{};
+        for (size_t i = 0; i < table.size(); ++i)
+        {
+            table[i] = toLowerAscii(static_cast<char>(i));
+        }
+        return table;
+    }();
+
+template <bool fold>
+ALWAYS_INLINE static bool equal(const char* data, const char* pattern, size_t len)
+{
+    if constexpr (fold)
+    {
+        for (size_t i = 0; i < len; ++i)
+        {
+            if (lowerTable[static_cast<unsigned char>(data[i])] != pattern[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    else
+    {
+        return std::memcmp(data, pattern, len) == 0;
+    }
+}
+
+template <bool fold>
+ALWAYS_INLINE static bool matches(const char* data, size_t i, const Needle& needle)
+{
+    return char(data[i] | needle.firstFold) == needle.data[0]
+        and char(data[i + needle.second] | needle.secondFold) == needle.data[needle.second]
+        and equal<fold>(data + i + 1, needle.data + 1, needle.len - 1);
+}
+
+template <bool fold>
+ALWAYS_INLINE static size_t findTail(const char* data, size_t start, size_t len, const Needle& needle)
+{
+    for (size_t i = start; i + needle.len <= len; ++i)
+    {
+        if (matches<fold>(data, i, needle))
+        {
+            return i;
+        }
+    }
+    return npos;
+}
+
+// Checks candidates in [0, end) from the last one
+template <bool fold>
+ALWAYS_INLINE static size_t rfindTail(const char* data, size_t end, const Needle& needle)
+{
+    for (size_t i = end; i-- > 0;)
+    {
+        if (matches<fold>(data, i, needle))
+        {
+            return i;
+        }
+    }
+    return npos;
+}
+
+template <bool fold>
+ALWAYS_INLINE static size_t verifyForward(uint64_t mask, size_t base, const char* data, const Needle& needle)
+{
+    while (mask)
+    {
+        const auto i = base + static_cast<size_t>(__builtin_ctzll(mask));
+        if (equal<fold>(data + i + 1, needle.data + 1, needle.len - 1))
+        {
+            return i;
+        }
+        mask &= mask - 1;
+    }
+    return npos;
+}
+
+template <bool fold>
+ALWAYS_INLINE static size_t verifyBackward(uint64_t mask, size_t base, const char* data, const Needle& needle)
+{
+    while (mask)
+    {
+        const auto bit = 63 - __builtin_clzll(mask);
+        const auto i = base + static_cast<size_t>(bit);
+        if (equal<fold>(data + i + 1, needle.data + 1, needle.len - 1))
+        {
+            return i;
+        }
+        mask &= ~(1ull << bit);
+    }
+    return npos;
+}
+
+#if defined(__x86_64__)
+
+// Candidates are offsets at which a pattern could start, so the loads at
+// second anchor never go past the end of text
+
+template <bool fold>
+[[gnu::target("sse2")]]
+ALWAYS_INLINE static uint64_t candidatesSse2(const char* data, size_t second, __m128i first, __m128i anchor, __m128i firstFold, __m128i secondFold)
+{
+    auto atFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    auto atAnchor = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + second));
+
+    if constexpr (fold)
+    {
+        atFirst = _mm_or_si128(atFirst, firstFold);
+        atAnchor = _mm_or_si128(atAnchor, secondFold);
+    }
+
+    const auto eq = _mm_and_si128(_mm_cmpeq_epi8(atFirst, first), _mm_cmpeq_epi8(atAnchor, anchor));
+
+    return static_cast<uint16_t>(_mm_movemask_epi8(eq));
+}
+
+#define SSE2_VECTORS(needle) \
+    const auto first = _mm_set1_epi8(needle.data[0]); \
+    const auto anchor = _mm_set1_epi8(needle.data[needle.second]); \
+    const auto firstFold = _mm_set1_epi8(needle.firstFold); \
+    const auto secondFold = _mm_set1_epi8(needle.secondFold)
+
+template <bool fold>
+[[gnu::target("sse2")]]
+static size_t findSse2(const char* data, size_t len, const Needle& needle)
+{
+    SSE2_VECTORS(needle);
+    const auto candidates = len - needle.len + 1;
+    size_t i = 0;
+
+    for (; i + 16 <= candidates; i += 16)
+    {
+        const auto mask = candidatesSse2<fold>(data + i, needle.second, first, anchor, firstFold, secondFold);
+
+        if (const auto offset = verifyForward<fold>(mask, i, data, needle); offset != npos)
+        {
+            return offset;
+        }
+    }
+
+    return findTail<fold>(data, i, len, needle);
+}
+
+template <bool fold>
+[[gnu::target("sse2")]]
+static size_t rfindSse2(const char* data, size_t len, const Needle& needle)
+{
+    SSE2_VECTORS(needle);
+    auto end = len - needle.len + 1;
+
+    for (; end >= 16; end -= 16)
+    {
+        const auto mask = candidatesSse2<fold>(data + end - 16, needle.second, first, anchor, firstFold, secondFold);
+
+        if (const auto offset = verifyBackward<fold>(mask, end - 16, data, needle); offset != npos)
+        {
+            return offset;
+        }
+    }
+
+    return rfindTail<fold>(data, end, needle);
+}
+
+template <bool fold>
+[[gnu::target("avx2")]]
+ALWAYS_INLINE static uint64_t candidatesAvx2(const char* data, size_t second, __m256i first, __m256i anchor, __m256i firstFold, __m256i secondFold)
+{
+    auto atFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    auto atAnchor = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + second));
+
+    if constexpr (fold)
+    {
+        atFirst = _mm256_or_si256(atFirst, firstFold);
+        atAnchor = _mm256_or_si256(atAnchor, secondFold);
+    }
+
+    const auto eq = _mm256_and_si256(_mm256_cmpeq_epi8(atFirst, first), _mm256_cmpeq_epi8(atAnchor, anchor));
+
+    return static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+}
+
+#define AVX2_VECTORS(needle) \
+    const auto first = _mm256_set1_epi8(needle.data[0]); \
+    const auto anchor = _mm256_set1_epi8(needle.data[needle.second]); \
+    const auto firstFold = _mm256_set1_epi8(needle.firstFold); \
+    const auto secondFold = _mm256_set1_epi8(needle.secondFold)
+
+template <bool fold>
+[[gnu::target("avx2")]]
+static size_t findAvx2(const char* data, size_t len, const Needle& needle)
+{
+    AVX2_VECTORS(needle);
+    const auto candidates = len - needle.len + 1;
+    size_t i = 0;
+
+    for (; i + 32 <= candidates; i += 32)
+    {
+        const auto mask = candidatesAvx2<fold>(data + i, needle.second, first, anchor, firstFold, secondFold);
+
+        if (const auto offset = verifyForward<fold>(mask, i, data, needle); offset != npos)
+        {
+            return offset;
+        }
+    }
+
+    return findTail<fold>(data, i, len, needle);
+}
+
+template <bool fold>
+[[gnu::target("avx2")]]
+static size_t rfindAvx2(const char* data, size_t len, const Needle& needle)
+{
+    AVX2_VECTORS(needle);
+    auto end = len - needle.len + 1;
+
+    for (; end >= 32; end -= 32)
+    {
+        const auto mask = candidatesAvx2<fold>(data + end - 32, needle.second, first, anchor, firstFold, secondFold);
+
+        if (const auto offset = verifyBackward<fold>(mask, end - 32, data, needle); offset != npos)
+        {
+            return offset;
+        }
+    }
+
+    return rfindTail<fold>(data, end, needle);
+}
+
+static LiteralSearcher selectSearcher()
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return {
+            .name = "avx2",
+            .find = {&findAvx2<false>, &findAvx2<true>},
+            .rfind = {&rfindAvx2<false>, &rfindAvx2<true>},
+        };
+    }
+
+    return {
+        .name = "sse2",
+        .find = {&findSse2<false>, &findSse2<true>},
+        .rfind = {&rfindSse2<false>, &rfindSse2<true>},
+    };
+}
+
+#else
+
+template <bool fold>
+static size_t findScalar(const char* data, size_t len, const Needle& needle)
+{
+    return findTail<fold>(data, 0, len, needle);
+}
+
+template <bool fold>
+static size_t rfindScalar(const char* data, size_t len, const Needle& needle)
+{
+    return rfindTail<fold>(data, len - needle.len + 1, needle);
+}
+
+static LiteralSearcher selectSearcher()
+{
+    return {
+        .name = "scalar",
+        .find = {&findScalar<false>, &findScalar<true>},
+        .rfind = {&rfindScalar<false>, &rfindScalar<true>},
+    };
+}
+
+#endif
+
+static const LiteralSearcher searcher = selectSearcher();
+
+constexpr static char foldMask(char c, bool caseInsensitive)
+{
+    return caseInsensitive and c >= 'a' and c <= 'z' ? 0x20 : 0;
+}
+
+LiteralSearch::LiteralSearch(std::string pattern, bool caseInsensitive)
+    : mPattern(std::move(pattern))
+    , mSecond(mPattern.size() > 1 ? mPattern.size() - 1 : 0)
+    , mCaseInsensitive(caseInsensitive)
+{
+    if (mCaseInsensitive)
+    {
+        for (auto& c : mPattern)
+        {
+            c = toLowerAscii(c);
+        }
+    }
+
+    // Byte equal to the first one doesn't filter out anything more, so the
+    // last one which differs is taken instead, e.g. 'b' for "aaba"
+    for (auto i = mPattern.size(); i-- > 1;)
+    {
+        if (mPattern[i] != mPattern[0])
+        {
+            mSecond = i;
+            break;
+        }
+    }
+}
+
+size_t LiteralSearch::find(std::string_view text, size_t pos) const
+{
+    const auto patternLen = mPattern.size();
+
+    if (pos > text.size() or patternLen > text.size() - pos)
+    {
+        return npos;
+    }
+
+    const auto data = text.data() + pos;
+    const auto len = text.size() - pos;
+
+    if (patternLen == 0)
+    {
+        return pos;
+    }
+    else if (patternLen == 1 and not mCaseInsensitive)
+    {
+        const auto found = static_cast<const char*>(std::memchr(data, mPattern[0], len));
+        return found ? static_cast<size_t>(found - text.data()) : npos;
+    }
+
+    const auto offset = searcher.find[mCaseInsensitive](data, len, needle());
+
+    return offset != npos ? offset + pos : npos;
+}
+
+size_t LiteralSearch::rfind(std::string_view text, size_t pos) const
+{
+    const auto patternLen = mPattern.size();
+
+    if (patternLen > text.size())
+    {
+        return npos;
+    }
+
+    // Occurrence can start at most at last
+    const auto last = pos < text.size() - patternLen ? pos : text.size() - patternLen;
+
+    if (patternLen == 0)
+    {
+        return last;
+    }
+    else if (patternLen == 1 and not mCaseInsensitive)
+    {
+        const auto found = static_cast<const char*>(memrchr(text.data(), mPattern[0], last + 1));
+        return found ? static_cast<size_t>(found - text.data()) : npos;
+    }
+
+    return searcher.rfind[mCaseInsensitive](text.data(), last + patternLen, needle());
+}
+
+Needle LiteralSearch::needle() const
+{
+    return Needle{
+        .data = mPattern.data(),
+        .len = mPattern.size(),
+        .second = mSecond,
+        .firstFold = foldMask(mPattern[0], mCaseInsensitive),
+        .secondFold = foldMask(mPattern[mSecond], mCaseInsensitive),
+    };
+}
+
+const char* literalSearchName()
+{
+    return searcher.name;
+}
+
+}  // namespace core
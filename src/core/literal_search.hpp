@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace core
+{
+
+struct Needle;
+
+// Finder of a fixed string, reused for all lines of a grep or search, so the
+// pattern is preprocessed only once. Candidates are found by comparing whole
+// vectors of text with the first byte of pattern and with the byte at second
+// anchor, and only these are verified with memcmp. Case insensitive search
+// folds ASCII letters only; other bytes, like these of UTF-8 sequences, have
+// to match exactly
+struct LiteralSearch final
+{
+    constexpr static size_t npos = std::string_view::npos;
+
+    explicit LiteralSearch(std::string pattern, bool caseInsensitive = false);
+
+    // Offset of the first occurrence starting at pos or later, or npos
+    size_t find(std::string_view text, size_t pos = 0) const;
+
+    // Offset of the last occurrence starting at pos or earlier, or npos
+    size_t rfind(std::string_view text, size_t pos = npos) const;
+
+    bool contains(std::string_view text) const
+    {
+        return find(text) != npos;
+    }
+
+    const std::string& pattern() const
+    {
+        return mPattern;
+    }
+
+private:
+    Needle needle() const;
+
+    std::string mPattern;
+    size_t      mSecond;
+    bool        mCaseInsensitive;
+};
+
+// Name of the kernel selected at runtime for the current CPU
+const char* literalSearchName();
+
+}  // namespace core
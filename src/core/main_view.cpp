@@ -1,8 +1,10 @@
 #define LOG_HEADER "core::MainView"
 #include "main_view.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <string_view>
+#include <vector>
 
 #include "core/assert.hpp"
 #include "core/buffer.hpp"
@@ -11,15 +13,21 @@
 #include "core/context.hpp"
 #include "core/event.hpp"
 #include "core/event_handler.hpp"
+#include "core/events/buffer_follow_update.hpp"
+#include "core/events/buffer_grep_progress.hpp"
+#include "core/events/buffer_load_progress.hpp"
 #include "core/events/buffer_loaded.hpp"
+#include "core/events/grep_count_finished.hpp"
 #include "core/events/resize.hpp"
 #include "core/events/search_finished.hpp"
 #include "core/input.hpp"
+#include "core/literal_search.hpp"
 #include "core/logger.hpp"
 #include "core/main_loop.hpp"
 #include "core/message_line.hpp"
 #include "core/mode.hpp"
 #include "core/palette.hpp"
+#include "core/timestamp.hpp"
 #include "core/utf8.hpp"
 #include "core/window.hpp"
 #include "sys/system.hpp"
@@ -30,6 +38,7 @@
 #include "utils/maybe.hpp"
 #include "utils/shared_ptr.hpp"
 #include "utils/string.hpp"
+#include "utils/units.hpp"
 
 namespace core
 {
@@ -105,7 +114,8 @@ struct MainView::Impl final : MainView
     constexpr size_t getAvailableViewWidth(Window& w) const
     {
         return mWidth
-            - (w.config->showLineNumbers * (w.lineNrDigits + w.config->lineNumberSeparator.get().length() + 1));
+            - (w.config->showLineNumbers * (w.lineNrDigits + w.config->lineNumberSeparator.get().length() + 1))
+            - (w.sourceWidth ? w.sourceWidth + 1 : 0);
     }
 
     constexpr Buffer* currentLoadedBuffer()
@@ -147,6 +157,9 @@ struct MainView::Impl final : MainView
     void goTo(Window& w, size_t lineNumber, Context& context);
     void goTo(size_t lineNumber, Context& context);
     void goToAbsolute(size_t lineNumber, Context& context);
+    void goToTime(Window& w, Buffer& buffer, Timestamp timestamp, Context& context);
+    void goToTime(std::string time, Context& context);
+    void timeJump(Movement m, Context& context);
     void center(Context& context);
     void lineStart();
     void lineEnd();
@@ -276,7 +289,39 @@ void MainView::initializeInputMapping(Context& context)
         [this](EventPtr event, InputSource, Context& context)
         {
             auto& ev = event->cast<events::BufferLoaded>();
-            bufferLoaded(ev.result, ev.node, context);
+            bufferLoaded(ev.result, ev.node, ev.follow, context);
+        });
+
+    registerEventHandler(
+        Event::Type::BufferLoadProgress,
+        [this](EventPtr event, InputSource, Context& context)
+        {
+            auto& ev = event->cast<events::BufferLoadProgress>();
+            bufferLoadProgress(std::move(ev.progress), ev.node, context);
+        });
+
+    registerEventHandler(
+        Event::Type::BufferGrepProgress,
+        [this](EventPtr event, InputSource, Context& context)
+        {
+            auto& ev = event->cast<events::BufferGrepProgress>();
+            bufferGrepProgress(std::move(ev.progress), ev.node, context);
+        });
+
+    registerEventHandler(
+        Event::Type::BufferFollowUpdate,
+        [this](EventPtr event, InputSource, Context& context)
+        {
+            auto& ev = event->cast<events::BufferFollowUpdate>();
+            bufferFollowUpdate(std::move(ev.update), ev.bufferId, context);
+        });
+
+    registerEventHandler(
+        Event::Type::GrepCountFinished,
+        [this](EventPtr event, InputSource, Context& context)
+        {
+            auto& ev = event->cast<events::GrepCountFinished>();
+            grepCountFinished(ev.result, ev.patterns, ev.name, context);
         });
 
     registerEventHandler(
@@ -308,6 +353,8 @@ void MainView::initializeInputMapping(Context& context)
     REGISTER_MAPPING("e",            NORMAL | VISUAL,    "Move cursor forward to word end", impl.forwardWordEnd());
     REGISTER_MAPPING("<c-e>",        NORMAL | VISUAL,    "Scroll down by 1 line", impl.scrollDown(context));
     REGISTER_MAPPING("<c-y>",        NORMAL | VISUAL,    "Scroll up by 1 line", impl.scrollUp(context));
+    REGISTER_MAPPING("]t",           NORMAL | VISUAL,    "Jump forward in time", impl.timeJump(Impl::Movement::forward, context));
+    REGISTER_MAPPING("[t",           NORMAL | VISUAL,    "Jump backward in time", impl.timeJump(Impl::Movement::backward, context));
     REGISTER_MAPPING("zz",           NORMAL | VISUAL,    "Center current line", impl.center(context));
     REGISTER_MAPPING("zs",           NORMAL | VISUAL,    "Scroll horizontally to the cursor", impl.scrollHorizontallyToCursor());
     REGISTER_MAPPING("^",            NORMAL | VISUAL,    "Go to line beginning", impl.lineStart());
@@ -379,7 +426,52 @@ WindowNode& MainView::createWindow(std::string name, Parent parent, Context& con
     return *mCurrentWindowNode;
 }
 
-void MainView::bufferLoaded(TimeOrError result, WindowNode& node, Context& context)
+void MainView::bufferLoadProgress(LoadProgress progress, WindowNode& node, Context& context)
+{
+    auto buffer = node.buffer();
+
+    if (not buffer) [[unlikely]]
+    {
+        return;
+    }
+
+    buffer->applyLoadProgress(std::move(progress));
+
+    if (not node.loaded())
+    {
+        logger.info() << node.parent()->name() << ": first screen after " << (buffer->firstChunkTime() | utils::precision(3)) << " s";
+        node.loaded(true);
+    }
+
+    Impl::get(this).reloadWindow(node, context);
+}
+
+void MainView::bufferGrepProgress(GrepProgress progress, WindowNode& node, Context& context)
+{
+    auto buffer = node.buffer();
+
+    if (not buffer) [[unlikely]]
+    {
+        return;
+    }
+
+    const auto time = progress.time;
+
+    if (not buffer->applyGrepProgress(std::move(progress)))
+    {
+        return;
+    }
+
+    if (not node.loaded())
+    {
+        logger.info() << node.parent()->name() << ": first matches after " << (time | utils::precision(3)) << " s";
+        node.loaded(true);
+    }
+
+    Impl::get(this).reloadWindow(node, context);
+}
+
+void MainView::bufferLoaded(TimeOrError result, WindowNode& node, bool follow, Context& context)
 {
     if (result) [[likely]]
     {
@@ -393,9 +485,45 @@ void MainView::bufferLoaded(TimeOrError result, WindowNode& node, Context& conte
         node.loaded(true);
         Impl::get(this).reloadWindow(node, context);
 
-        context.messageLine.info()
-            << node.parent()->name() << ": buffer loaded; lines: " << newBuffer->lineCount() << "; took "
-            << (*result | utils::precision(3)) << " s";
+        auto message = context.messageLine.info();
+
+        message << node.parent()->name() << ": buffer loaded; lines: " << newBuffer->lineCount();
+
+        if (newBuffer->isGrepCached())
+        {
+            message << "; cached";
+        }
+        else
+        {
+            message << "; took " << (*result | utils::precision(3)) << " s";
+        }
+
+        if (newBuffer->isBase() and *result > 0)
+        {
+            const auto throughput = static_cast<float>(newBuffer->fileSize()) / MiB / *result;
+            const auto indexSize = newBuffer->indexMemoryUsage();
+            const auto bytesPerLine = static_cast<float>(indexSize) / utils::max(newBuffer->lineCount(), size_t(1));
+            message << " (" << (throughput | utils::precision(1)) << " MiB/s); index: "
+                << (static_cast<float>(indexSize) / MiB | utils::precision(1)) << " MiB, "
+                << (bytesPerLine | utils::precision(2)) << " B/line";
+
+            logger.info() << node.parent()->name() << ": loaded in " << (*result | utils::precision(3))
+                << " s; first screen after " << (newBuffer->firstChunkTime() | utils::precision(3)) << " s";
+        }
+
+        if (const auto& prefilter = newBuffer->grepPrefilter(); not prefilter.empty())
+        {
+            message << "; regex prefilter: \"" << prefilter << '"';
+        }
+
+        if (follow and newBuffer->isBase() and not newBuffer->isCompressed())
+        {
+            newBuffer->follow(
+                [bufferId = node.bufferId(), &context](FollowUpdate update)
+                {
+                    sendEvent<events::BufferFollowUpdate>(InputSource::internal, context, std::move(update), bufferId);
+                });
+        }
     }
     else
     {
@@ -413,6 +541,159 @@ void MainView::bufferLoaded(TimeOrError result, WindowNode& node, Context& conte
     }
 }
 
+void MainView::grepCountFinished(const GrepCountOrError& result, const std::string& patterns, const std::string& name, Context& context)
+{
+    if (not result) [[unlikely]]
+    {
+        const auto& error = result.error();
+        if (error == BufferError::Aborted)
+        {
+            context.messageLine.info() << error;
+        }
+        else
+        {
+            context.messageLine.error() << error;
+        }
+        return;
+    }
+
+    auto message = context.messageLine.info();
+
+    message << name << ": " << result->lines << " lines";
+
+    // Patterns are separated by newlines, like in grep
+    if (not result->patterns.empty())
+    {
+        const auto list = patterns | utils::splitBy("\n");
+
+        for (size_t i = 0; i < list.size() and i < result->patterns.size(); ++i)
+        {
+            message << (i ? ", " : " (") << list[i] << ": " << result->patterns[i];
+        }
+
+        message << ')';
+    }
+
+    message << "; took " << (result->time | utils::precision(3)) << " s";
+}
+
+void MainView::bufferFollowUpdate(FollowUpdate update, BufferId bufferId, Context& context)
+{
+    auto buffer = getBuffer(bufferId, context);
+
+    // Updates sent before unfollow are dropped
+    if (not buffer or not buffer->isFollowing()) [[unlikely]]
+    {
+        return;
+    }
+
+    auto& impl = Impl::get(this);
+
+    const auto type = update.type;
+
+    // Windows with cursor on the last line keep following the end of file
+    std::vector<WindowNode*> nodesAtEnd;
+
+    mRoot.forEachRecursive(
+        [&impl, &nodesAtEnd, buffer](WindowNode& n)
+        {
+            if (n.type() == WindowNode::Type::window and n.loaded() and n.buffer() == buffer)
+            {
+                auto& w = n.window();
+                if (impl.lineIndex(w) + 1 >= w.lineCount)
+                {
+                    nodesAtEnd.push_back(&n);
+                }
+            }
+        });
+
+    auto result = buffer->applyFollowUpdate(std::move(update));
+
+    if (not result) [[unlikely]]
+    {
+        context.messageLine.error() << buffer->filePath() << ": " << result.error() << "; not following anymore";
+        buffer->unfollow();
+        return;
+    }
+
+    if (not *result)
+    {
+        return;
+    }
+
+    if (type == FollowUpdate::Type::replaced)
+    {
+        // Derived buffers refer to lines of the old file, and have a copy of
+        // it, so their windows are closed; they are all in the group of the
+        // base window
+        std::vector<WindowNode*> derivedNodes;
+
+        mRoot.forEachRecursive(
+            [&derivedNodes, buffer](WindowNode& n)
+            {
+                if (n.type() == WindowNode::Type::window and n.isBase() and n.buffer() == buffer)
+                {
+                    for (auto& child : n.parent()->children())
+                    {
+                        if (child->type() == WindowNode::Type::group)
+                        {
+                            derivedNodes.push_back(child.get());
+                        }
+                    }
+                }
+            });
+
+        const auto isRemoved =
+            [&derivedNodes](WindowNode* node)
+            {
+                for (; node; node = node->parent())
+                {
+                    if (std::ranges::contains(derivedNodes, node))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            };
+
+        const auto currentWindowNode = isRemoved(mCurrentWindowNode) ? nullptr : mCurrentWindowNode;
+
+        for (auto node : derivedNodes)
+        {
+            impl.removeWindow(*node, context);
+        }
+
+        if (currentWindowNode)
+        {
+            mCurrentWindowNode = currentWindowNode;
+        }
+
+        context.messageLine.info() << buffer->filePath() << ": file was truncated or replaced; reloaded"
+            << (derivedNodes.empty() ? "" : " and closed derived windows");
+        reloadAll(context);
+    }
+    else
+    {
+        mRoot.forEachRecursive(
+            [&impl, &context, buffer](WindowNode& n)
+            {
+                if (n.type() == WindowNode::Type::window and n.buffer() == buffer)
+                {
+                    impl.reloadWindow(n, context);
+                }
+            });
+    }
+
+    for (auto node : nodesAtEnd)
+    {
+        auto& w = node->window();
+        if (w.lineCount)
+        {
+            impl.goTo(w, w.lineCount - 1, context);
+        }
+    }
+}
+
 void MainView::escape()
 {
     auto node = Impl::get(this).currentLoadedWindowNode();
@@ -453,6 +734,11 @@ void MainView::scrollToAbsolute(size_t lineNumber, Context& context)
     Impl::get(this).goToAbsolute(lineNumber, context);
 }
 
+void MainView::scrollToTime(std::string time, Context& context)
+{
+    Impl::get(this).goToTime(std::move(time), context);
+}
+
 void MainView::searchForward(std::string pattern, Context& context)
 {
     auto& impl = Impl::get(this);
@@ -563,6 +849,24 @@ void MainView::Impl::removeWindow(WindowNode& node, Context&)
     }
 }
 
+// Lines of merged buffers are tagged with names of files they come from
+static size_t getSourceWidth(const Buffer& buffer)
+{
+    if (buffer.sourceCount() < 2)
+    {
+        return 0;
+    }
+
+    size_t width = 0;
+
+    for (size_t i = 0; i < buffer.sourceCount(); ++i)
+    {
+        width = utils::max(width, buffer.sourceName(i).size());
+    }
+
+    return width;
+}
+
 void MainView::Impl::reloadWindow(WindowNode& node, Context& context)
 {
     if (not node.loaded()) [[unlikely]]
@@ -581,6 +885,7 @@ void MainView::Impl::reloadWindow(WindowNode& node, Context& context)
 
     w.lineCount = buffer->lineCount();
     w.lineNrDigits = utils::numberOfDigits(buffer->fileLineCount());
+    w.sourceWidth = getSourceWidth(*buffer);
     w.width = getAvailableViewWidth(w);
     w.height = min(getAvailableViewHeight(node), w.lineCount);
     w.ringBuffer = RingBuffer(w.height);
@@ -688,6 +993,75 @@ static Glyphs getGlyphs(std::string_view line, const Config& config)
     return glyphs;
 }
 
+// Matches of searched pattern may differ in case, so they're not found by the
+// trie with other highlighted patterns; instead, they're laid over segments
+// made for these
+static void highlightMatches(BufferLine& line, std::string_view data, const LiteralSearch& search, uint32_t color)
+{
+    const auto len = search.pattern().size();
+
+    const auto glyphIndex =
+        [&line](size_t offset)
+        {
+            return static_cast<size_t>(std::ranges::lower_bound(line.glyphs, offset, {}, &Glyph::offset) - line.glyphs.begin());
+        };
+
+    std::vector<std::pair<size_t, size_t>> matches;
+
+    for (auto pos = search.find(data); pos != LiteralSearch::npos; pos = search.find(data, pos + len))
+    {
+        matches.emplace_back(glyphIndex(pos), glyphIndex(pos + len));
+    }
+
+    if (matches.empty())
+    {
+        return;
+    }
+
+    ColoredStrings segments;
+    segments.reserve(line.segments.size() + 2 * matches.size());
+
+    auto match = matches.begin();
+
+    const auto glyphs =
+        [&line](size_t first, size_t last)
+        {
+            return GlyphsSpan(line.glyphs.begin() + first, line.glyphs.begin() + last);
+        };
+
+    for (const auto& segment : line.segments)
+    {
+        auto first = static_cast<size_t>(segment.glyphs.data() - line.glyphs.data());
+        const auto last = first + segment.glyphs.size();
+
+        while (first < last)
+        {
+            while (match != matches.end() and match->second <= first)
+            {
+                ++match;
+            }
+
+            if (match == matches.end() or match->first >= last)
+            {
+                segments.emplace_back(segment.color, segment.defColor, glyphs(first, last));
+                break;
+            }
+
+            if (match->first > first)
+            {
+                segments.emplace_back(segment.color, segment.defColor, glyphs(first, match->first));
+                first = match->first;
+            }
+
+            const auto end = utils::min(last, match->second);
+            segments.emplace_back(color, false, glyphs(first, end));
+            first = end;
+        }
+    }
+
+    line.segments = std::move(segments);
+}
+
 BufferLine MainView::Impl::getLine(Buffer& buffer, size_t lineIndex, Context& context)
 {
     auto result = buffer.readLine(lineIndex);
@@ -701,9 +1075,13 @@ BufferLine MainView::Impl::getLine(Buffer& buffer, size_t lineIndex, Context& co
 
     auto& data = *result;
 
+    const auto source = buffer.lineSource(lineIndex);
+
     BufferLine line{
         .lineNumber = lineIndex,
         .absoluteLineNumber = buffer.absoluteLineNumber(lineIndex),
+        .source = source,
+        .sourceName = buffer.sourceCount() > 1 ? std::string_view(buffer.sourceName(source)) : std::string_view(),
         .glyphs = getGlyphs(data, config),
     };
 
@@ -769,6 +1147,11 @@ BufferLine MainView::Impl::getLine(Buffer& buffer, size_t lineIndex, Context& co
         true,
         GlyphsSpan(startIt, line.glyphs.end()));
 
+    if (mSearchHighlight)
+    {
+        highlightMatches(line, data, *mSearchHighlight, Palette::magenta);
+    }
+
     return line;
 }
 
@@ -1103,6 +1486,66 @@ void MainView::Impl::goToAbsolute(size_t lineNumber, Context& context)
     goTo(w, lineNumber, context);
 }
 
+void MainView::Impl::goToTime(Window& w, Buffer& buffer, Timestamp timestamp, Context& context)
+{
+    const auto lineIndex = buffer.findTimestamp(timestamp);
+
+    if (lineIndex >= w.lineCount)
+    {
+        context.messageLine.error() << "No lines after given time";
+        return;
+    }
+
+    goTo(w, lineIndex, context);
+}
+
+void MainView::Impl::goToTime(std::string time, Context& context)
+{
+    GET_WINDOW_AND_BUFFER(w, buffer);
+
+    if (not buffer->hasTimestamps())
+    {
+        context.messageLine.error() << "Buffer has no timestamps; set timestampFormat and reopen the file";
+        return;
+    }
+
+    // Time without date refers to the day of the current line, or of the
+    // first line with timestamp
+    auto reference = buffer->lineTimestamp(lineIndex(w));
+
+    if (const auto first = buffer->findTimestamp(NO_TIMESTAMP + 1); not reference and first < buffer->lineCount())
+    {
+        reference = buffer->lineTimestamp(first);
+    }
+
+    const auto timestamp = parseTimeQuery(time, reference.value_or(0));
+
+    if (not timestamp)
+    {
+        context.messageLine.error() << "Invalid time: " << time;
+        return;
+    }
+
+    goToTime(w, *buffer, *timestamp, context);
+}
+
+void MainView::Impl::timeJump(Movement m, Context& context)
+{
+    GET_WINDOW_AND_BUFFER(w, buffer);
+
+    const auto current = buffer->lineTimestamp(lineIndex(w));
+
+    if (not current)
+    {
+        context.messageLine.error() << (buffer->hasTimestamps() ? "Current line has no timestamp" : "Buffer has no timestamps");
+        return;
+    }
+
+    const auto jump = Timestamp(context.config.timeJump.get()) * 60 * 1'000'000;
+
+    goToTime(w, *buffer, m == Movement::forward ? *current + jump : *current - jump, context);
+}
+
 void MainView::Impl::center(Context& context)
 {
     GET_WINDOW(w);
@@ -1292,13 +1735,9 @@ void MainView::Impl::startSearch(std::string pattern, SearchDirection direction)
 {
     GET_WINDOW(w);
 
-    mTrie.erase(mSearchPattern);
-
     mSearchPattern = std::move(pattern);
     mSearchMode = direction;
 
-    mTrie.insert(mSearchPattern, Pattern{.type = Pattern::Type::matchPatternOnly, .fgColor = Palette::magenta});
-
     w.foundAnything = false;
 }
 
@@ -1311,12 +1750,22 @@ void MainView::Impl::search(std::string pattern, SearchDirection direction, Cont
         return;
     }
 
+    if (not buffer->isSearchable()) [[unlikely]]
+    {
+        context.messageLine.error() << "Buffer is still loading";
+        return;
+    }
+
+    // Matches are highlighted with the same case folding as they are found
+    mSearchHighlight = utils::makeUnique<LiteralSearch>(mSearchPattern, context.config.ignoreCase);
+
     w.pendingSearch = true;
 
     buffer->search(
         SearchRequest{
             .direction = direction,
             .continuation = w.foundAnything,
+            .caseInsensitive = context.config.ignoreCase,
             .startLineIndex = lineIndex(w),
             .startLinePosition = linePosition(w),
             .pattern = pattern,
@@ -1354,6 +1803,19 @@ void MainView::Impl::handleSearchResult(
     float time,
     Context& context)
 {
+    // Matches published by grep while the buffer was searched were deferred
+    if (buffer.applyGrepProgress(GrepProgress{}))
+    {
+        mRoot.forEachRecursive(
+            [this, &buffer, &context](WindowNode& n)
+            {
+                if (n.type() == WindowNode::Type::window and n.buffer() == &buffer)
+                {
+                    reloadWindow(n, context);
+                }
+            });
+    }
+
     if (result.aborted)
     {
         context.messageLine.error() << "Aborted search: " << pattern;
@@ -5,6 +5,7 @@
 #include "core/window_node.hpp"
 #include "utils/immobile.hpp"
 #include "utils/trie.hpp"
+#include "utils/unique_ptr.hpp"
 
 namespace core
 {
@@ -37,11 +38,16 @@ struct MainView : utils::Immobile
     void initializeInputMapping(Context& context);
     void reloadAll(Context& context);
     WindowNode& createWindow(std::string name, Parent parent, Context& context);
-    void bufferLoaded(TimeOrError result, WindowNode& node, Context& context);
+    void bufferLoadProgress(LoadProgress progress, WindowNode& node, Context& context);
+    void bufferGrepProgress(GrepProgress progress, WindowNode& node, Context& context);
+    void bufferLoaded(TimeOrError result, WindowNode& node, bool follow, Context& context);
+    void bufferFollowUpdate(FollowUpdate update, BufferId bufferId, Context& context);
+    void grepCountFinished(const GrepCountOrError& result, const std::string& patterns, const std::string& name, Context& context);
     void escape();
     void quitCurrentWindow(Context& context);
     void scrollTo(size_t lineNumber, Context& context);
     void scrollToAbsolute(size_t lineNumber, Context& context);
+    void scrollToTime(std::string time, Context& context);
     void searchForward(std::string pattern, Context& context);
     void searchBackward(std::string pattern, Context& context);
     void highlight(std::string pattern, std::string colorString, Context& context);
@@ -61,6 +67,8 @@ private:
     SearchDirection      mSearchMode;
     std::string          mSearchPattern;
     utils::Trie<Pattern> mTrie;
+
+    utils::UniquePtr<LiteralSearch> mSearchHighlight;
 };
 
 }  // namespace core
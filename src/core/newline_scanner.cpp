@@ -0,0 +1,161 @@
+#include "newline_scanner.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "utils/inline.hpp"
+
+namespace core
+{
+
+using FindNewlinesFn = size_t(*)(const char* data, size_t len, uint32_t* positions);
+
+struct NewlineScanner
+{
+    const char*    name;
+    FindNewlinesFn find;
+};
+
+ALWAYS_INLINE static size_t findNewlinesTail(const char* data, size_t start, size_t len, uint32_t* positions, size_t count)
+{
+    for (size_t i = start; i < len; ++i)
+    {
+        // Branchless: position is always written, but count is advanced only
+        // for newlines; count <= i, so this never writes past positions[len - 1]
+        positions[count] = static_cast<uint32_t>(i);
+        count += data[i] == '\n';
+    }
+    return count;
+}
+
+ALWAYS_INLINE static size_t storeMask(uint64_t mask, uint32_t base, uint32_t* positions, size_t count)
+{
+    while (mask)
+    {
+        positions[count++] = base + static_cast<uint32_t>(__builtin_ctzll(mask));
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+#if defined(__x86_64__)
+
+[[gnu::target("sse2")]]
+static size_t findNewlinesSse2(const char* data, size_t len, uint32_t* positions)
+{
+    const auto newline = _mm_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+
+    for (; i + 64 <= len; i += 64)
+    {
+        const auto m0 = static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), newline))));
+        const auto m1 = static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16)), newline))));
+        const auto m2 = static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 32)), newline))));
+        const auto m3 = static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 48)), newline))));
+
+        count = storeMask(m0 | (m1 << 16) | (m2 << 32) | (m3 << 48), i, positions, count);
+    }
+
+    for (; i + 16 <= len; i += 16)
+    {
+        const auto mask = static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), newline))));
+
+        count = storeMask(mask, i, positions, count);
+    }
+
+    return findNewlinesTail(data, i, len, positions, count);
+}
+
+[[gnu::target("avx2")]]
+static size_t findNewlinesAvx2(const char* data, size_t len, uint32_t* positions)
+{
+    const auto newline = _mm256_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+
+    for (; i + 64 <= len; i += 64)
+    {
+        const auto lo = static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), newline))));
+        const auto hi = static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32)), newline))));
+
+        count = storeMask(lo | (hi << 32), i, positions, count);
+    }
+
+    return findNewlinesTail(data, i, len, positions, count);
+}
+
+[[gnu::target("avx512f,avx512bw")]]
+static size_t findNewlinesAvx512(const char* data, size_t len, uint32_t* positions)
+{
+    const auto newline = _mm512_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+
+    for (; i + 64 <= len; i += 64)
+    {
+        const auto mask = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(data + i), newline);
+        count = storeMask(mask, i, positions, count);
+    }
+
+    if (i < len)
+    {
+        const auto tailMask = (1ull << (len - i)) - 1;
+        const auto mask = _mm512_cmpeq_epi8_mask(_mm512_maskz_loadu_epi8(tailMask, data + i), newline);
+        count = storeMask(mask & tailMask, i, positions, count);
+    }
+
+    return count;
+}
+
+static NewlineScanner selectScanner()
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512bw"))
+    {
+        return {.name = "avx512", .find = &findNewlinesAvx512};
+    }
+    else if (__builtin_cpu_supports("avx2"))
+    {
+        return {.name = "avx2", .find = &findNewlinesAvx2};
+    }
+
+    return {.name = "sse2", .find = &findNewlinesSse2};
+}
+
+#else
+
+static size_t findNewlinesScalar(const char* data, size_t len, uint32_t* positions)
+{
+    return findNewlinesTail(data, 0, len, positions, 0);
+}
+
+static NewlineScanner selectScanner()
+{
+    return {.name = "scalar", .find = &findNewlinesScalar};
+}
+
+#endif
+
+static const NewlineScanner scanner = selectScanner();
+
+size_t findNewlines(const char* data, size_t len, uint32_t* positions)
+{
+    return scanner.find(data, len, positions);
+}
+
+const char* newlineScannerName()
+{
+    return scanner.name;
+}
+
+}  // namespace core
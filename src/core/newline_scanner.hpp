@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "utils/units.hpp"
+
+namespace core
+{
+
+constexpr static size_t NEWLINE_SCAN_WINDOW = 64_KiB;
+
+// Stores offsets (relative to data) of all '\n' characters found in
+// [data, data + len) and returns their count. Offsets are emitted in
+// ascending order; positions must have room for len entries
+size_t findNewlines(const char* data, size_t len, uint32_t* positions);
+
+// Name of the kernel selected at runtime for the current CPU
+const char* newlineScannerName();
+
+}  // namespace core
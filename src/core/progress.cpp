@@ -0,0 +1,129 @@
+#include "progress.hpp"
+
+namespace core
+{
+
+Progress::Progress()
+    : mRunning(false)
+    , mTotal(0)
+    , mTime(0)
+{
+}
+
+Progress::~Progress() = default;
+
+void Progress::start(size_t threadCount)
+{
+    mCounters = std::vector<Counter>(threadCount);
+    mTimer = utils::startTimeMeasurement();
+    mTotal.store(0, std::memory_order_relaxed);
+    mTime.store(0, std::memory_order_relaxed);
+    mRunning.store(true, std::memory_order_release);
+}
+
+void Progress::setTotal(size_t units)
+{
+    mTotal.store(units, std::memory_order_relaxed);
+}
+
+Progress::Counter& Progress::counter(size_t thread)
+{
+    return mCounters[thread];
+}
+
+void Progress::begin(size_t thread)
+{
+    mCounters[thread].mStart.store(mTimer.elapsed(), std::memory_order_relaxed);
+}
+
+void Progress::finish(size_t thread)
+{
+    auto& counter = mCounters[thread];
+    counter.mTime.store(mTimer.elapsed() - counter.mStart.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void Progress::stop()
+{
+    mTime.store(mTimer.elapsed(), std::memory_order_relaxed);
+    mRunning.store(false, std::memory_order_release);
+}
+
+bool Progress::running() const
+{
+    return mRunning.load(std::memory_order_acquire);
+}
+
+size_t Progress::total() const
+{
+    return mTotal.load(std::memory_order_relaxed);
+}
+
+size_t Progress::units() const
+{
+    size_t units = 0;
+    for (const auto& counter : mCounters)
+    {
+        units += counter.mUnits.load(std::memory_order_relaxed);
+    }
+    return units;
+}
+
+size_t Progress::bytes() const
+{
+    size_t bytes = 0;
+    for (const auto& counter : mCounters)
+    {
+        bytes += counter.mBytes.load(std::memory_order_relaxed);
+    }
+    return bytes;
+}
+
+float Progress::elapsed() const
+{
+    return running()
+        ? mTimer.elapsed()
+        : mTime.load(std::memory_order_relaxed);
+}
+
+float Progress::eta() const
+{
+    const auto done = units();
+    const auto total = this->total();
+
+    if (done == 0 or total == 0)
+    {
+        return -1;
+    }
+
+    if (done >= total)
+    {
+        return 0;
+    }
+
+    return elapsed() * static_cast<float>(total - done) / static_cast<float>(done);
+}
+
+Progress::ThreadSummaries Progress::summary() const
+{
+    ThreadSummaries summaries;
+
+    for (const auto& counter : mCounters)
+    {
+        const auto units = counter.mUnits.load(std::memory_order_relaxed);
+
+        if (units == 0)
+        {
+            continue;
+        }
+
+        summaries.emplace_back(ThreadSummary{
+            .units = units,
+            .bytes = counter.mBytes.load(std::memory_order_relaxed),
+            .time = counter.mTime.load(std::memory_order_relaxed),
+        });
+    }
+
+    return summaries;
+}
+
+}  // namespace core
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "utils/immobile.hpp"
+#include "utils/time.hpp"
+
+namespace core
+{
+
+// Progress of a long running buffer operation, like loading or grep. Work is
+// counted in units, which are bytes or lines, and in bytes, so that both the
+// part done and the throughput are known. Each worker thread owns a counter
+// which only it updates, so that counting doesn't need any synchronization;
+// the main thread reads the counters to show progress, and after the
+// operation to show how the work was spread across threads
+struct Progress final : utils::Immobile
+{
+    struct alignas(64) Counter final
+    {
+        void add(size_t units, size_t bytes)
+        {
+            mUnits.store(mUnits.load(std::memory_order_relaxed) + units, std::memory_order_relaxed);
+            mBytes.store(mBytes.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+        }
+
+    private:
+        friend Progress;
+        std::atomic_size_t mUnits{0};
+        std::atomic_size_t mBytes{0};
+        std::atomic<float> mStart{0};
+        std::atomic<float> mTime{0};
+    };
+
+    // Time is the one thread was busy for, from begin to finish
+    struct ThreadSummary final
+    {
+        size_t units;
+        size_t bytes;
+        float  time;
+    };
+
+    using ThreadSummaries = std::vector<ThreadSummary>;
+
+    Progress();
+    ~Progress();
+
+    // Must be called on the main thread, before any worker starts
+    void start(size_t threadCount);
+
+    // Total amount of units may be known only once the operation has started
+    void setTotal(size_t units);
+
+    Counter& counter(size_t thread);
+
+    // Marks thread as started; thread which doesn't call it is counted as
+    // busy since start of the operation
+    void begin(size_t thread);
+
+    // Marks thread as done, so that its throughput is known
+    void finish(size_t thread);
+    void stop();
+
+    bool running() const;
+    size_t total() const;
+    size_t units() const;
+    size_t bytes() const;
+    float elapsed() const;
+
+    // Estimated time left in seconds, or negative if not known yet
+    float eta() const;
+
+    // Threads which did any work, in order
+    ThreadSummaries summary() const;
+
+private:
+    std::atomic_bool     mRunning;
+    std::atomic_size_t   mTotal;
+    std::atomic<float>   mTime;
+    utils::Timer         mTimer;
+    std::vector<Counter> mCounters;
+};
+
+}  // namespace core
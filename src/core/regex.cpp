@@ -1,6 +1,8 @@
 #include "regex.hpp"
 
 #include <re2/re2.h>
+#include <re2/regexp.h>
+#include <re2/set.h>
 
 #include "utils/inline.hpp"
 #include "utils/memory.hpp"
@@ -44,4 +46,187 @@ bool Regex::partialMatch(const std::string_view& sv)
     return RE2::PartialMatch(sv, *impl(mData));
 }
 
+ALWAYS_INLINE constexpr static RE2::Set* setImpl(char* data)
+{
+    return reinterpret_cast<RE2::Set*>(data);
+}
+
+// Set of many regexes needs more memory than the default budget for a
+// single one
+constexpr static int64_t REGEX_SET_MAX_MEM = 64 << 20;
+
+RegexSet::RegexSet(std::span<const std::string> regexes, bool caseInsensitive)
+{
+    static_assert(sizeof(mData) >= sizeof(RE2::Set), "Too small size of opaque mData");
+
+    RE2::Options reOptions;
+    reOptions.set_log_errors(false);
+    reOptions.set_case_sensitive(not caseInsensitive);
+    reOptions.set_max_mem(REGEX_SET_MAX_MEM);
+
+    auto set = utils::constructAt(setImpl(mData), reOptions, RE2::UNANCHORED);
+
+    for (const auto& regex : regexes)
+    {
+        if (set->Add(regex, &mError) < 0)
+        {
+            mError = regex + ": " + mError;
+            return;
+        }
+    }
+
+    if (not set->Compile())
+    {
+        mError = "Regex set is too big";
+    }
+}
+
+RegexSet::~RegexSet()
+{
+    utils::destroyAt(setImpl(mData));
+}
+
+bool RegexSet::ok()
+{
+    return mError.empty();
+}
+
+std::string RegexSet::error()
+{
+    return mError;
+}
+
+bool RegexSet::partialMatch(const std::string_view& sv)
+{
+    return setImpl(mData)->Match(sv, nullptr);
+}
+
+bool RegexSet::match(const std::string_view& sv, std::vector<int>& indices)
+{
+    return setImpl(mData)->Match(sv, &indices);
+}
+
+static void appendUtf8(std::string& string, re2::Rune rune)
+{
+    if (rune < 0x80)
+    {
+        string += static_cast<char>(rune);
+    }
+    else if (rune < 0x800)
+    {
+        string += static_cast<char>(0xc0 | (rune >> 6));
+        string += static_cast<char>(0x80 | (rune & 0x3f));
+    }
+    else if (rune < 0x10000)
+    {
+        string += static_cast<char>(0xe0 | (rune >> 12));
+        string += static_cast<char>(0x80 | ((rune >> 6) & 0x3f));
+        string += static_cast<char>(0x80 | (rune & 0x3f));
+    }
+    else
+    {
+        string += static_cast<char>(0xf0 | (rune >> 18));
+        string += static_cast<char>(0x80 | ((rune >> 12) & 0x3f));
+        string += static_cast<char>(0x80 | ((rune >> 6) & 0x3f));
+        string += static_cast<char>(0x80 | (rune & 0x3f));
+    }
+}
+
+static void pickLonger(RequiredLiteral& best, RequiredLiteral&& candidate)
+{
+    if (candidate.text.size() > best.text.size()
+        or (candidate.text.size() == best.text.size() and best.caseInsensitive and not candidate.caseInsensitive))
+    {
+        best = std::move(candidate);
+    }
+}
+
+// Parser turns case folded literal into a literal with FoldCase flag only
+// if it's an ASCII letter; other ones, like 'k', which also matches Kelvin
+// sign, are character classes. So literal search folding ASCII is enough
+static RequiredLiteral requiredLiteral(re2::Regexp* re)
+{
+    RequiredLiteral result;
+
+    switch (re->op())
+    {
+        case re2::kRegexpLiteral:
+            appendUtf8(result.text, re->rune());
+            result.caseInsensitive = re->parse_flags() & re2::Regexp::FoldCase;
+            break;
+
+        case re2::kRegexpLiteralString:
+            for (int i = 0; i < re->nrunes(); ++i)
+            {
+                appendUtf8(result.text, re->runes()[i]);
+            }
+            result.caseInsensitive = re->parse_flags() & re2::Regexp::FoldCase;
+            break;
+
+        case re2::kRegexpConcat:
+        {
+            // Adjacent literals make a single string; assertions don't
+            // consume anything, so they don't break it
+            RequiredLiteral run;
+
+            for (int i = 0; i < re->nsub(); ++i)
+            {
+                const auto sub = re->sub()[i];
+
+                switch (sub->op())
+                {
+                    case re2::kRegexpLiteral:
+                    case re2::kRegexpLiteralString:
+                    {
+                        auto literal = requiredLiteral(sub);
+                        run.text += literal.text;
+                        run.caseInsensitive |= literal.caseInsensitive;
+                        break;
+                    }
+
+                    case re2::kRegexpEmptyMatch:
+                    case re2::kRegexpBeginLine:
+                    case re2::kRegexpEndLine:
+                    case re2::kRegexpBeginText:
+                    case re2::kRegexpEndText:
+                    case re2::kRegexpWordBoundary:
+                    case re2::kRegexpNoWordBoundary:
+                        break;
+
+                    default:
+                        pickLonger(result, std::move(run));
+                        run = {};
+                        pickLonger(result, requiredLiteral(sub));
+                        break;
+                }
+            }
+
+            pickLonger(result, std::move(run));
+            break;
+        }
+
+        case re2::kRegexpCapture:
+        case re2::kRegexpPlus:
+            result = requiredLiteral(re->sub()[0]);
+            break;
+
+        case re2::kRegexpRepeat:
+            if (re->min() > 0)
+            {
+                result = requiredLiteral(re->sub()[0]);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return result;
+}
+
+RequiredLiteral Regex::requiredLiteral()
+{
+    return core::requiredLiteral(impl(mData)->Regexp());
+}
+
 }  // namespace core
@@ -1,12 +1,20 @@
 #pragma once
 
+#include <span>
 #include <string>
+#include <vector>
 
 #include "utils/immobile.hpp"
 
 namespace core
 {
 
+struct RequiredLiteral
+{
+    std::string text;
+    bool        caseInsensitive = false;
+};
+
 struct Regex : utils::Immobile
 {
     Regex(std::string regex, bool caseInsensitive);
@@ -16,8 +24,32 @@ struct Regex : utils::Immobile
     std::string error();
     bool partialMatch(const std::string_view& sv);
 
+    // Longest string which every match has to contain, found in the parsed
+    // pattern, e.g. "timeout after " for "timeout after \d+ms"; it's empty
+    // if there's no such string
+    RequiredLiteral requiredLiteral();
+
 private:
     char mData[160];
 };
 
+// Regexes matched together in a single pass; text matches if any of them
+// matches
+struct RegexSet : utils::Immobile
+{
+    RegexSet(std::span<const std::string> regexes, bool caseInsensitive);
+    ~RegexSet();
+
+    bool ok();
+    std::string error();
+    bool partialMatch(const std::string_view& sv);
+
+    // Indices of regexes matching sv, in no particular order
+    bool match(const std::string_view& sv, std::vector<int>& indices);
+
+private:
+    char        mData[160];
+    std::string mError;
+};
+
 }  // namespace regex
@@ -0,0 +1,117 @@
+#define LOG_HEADER "core::Spool"
+#include "spool.hpp"
+
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "core/logger.hpp"
+#include "sys/system.hpp"
+#include "utils/buffer.hpp"
+#include "utils/units.hpp"
+
+namespace core
+{
+
+constexpr static size_t CHUNK_SIZE = 1_MiB;
+constexpr static int WAIT_INTERVAL_MS = 100;
+
+Spool::Spool()
+    : mStopFlag(false)
+    , mInput(-1)
+    , mFile{.path = {}, .size = 0, .fd = -1, .identity = {}}
+{
+}
+
+Spool::~Spool()
+{
+    stop();
+
+    if (mFile.fd != -1)
+    {
+        sys::fileClose(mFile);
+    }
+
+    if (mInput != -1)
+    {
+        close(mInput);
+    }
+}
+
+std::expected<bool, std::string> Spool::start(sys::FileDescriptor input)
+{
+    mInput = input;
+
+    // Unlinked file is written from the start, so that its identity never
+    // changes under the follower. Page cache bounds memory use instead of
+    // the spool
+    auto result = sys::fileCreateTemporary();
+
+    if (not result) [[unlikely]]
+    {
+        utils::Buffer buf;
+        buf << "cannot create spool: " << sys::errorDescribe(result.error());
+        return std::unexpected(buf.str());
+    }
+
+    mFile = std::move(*result);
+    mThread = std::thread([this]{ run(); });
+
+    return true;
+}
+
+void Spool::stop()
+{
+    if (mThread.joinable())
+    {
+        mStopFlag = true;
+        mThread.join();
+    }
+}
+
+const std::string& Spool::path() const
+{
+    return mFile.path;
+}
+
+void Spool::run()
+{
+    std::vector<char> chunk(CHUNK_SIZE);
+
+    while (not mStopFlag)
+    {
+        // Wait is bounded, so that the stop flag is checked while the writer
+        // is idle
+        if (auto result = sys::streamWait(mInput, WAIT_INTERVAL_MS); not result) [[unlikely]]
+        {
+            logger.error() << "cannot wait for input: " << sys::errorDescribe(result.error());
+            break;
+        }
+        else if (not *result)
+        {
+            continue;
+        }
+
+        auto result = sys::streamRead(mInput, chunk.data(), chunk.size());
+
+        if (not result) [[unlikely]]
+        {
+            logger.error() << "cannot read input: " << sys::errorDescribe(result.error());
+            break;
+        }
+
+        if (*result == 0)
+        {
+            logger.info() << "input closed after " << mFile.size << " B";
+            break;
+        }
+
+        if (auto error = sys::fileAppend(mFile, chunk.data(), *result)) [[unlikely]]
+        {
+            logger.error() << "cannot write spool: " << sys::errorDescribe(error);
+            break;
+        }
+    }
+}
+
+}  // namespace core
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <expected>
+#include <string>
+#include <thread>
+
+#include "sys/file.hpp"
+#include "utils/immobile.hpp"
+
+namespace core
+{
+
+// Copies stream, e.g. a pipe on standard input, into a file which can be
+// loaded and followed like a regular one, as it only grows. Data is written
+// to an unlinked temporary file, reachable through its /proc/self/fd path
+struct Spool final : utils::Immobile
+{
+    Spool();
+    ~Spool();
+
+    std::expected<bool, std::string> start(sys::FileDescriptor input);
+    void stop();
+
+    const std::string& path() const;
+
+private:
+    void run();
+
+    std::atomic_bool    mStopFlag;
+    sys::FileDescriptor mInput;
+    sys::File           mFile;
+    std::thread         mThread;
+};
+
+}  // namespace core
@@ -1,33 +1,323 @@
 #include "thread.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
 #include <thread>
 #include <vector>
 
+#include "utils/immobile.hpp"
+
 namespace core
 {
 
 using Thread = std::thread;
 using Threads = std::vector<Thread>;
+using Clock = std::chrono::steady_clock;
 
 static const auto mainThreadId = std::this_thread::get_id();
 
+// Index of pool worker running on this thread, or -1 for other threads
+static thread_local int workerIndex = -1;
+
+// Tasks of a single executeInParallelAndWait call; remaining is guarded by
+// lock, so that the waiting thread cannot return while the last task is
+// still signalling completion
+struct TaskGroup final : utils::Immobile
+{
+    TaskGroup(size_t count)
+        : remaining(count)
+    {
+    }
+
+    size_t                  remaining;
+    std::mutex              lock;
+    std::condition_variable done;
+};
+
+struct Job final
+{
+    Task              task;
+    TaskGroup*        group;
+    Clock::time_point submitTime;
+};
+
+struct alignas(64) WorkerQueue final
+{
+    std::mutex      lock;
+    std::deque<Job> jobs;
+};
+
+// Each worker takes jobs from the back of its own queue, so that the most
+// recently forked ones, which share data with the running one, go first,
+// and steals from the front of other queues when its own is empty. Threads
+// which are not workers submit jobs to the queues round-robin
+struct ThreadPool final : utils::Immobile
+{
+    ThreadPool(unsigned size)
+        : mQueues(size)
+        , mQueued(0)
+        , mIdle(0)
+        , mNext(0)
+        , mTasks(0)
+        , mMaxQueued(0)
+        , mTotalLatency(0)
+        , mMaxLatency(0)
+    {
+        for (unsigned i = 0; i < size; ++i)
+        {
+            Thread([this, i]{ workerLoop(i); }).detach();
+        }
+    }
+
+    void submit(Job job)
+    {
+        const auto index = workerIndex != -1
+            ? static_cast<size_t>(workerIndex)
+            : mNext.fetch_add(1, std::memory_order_relaxed) % mQueues.size();
+
+        {
+            std::lock_guard lock(mQueues[index].lock);
+            mQueues[index].jobs.emplace_back(std::move(job));
+        }
+
+        const auto queued = mQueued.fetch_add(1, std::memory_order_release) + 1;
+
+        updateMax(mMaxQueued, queued);
+
+        // Lock is taken, so that the notification cannot be missed by a
+        // worker which has just found nothing to do
+        {
+            std::lock_guard lock(mSleepLock);
+        }
+
+        mWakeUp.notify_one();
+    }
+
+    // Whether a job submitted now would be picked up right away
+    bool hasIdleWorker() const
+    {
+        return mIdle.load(std::memory_order_acquire) > mQueued.load(std::memory_order_acquire);
+    }
+
+    void wait(TaskGroup& group)
+    {
+        Job job;
+
+        while (takeJobOf(group, job))
+        {
+            run(job);
+        }
+
+        // All remaining jobs are already running on other threads
+        std::unique_lock lock(group.lock);
+        group.done.wait(lock, [&group]{ return group.remaining == 0; });
+    }
+
+    void run(Job& job)
+    {
+        const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - job.submitTime).count();
+
+        mTasks.fetch_add(1, std::memory_order_relaxed);
+        mTotalLatency.fetch_add(static_cast<uint64_t>(latency), std::memory_order_relaxed);
+        updateMax(mMaxLatency, static_cast<uint64_t>(latency));
+
+        job.task();
+        job.task = nullptr;
+
+        if (job.group)
+        {
+            finish(*job.group);
+        }
+    }
+
+    static void finish(TaskGroup& group)
+    {
+        std::lock_guard lock(group.lock);
+
+        if (--group.remaining == 0)
+        {
+            group.done.notify_all();
+        }
+    }
+
+    ThreadPoolStats stats() const
+    {
+        const auto tasks = mTasks.load(std::memory_order_relaxed);
+
+        return ThreadPoolStats{
+            .workers = static_cast<unsigned>(mQueues.size()),
+            .tasks = tasks,
+            .queued = mQueued.load(std::memory_order_relaxed),
+            .maxQueued = mMaxQueued.load(std::memory_order_relaxed),
+            .averageLatency = tasks
+                ? static_cast<float>(mTotalLatency.load(std::memory_order_relaxed)) / static_cast<float>(tasks) / 1e9f
+                : 0,
+            .maxLatency = static_cast<float>(mMaxLatency.load(std::memory_order_relaxed)) / 1e9f,
+        };
+    }
+
+private:
+    void workerLoop(unsigned index)
+    {
+        workerIndex = static_cast<int>(index);
+
+        Job job;
+
+        while (true)
+        {
+            if (takeJob(index, job))
+            {
+                run(job);
+                continue;
+            }
+
+            std::unique_lock lock(mSleepLock);
+            mIdle.fetch_add(1, std::memory_order_release);
+            mWakeUp.wait(lock, [this]{ return mQueued.load(std::memory_order_acquire) > 0; });
+            mIdle.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool takeJob(unsigned index, Job& job)
+    {
+        const auto count = mQueues.size();
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto& queue = mQueues[(index + i) % count];
+
+            std::lock_guard lock(queue.lock);
+
+            if (queue.jobs.empty())
+            {
+                continue;
+            }
+
+            if (i == 0)
+            {
+                job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+            }
+            else
+            {
+                job = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+            }
+
+            mQueued.fetch_sub(1, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    bool takeJobOf(const TaskGroup& group, Job& job)
+    {
+        for (auto& queue : mQueues)
+        {
+            std::lock_guard lock(queue.lock);
+
+            auto it = std::find_if(
+                queue.jobs.rbegin(),
+                queue.jobs.rend(),
+                [&group](const Job& job)
+                {
+                    return job.group == &group;
+                });
+
+            if (it == queue.jobs.rend())
+            {
+                continue;
+            }
+
+            job = std::move(*it);
+            queue.jobs.erase(std::next(it).base());
+
+            mQueued.fetch_sub(1, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    template <typename T>
+    static void updateMax(std::atomic<T>& max, T value)
+    {
+        auto current = max.load(std::memory_order_relaxed);
+        while (current < value and not max.compare_exchange_weak(current, value, std::memory_order_relaxed));
+    }
+
+    std::vector<WorkerQueue> mQueues;
+    std::mutex               mSleepLock;
+    std::condition_variable  mWakeUp;
+    std::atomic_size_t       mQueued;
+    std::atomic_size_t       mIdle;
+    std::atomic_size_t       mNext;
+    std::atomic_size_t       mTasks;
+    std::atomic_size_t       mMaxQueued;
+    std::atomic<uint64_t>    mTotalLatency;
+    std::atomic<uint64_t>    mMaxLatency;
+};
+
+static ThreadPool& threadPool()
+{
+    // Never destroyed, as workers may still be running tasks when the
+    // program exits, just like detached threads did
+    static auto pool = new ThreadPool(std::max(hardwareThreadCount(), 1u));
+    return *pool;
+}
+
 void async(Task task)
 {
-    std::thread(std::move(task)).detach();
+    auto& pool = threadPool();
+
+    // Operation started while workers are busy with others, e.g. grep while
+    // a big file is loading, gets its own thread instead of waiting for them;
+    // whatever it runs in parallel still goes through the pool
+    if (not pool.hasIdleWorker())
+    {
+        spawn(std::move(task));
+        return;
+    }
+
+    pool.submit(Job{.task = std::move(task), .group = nullptr, .submitTime = Clock::now()});
+}
+
+void spawn(Task task)
+{
+    Thread(std::move(task)).detach();
 }
 
 void executeInParallelAndWait(Tasks tasks)
 {
-    Threads threads;
-    threads.reserve(tasks.size());
-    for (auto& task : tasks)
+    if (tasks.empty())
     {
-        threads.emplace_back(std::move(task));
+        return;
     }
-    for (auto& thread : threads)
+
+    auto& pool = threadPool();
+
+    TaskGroup group(tasks.size());
+
+    const auto now = Clock::now();
+
+    for (size_t i = 1; i < tasks.size(); ++i)
     {
-        thread.join();
+        pool.submit(Job{.task = std::move(tasks[i]), .group = &group, .submitTime = now});
     }
+
+    // The first task is run here right away, instead of waiting in a queue
+    tasks[0]();
+    ThreadPool::finish(group);
+
+    pool.wait(group);
 }
 
 bool isMainThread()
@@ -40,4 +330,9 @@ unsigned hardwareThreadCount()
     return std::thread::hardware_concurrency();
 }
 
+ThreadPoolStats threadPoolStats()
+{
+    return threadPool().stats();
+}
+
 }  // namespace core
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <functional>
 #include <vector>
 
@@ -9,9 +10,30 @@ namespace core
 using Task = std::function<void()>;
 using Tasks = std::vector<Task>;
 
+struct ThreadPoolStats final
+{
+    unsigned workers;
+    size_t   tasks;
+    size_t   queued;
+    size_t   maxQueued;
+    float    averageLatency;  // seconds between submitting a task and starting it
+    float    maxLatency;
+};
+
+// Runs task on a pool worker, or on a new thread if all workers are busy
 void async(Task task);
+
+// Runs task on its own thread; meant for tasks which run for an unbounded
+// time, e.g. following a file, so that they don't occupy pool workers
+void spawn(Task task);
+
+// Runs tasks on pool workers. The calling thread runs the tasks which haven't
+// been picked up yet itself, so it can be called from within a task without
+// waiting for a free worker
 void executeInParallelAndWait(Tasks tasks);
+
 bool isMainThread();
 unsigned hardwareThreadCount();
+ThreadPoolStats threadPoolStats();
 
 }  // namespace core
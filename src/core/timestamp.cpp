@@ -0,0 +1,507 @@
+#include "timestamp.hpp"
+
+#include <cstring>
+
+namespace core
+{
+
+// Lines can start with a few characters like brackets before the timestamp,
+// but it's not looked for further in the line
+constexpr static size_t MAX_PREFIX = 4;
+
+constexpr static int64_t MICROSECONDS_PER_SECOND = 1'000'000;
+constexpr static int64_t SECONDS_PER_DAY = 86'400;
+
+namespace
+{
+
+struct Cursor
+{
+    constexpr bool atEnd() const
+    {
+        return pos == text.size();
+    }
+
+    constexpr char peek() const
+    {
+        return atEnd() ? '\0' : text[pos];
+    }
+
+    constexpr bool skip(char c)
+    {
+        if (peek() == c)
+        {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    constexpr bool skipAnyOf(const char* chars)
+    {
+        if (not atEnd() and std::strchr(chars, text[pos]))
+        {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    // Reads exactly count digits
+    constexpr bool number(size_t count, int& value)
+    {
+        if (text.size() - pos < count)
+        {
+            return false;
+        }
+
+        value = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto c = text[pos + i];
+
+            if (c < '0' or c > '9')
+            {
+                return false;
+            }
+
+            value = value * 10 + (c - '0');
+        }
+
+        pos += count;
+
+        return true;
+    }
+
+    std::string_view text;
+    size_t           pos = 0;
+};
+
+}  // namespace
+
+// Days since the epoch of a date in proleptic Gregorian calendar; see
+// http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+constexpr static int64_t daysFromCivil(int64_t year, int month, int day)
+{
+    year -= month <= 2;
+    const auto era = (year >= 0 ? year : year - 399) / 400;
+    const auto yearOfEra = year - era * 400;
+    const auto dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const auto dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+static int parseMonthName(Cursor& cursor)
+{
+    constexpr static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+    if (cursor.text.size() - cursor.pos < 3)
+    {
+        return 0;
+    }
+
+    const auto name = cursor.text.substr(cursor.pos, 3);
+
+    for (int i = 0; i < 12; ++i)
+    {
+        if (name == std::string_view(months + i * 3, 3))
+        {
+            cursor.pos += 3;
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+// Parses hh:mm:ss with optional fraction; returns microseconds since midnight.
+// In time entered by user seconds can be omitted
+static utils::Maybe<int64_t> parseTime(Cursor& cursor, bool optionalSeconds = false)
+{
+    int hour, minute, second = 0;
+
+    if (not cursor.number(2, hour) or not cursor.skip(':')
+        or not cursor.number(2, minute))
+    {
+        return {};
+    }
+
+    if (not cursor.skip(':'))
+    {
+        if (not optionalSeconds)
+        {
+            return {};
+        }
+    }
+    else if (not cursor.number(2, second))
+    {
+        return {};
+    }
+
+    // Leap second is allowed
+    if (hour > 23 or minute > 59 or second > 60)
+    {
+        return {};
+    }
+
+    int64_t time = ((hour * 60 + minute) * 60 + second) * MICROSECONDS_PER_SECOND;
+
+    if (cursor.skipAnyOf(".,"))
+    {
+        int64_t fraction = 0;
+        int64_t scale = MICROSECONDS_PER_SECOND;
+
+        // Digits beyond microseconds are ignored
+        for (int digit; cursor.number(1, digit);)
+        {
+            if (scale > 1)
+            {
+                scale /= 10;
+                fraction += digit * scale;
+            }
+        }
+
+        time += fraction;
+    }
+
+    return time;
+}
+
+// Parses Z or offset like +02:00, +0200 or +02; returns offset in microseconds
+static int64_t parseZone(Cursor& cursor)
+{
+    if (cursor.skip('Z'))
+    {
+        return 0;
+    }
+
+    const auto sign = cursor.peek();
+
+    if (sign != '+' and sign != '-')
+    {
+        return 0;
+    }
+
+    auto copy = cursor;
+    ++copy.pos;
+
+    int hours, minutes = 0;
+
+    if (not copy.number(2, hours))
+    {
+        return 0;
+    }
+
+    copy.skip(':');
+
+    if (not copy.number(2, minutes))
+    {
+        minutes = 0;
+    }
+
+    if (hours > 23 or minutes > 59)
+    {
+        return 0;
+    }
+
+    cursor = copy;
+
+    const int64_t offset = (hours * 60 + minutes) * 60 * MICROSECONDS_PER_SECOND;
+
+    return sign == '+' ? offset : -offset;
+}
+
+struct Date
+{
+    int year;
+    int month;
+    int day;
+};
+
+static utils::Maybe<Date> parseIsoDate(Cursor& cursor)
+{
+    Date date;
+
+    if (not cursor.number(4, date.year))
+    {
+        return {};
+    }
+
+    const auto separator = cursor.peek();
+
+    if ((separator != '-' and separator != '/') or not cursor.skip(separator)
+        or not cursor.number(2, date.month) or not cursor.skip(separator)
+        or not cursor.number(2, date.day))
+    {
+        return {};
+    }
+
+    if (date.month < 1 or date.month > 12 or date.day < 1 or date.day > 31)
+    {
+        return {};
+    }
+
+    return date;
+}
+
+static utils::Maybe<Timestamp> parseIso(Cursor& cursor)
+{
+    const auto date = parseIsoDate(cursor);
+
+    if (not date or not cursor.skipAnyOf("T "))
+    {
+        return {};
+    }
+
+    const auto time = parseTime(cursor);
+
+    if (not time)
+    {
+        return {};
+    }
+
+    const auto offset = parseZone(cursor);
+
+    return daysFromCivil(date->year, date->month, date->day) * SECONDS_PER_DAY * MICROSECONDS_PER_SECOND + *time - offset;
+}
+
+static utils::Maybe<Timestamp> parseSyslog(Cursor& cursor, bool optionalSeconds = false)
+{
+    const auto month = parseMonthName(cursor);
+
+    if (not month or not cursor.skip(' '))
+    {
+        return {};
+    }
+
+    int day;
+
+    // Day is padded with space
+    if (cursor.skip(' '))
+    {
+        if (not cursor.number(1, day))
+        {
+            return {};
+        }
+    }
+    else if (not cursor.number(2, day))
+    {
+        return {};
+    }
+
+    if (day < 1 or day > 31 or not cursor.skip(' '))
+    {
+        return {};
+    }
+
+    const auto time = parseTime(cursor, optionalSeconds);
+
+    if (not time)
+    {
+        return {};
+    }
+
+    return daysFromCivil(1970, month, day) * SECONDS_PER_DAY * MICROSECONDS_PER_SECOND + *time;
+}
+
+// Parses seconds since the epoch, which are 10 digits until 2286
+static utils::Maybe<Timestamp> parseEpoch(Cursor& cursor)
+{
+    int high, low;
+
+    if (not cursor.number(5, high) or not cursor.number(5, low))
+    {
+        return {};
+    }
+
+    const auto next = cursor.peek();
+
+    if (next >= '0' and next <= '9')
+    {
+        return {};
+    }
+
+    Timestamp timestamp = (Timestamp(high) * 100'000 + low) * MICROSECONDS_PER_SECOND;
+
+    if (cursor.skip('.'))
+    {
+        Timestamp scale = MICROSECONDS_PER_SECOND;
+
+        for (int digit; cursor.number(1, digit);)
+        {
+            if (scale > 1)
+            {
+                scale /= 10;
+                timestamp += digit * scale;
+            }
+        }
+    }
+
+    return timestamp;
+}
+
+static Cursor skipPrefix(std::string_view line)
+{
+    Cursor cursor{.text = line};
+
+    while (cursor.pos < MAX_PREFIX and cursor.skipAnyOf(" \t[("));
+
+    return cursor;
+}
+
+utils::Maybe<TimestampFormat> parseTimestampFormat(std::string_view name)
+{
+    for (const auto format : {TimestampFormat::none, TimestampFormat::automatic, TimestampFormat::iso, TimestampFormat::syslog, TimestampFormat::epoch})
+    {
+        if (name == timestampFormatName(format))
+        {
+            return format;
+        }
+    }
+
+    return {};
+}
+
+const char* timestampFormatName(TimestampFormat format)
+{
+    switch (format)
+    {
+        case TimestampFormat::none:      return "none";
+        case TimestampFormat::automatic: return "auto";
+        case TimestampFormat::iso:       return "iso";
+        case TimestampFormat::syslog:    return "syslog";
+        case TimestampFormat::epoch:     return "epoch";
+    }
+    return "unknown";
+}
+
+utils::Maybe<Timestamp> parseTimestamp(std::string_view line)
+{
+    auto cursor = skipPrefix(line);
+
+    const auto first = cursor.peek();
+
+    if (first >= '0' and first <= '9')
+    {
+        return parseIso(cursor);
+    }
+    else if (first >= 'A' and first <= 'S')
+    {
+        return parseSyslog(cursor);
+    }
+
+    return {};
+}
+
+utils::Maybe<Timestamp> parseTimestamp(std::string_view line, TimestampFormat format)
+{
+    auto cursor = skipPrefix(line);
+
+    switch (format)
+    {
+        case TimestampFormat::iso:
+            return parseIso(cursor);
+        case TimestampFormat::syslog:
+            return parseSyslog(cursor);
+        case TimestampFormat::epoch:
+            return parseEpoch(cursor);
+        case TimestampFormat::automatic:
+            return parseTimestamp(line);
+        case TimestampFormat::none:
+            break;
+    }
+
+    return {};
+}
+
+TimestampFormat detectTimestampFormat(std::string_view text)
+{
+    constexpr static size_t MAX_LINES = 64;
+
+    size_t isoCount = 0;
+    size_t syslogCount = 0;
+
+    for (size_t i = 0; i < MAX_LINES and not text.empty(); ++i)
+    {
+        const auto newline = text.find('\n');
+        const auto line = text.substr(0, newline);
+
+        isoCount += bool(parseTimestamp(line, TimestampFormat::iso));
+        syslogCount += bool(parseTimestamp(line, TimestampFormat::syslog));
+
+        if (newline == text.npos)
+        {
+            break;
+        }
+
+        text.remove_prefix(newline + 1);
+    }
+
+    if (isoCount == 0 and syslogCount == 0)
+    {
+        return TimestampFormat::none;
+    }
+
+    return isoCount >= syslogCount ? TimestampFormat::iso : TimestampFormat::syslog;
+}
+
+utils::Maybe<Timestamp> parseTimeQuery(std::string_view text, Timestamp reference)
+{
+    constexpr Timestamp DAY = SECONDS_PER_DAY * MICROSECONDS_PER_SECOND;
+
+    // Syslog timestamps fall in 1970
+    const bool yearless = reference >= 0 and reference < daysFromCivil(1971, 1, 1) * DAY;
+
+    auto cursor = skipPrefix(text);
+
+    const auto first = cursor.peek();
+
+    utils::Maybe<Timestamp> result;
+
+    if (first >= 'A' and first <= 'S')
+    {
+        result = parseSyslog(cursor, true);
+    }
+    else if (text.size() - cursor.pos > 2 and text[cursor.pos + 2] == ':')
+    {
+        const auto time = parseTime(cursor, true);
+
+        if (time)
+        {
+            const auto day = reference >= 0 ? reference / DAY : (reference - DAY + 1) / DAY;
+            result = day * DAY + *time;
+        }
+    }
+    else if (const auto date = parseIsoDate(cursor))
+    {
+        const auto year = yearless ? 1970 : date->year;
+        auto timestamp = daysFromCivil(year, date->month, date->day) * DAY;
+
+        if (cursor.skipAnyOf("T "))
+        {
+            const auto time = parseTime(cursor, true);
+
+            if (not time)
+            {
+                return {};
+            }
+
+            timestamp += *time - parseZone(cursor);
+        }
+
+        result = timestamp;
+    }
+
+    // Anything following the time is an error
+    while (cursor.skip(' '));
+
+    if (not cursor.atEnd())
+    {
+        return {};
+    }
+
+    return result;
+}
+
+}  // namespace core
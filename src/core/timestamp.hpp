@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+#include "utils/maybe.hpp"
+
+namespace core
+{
+
+// Microseconds since the epoch. Time without zone is taken as UTC, and time
+// without year (like in syslog) as being in 1970, so such timestamps can be
+// compared only with each other
+using Timestamp = int64_t;
+
+// Value of lines preceding the first timestamp; sorts before any other
+constexpr Timestamp NO_TIMESTAMP = std::numeric_limits<Timestamp>::min();
+
+// Parser doesn't look further than that into the line
+constexpr size_t MAX_TIMESTAMP_LENGTH = 64;
+
+enum class TimestampFormat : char
+{
+    none,
+    automatic,
+    iso,
+    syslog,
+    epoch,
+};
+
+// Accepts names used in config: none, auto, iso, syslog, epoch
+utils::Maybe<TimestampFormat> parseTimestampFormat(std::string_view name);
+
+const char* timestampFormatName(TimestampFormat format);
+
+// Parses timestamp at the beginning of a log line; leading whitespace and
+// opening brackets are skipped. Recognized formats are:
+//  - ISO 8601-like: 2024-01-15T10:23:45, date may be separated with '/', and
+//    time with space; followed by optional fraction after '.' or ',', and
+//    optional zone, either 'Z' or offset like +02:00
+//  - syslog: Jan 15 10:23:45, with optional fraction
+utils::Maybe<Timestamp> parseTimestamp(std::string_view line);
+
+// Parses timestamp in a single format, which is cheaper than trying all of
+// them; epoch is seconds since the epoch with 10 digits and optional fraction,
+// and is never guessed by the automatic one
+utils::Maybe<Timestamp> parseTimestamp(std::string_view line, TimestampFormat format);
+
+// Picks format matching most of the first lines of text; none if none matches
+TimestampFormat detectTimestampFormat(std::string_view text);
+
+// Parses time entered by user: full timestamp in ISO or syslog format, in
+// which seconds can be omitted, date alone, or time alone, which is then
+// taken on the day of reference. If reference has no year, the year given
+// is ignored
+utils::Maybe<Timestamp> parseTimeQuery(std::string_view text, Timestamp reference);
+
+}  // namespace core
@@ -0,0 +1,305 @@
+#include "timestamp_index.hpp"
+
+#include <limits>
+#include <utility>
+
+#include "utils/math.hpp"
+
+namespace core
+{
+
+TimestampIndex::TimestampIndex() = default;
+
+TimestampIndex::~TimestampIndex() = default;
+
+TimestampIndex::TimestampIndex(TimestampIndex&& other)
+    : mSegments(std::move(other.mSegments))
+    , mMap(std::move(other.mMap))
+    , mLast(other.mLast)
+    , mLeading(std::exchange(other.mLeading, 0))
+{
+    other.mSegments.clear();
+}
+
+TimestampIndex& TimestampIndex::operator=(TimestampIndex&& other)
+{
+    mSegments = std::move(other.mSegments);
+    mMap = std::move(other.mMap);
+    mLast = other.mLast;
+    mLeading = std::exchange(other.mLeading, 0);
+    other.mSegments.clear();
+    other.mMap.clear();
+    return *this;
+}
+
+void TimestampIndex::append(Timestamp timestamp)
+{
+    if (mSegments.empty()) [[unlikely]]
+    {
+        mSegments.emplace_back();
+        mMap.addSegment();
+    }
+
+    if (timestamp == NO_TIMESTAMP)
+    {
+        timestamp = mLast;
+    }
+
+    if (timestamp == NO_TIMESTAMP)
+    {
+        ++mLeading;
+    }
+
+    mSegments.back().append(timestamp);
+    mMap.grow(1);
+    mLast = timestamp;
+}
+
+void TimestampIndex::append(TimestampIndex&& other)
+{
+    const auto count = other.size();
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Index which is empty, but continues a moved out one, has to resolve
+    // leading lines of other
+    if (size() == 0 and mLast == NO_TIMESTAMP)
+    {
+        *this = std::move(other);
+        return;
+    }
+
+    if (other.mLeading and mLast != NO_TIMESTAMP)
+    {
+        auto leading = other.mLeading;
+
+        for (auto& segment : other.mSegments)
+        {
+            const auto segmentLeading = utils::min(leading, segment.deltas.size());
+
+            segment.resolve(segmentLeading, mLast);
+            leading -= segmentLeading;
+
+            if (leading == 0)
+            {
+                break;
+            }
+        }
+
+        if (other.mLast == NO_TIMESTAMP)
+        {
+            other.mLast = mLast;
+        }
+
+        other.mLeading = 0;
+    }
+
+    if (count < MIN_SEGMENT_LINES)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            append(other[i]);
+        }
+    }
+    else
+    {
+        for (auto& segment : other.mSegments)
+        {
+            mMap.addSegment();
+            mMap.grow(segment.deltas.size());
+            mSegments.emplace_back(std::move(segment));
+        }
+
+        if (mLast == NO_TIMESTAMP)
+        {
+            mLeading += other.mLeading;
+        }
+
+        mLast = other.mLast;
+    }
+
+    other.clear();
+}
+
+void TimestampIndex::popBack()
+{
+    auto& segment = mSegments.back();
+
+    segment.popBack();
+    mMap.shrink(1);
+
+    if (segment.deltas.empty())
+    {
+        mSegments.pop_back();
+        mMap.removeSegment();
+    }
+
+    mLeading = utils::min(mLeading, size());
+    mLast = size() ? (*this)[size() - 1] : NO_TIMESTAMP;
+}
+
+void TimestampIndex::clear()
+{
+    mSegments.clear();
+    mMap.clear();
+    mLast = NO_TIMESTAMP;
+    mLeading = 0;
+}
+
+void TimestampIndex::shrinkToFit()
+{
+    for (auto& segment : mSegments)
+    {
+        segment.blocks.shrinkToFit();
+        segment.deltas.shrinkToFit();
+        segment.wide.shrinkToFit();
+    }
+
+    mMap.shrinkToFit();
+}
+
+size_t TimestampIndex::memoryUsage() const
+{
+    size_t total = mMap.memoryUsage();
+
+    for (const auto& segment : mSegments)
+    {
+        total += segment.blocks.capacity() * sizeof(Block)
+            + segment.deltas.capacity() * sizeof(int32_t)
+            + segment.wide.capacity() * sizeof(int64_t);
+    }
+
+    return total;
+}
+
+size_t TimestampIndex::lowerBound(Timestamp timestamp) const
+{
+    size_t first = 0;
+    size_t last = size();
+
+    while (first < last)
+    {
+        const auto middle = first + (last - first) / 2;
+
+        if ((*this)[middle] < timestamp)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+
+    return first;
+}
+
+// Delta from anchor, if it fits; lines without timestamp can be narrow only
+// in a block which has none
+static bool narrowDelta(int64_t anchor, Timestamp timestamp, int32_t& delta)
+{
+    if (anchor == NO_TIMESTAMP or timestamp == NO_TIMESTAMP)
+    {
+        delta = 0;
+        return anchor == timestamp;
+    }
+
+    // Timestamps are far from the limits of int64_t, so it doesn't overflow
+    const auto difference = timestamp - anchor;
+
+    if (difference < std::numeric_limits<int32_t>::min() or difference > std::numeric_limits<int32_t>::max())
+    {
+        return false;
+    }
+
+    delta = static_cast<int32_t>(difference);
+
+    return true;
+}
+
+void TimestampIndex::Segment::append(Timestamp timestamp)
+{
+    const auto i = deltas.size();
+
+    if ((i & (BLOCK_LINES - 1)) == 0)
+    {
+        blocks.pushBack(Block{.anchor = timestamp, .wideIndex = NARROW});
+        deltas.pushBack(0);
+        return;
+    }
+
+    auto& block = blocks.back();
+
+    if (block.wideIndex == NARROW) [[likely]]
+    {
+        int32_t delta;
+
+        if (narrowDelta(block.anchor, timestamp, delta)) [[likely]]
+        {
+            deltas.pushBack(delta);
+            return;
+        }
+
+        widenLastBlock();
+    }
+
+    wide.pushBack(timestamp);
+    deltas.pushBack(0);
+}
+
+void TimestampIndex::Segment::widenLastBlock()
+{
+    auto& block = blocks.back();
+    const auto blockStart = (deltas.size() - 1) & ~(BLOCK_LINES - 1);
+
+    block.wideIndex = static_cast<uint32_t>(wide.size());
+
+    for (size_t i = blockStart; i < deltas.size(); ++i)
+    {
+        wide.pushBack(block.anchor + deltas[i]);
+    }
+}
+
+void TimestampIndex::Segment::popBack()
+{
+    const auto i = deltas.size() - 1;
+
+    if (blocks[blocks.size() - 1].wideIndex != NARROW)
+    {
+        wide.popBack();
+    }
+
+    if ((i & (BLOCK_LINES - 1)) == 0)
+    {
+        blocks.popBack();
+    }
+
+    deltas.popBack();
+}
+
+void TimestampIndex::Segment::resolve(size_t count, Timestamp timestamp)
+{
+    for (size_t blockStart = 0; blockStart < count; blockStart += BLOCK_LINES)
+    {
+        auto& block = blocks[blockStart >> BLOCK_SHIFT];
+
+        // Narrow block with lines without timestamp has only such lines
+        if (block.wideIndex == NARROW)
+        {
+            block.anchor = timestamp;
+            continue;
+        }
+
+        const auto end = utils::min(count - blockStart, BLOCK_LINES);
+
+        for (size_t i = 0; i < end; ++i)
+        {
+            wide[block.wideIndex + i] = timestamp;
+        }
+    }
+}
+
+}  // namespace core
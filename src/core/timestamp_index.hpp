@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "core/timestamp.hpp"
+#include "utils/noncopyable.hpp"
+#include "utils/pod_array.hpp"
+#include "utils/segment_map.hpp"
+
+namespace core
+{
+
+// Column of per-line timestamps kept alongside LineIndex. Timestamps are
+// grouped in blocks of BLOCK_LINES like line starts; each block keeps the
+// timestamp of its first line and every timestamp is stored as a 32-bit
+// delta from it, which covers about 35 minutes either way. Block in which
+// some delta does not fit falls back to absolute 64-bit values.
+//
+// Line without timestamp takes the one of the preceding line. Lines before
+// the first timestamp are NO_TIMESTAMP; when an index is appended to another
+// its leading such lines take the last timestamp of the other, so that
+// indexes of consecutive parts of file built by separate threads are joined
+// like they were built by one
+struct TimestampIndex final : utils::NonCopyable
+{
+    constexpr static size_t BLOCK_SHIFT = 6;
+    constexpr static size_t BLOCK_LINES = 1 << BLOCK_SHIFT;
+    constexpr static uint32_t NARROW = UINT32_MAX;
+    constexpr static size_t MIN_SEGMENT_LINES = utils::SegmentMap::PAGE_SIZE;
+
+    TimestampIndex();
+    ~TimestampIndex();
+
+    // Index moved from keeps its last timestamp, so that a chunk built in it
+    // afterwards continues the one moved out, like LineIndex does
+    TimestampIndex(TimestampIndex&& other);
+    TimestampIndex& operator=(TimestampIndex&& other);
+
+    // Appends timestamp of the next line; NO_TIMESTAMP if it has none
+    void append(Timestamp timestamp);
+
+    // Appends all timestamps from other, taking over its segments unless
+    // it's shorter than MIN_SEGMENT_LINES
+    void append(TimestampIndex&& other);
+
+    void popBack();
+    void clear();
+    void shrinkToFit();
+
+    size_t memoryUsage() const;
+
+    // Index of the first line which timestamp is not earlier than the given
+    // one; lines are assumed to be ordered by time
+    size_t lowerBound(Timestamp timestamp) const;
+
+    constexpr size_t segmentCount() const
+    {
+        return mSegments.size();
+    }
+
+    constexpr size_t size() const
+    {
+        return mMap.size();
+    }
+
+    constexpr bool empty() const
+    {
+        return size() == 0;
+    }
+
+    constexpr Timestamp operator[](size_t i) const
+    {
+        const auto location = mMap.locate(i);
+        return mSegments[location.segment].at(location.offset);
+    }
+
+private:
+    struct Block
+    {
+        int64_t  anchor;
+        uint32_t wideIndex;
+    };
+
+    struct Segment
+    {
+        void append(Timestamp timestamp);
+        void widenLastBlock();
+        void popBack();
+
+        // Sets timestamp of the first count lines, which have none
+        void resolve(size_t count, Timestamp timestamp);
+
+        constexpr Timestamp at(size_t i) const
+        {
+            const auto& block = blocks[i >> BLOCK_SHIFT];
+
+            if (block.wideIndex == NARROW) [[likely]]
+            {
+                return block.anchor + deltas[i];
+            }
+
+            return wide[block.wideIndex + (i & (BLOCK_LINES - 1))];
+        }
+
+        utils::PodArray<Block>    blocks;
+        utils::PodArray<int32_t>  deltas;
+        utils::PodArray<int64_t>  wide;
+    };
+
+    std::vector<Segment> mSegments;
+    utils::SegmentMap    mMap;
+    Timestamp            mLast = NO_TIMESTAMP;
+    size_t               mLeading = 0;
+};
+
+using Timestamps = TimestampIndex;
+
+}  // namespace core
@@ -15,6 +15,7 @@ Window::Window()
     , width(0)
     , height(0)
     , lineNrDigits(0)
+    , sourceWidth(0)
     , yoffset(0)
     , xoffset(0)
     , ycurrent(0)
@@ -38,6 +39,7 @@ Window::Window(BufferId id, Context& c)
     , width(0)
     , height(0)
     , lineNrDigits(0)
+    , sourceWidth(0)
     , yoffset(0)
     , xoffset(0)
     , ycurrent(0)
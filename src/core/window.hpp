@@ -3,6 +3,7 @@
 #include <array>
 #include <cstdint>
 #include <span>
+#include <string_view>
 #include <vector>
 
 #include "core/bookmarks.hpp"
@@ -47,10 +48,12 @@ using ColoredStrings = std::vector<ColoredString>;
 
 struct BufferLine
 {
-    size_t         lineNumber;
-    size_t         absoluteLineNumber;
-    Glyphs         glyphs;
-    ColoredStrings segments;
+    size_t           lineNumber;
+    size_t           absoluteLineNumber;
+    size_t           source;
+    std::string_view sourceName;
+    Glyphs           glyphs;
+    ColoredStrings   segments;
 };
 
 using RingBuffer = utils::RingBuffer<BufferLine>;
@@ -74,6 +77,7 @@ struct Window final : utils::NonCopyable
     size_t       width;
     size_t       height;
     size_t       lineNrDigits;
+    size_t       sourceWidth;
     size_t       yoffset;
     size_t       xoffset;
     size_t       ycurrent;
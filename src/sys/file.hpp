@@ -1,20 +1,51 @@
 #pragma once
 
+#include <cstdint>
 #include <expected>
 #include <string>
+#include <vector>
 
 #include "sys/common.hpp"
 
 namespace sys
 {
 
+struct FileIdentity final
+{
+    uint64_t device;
+    uint64_t inode;
+    int64_t  mtime;  // nanoseconds
+
+    bool operator==(const FileIdentity&) const = default;
+};
+
 struct File final
 {
     std::string    path;
     size_t         size;
     FileDescriptor fd;
+    FileIdentity   identity;
+};
+
+// Regular file found in a directory
+struct DirectoryEntry final
+{
+    std::string path;
+    size_t      size;
+    int64_t     mtime;  // nanoseconds
+};
+
+// Handle for notifications about changes of a file
+struct FileWatch final
+{
+    FileDescriptor fd;
+    int            wd;
 };
 
 using MaybeFile = std::expected<File, Error>;
+using MaybeSize = std::expected<size_t, Error>;
+using MaybeFileIdentity = std::expected<FileIdentity, Error>;
+using MaybeFileWatch = std::expected<FileWatch, Error>;
+using MaybeDirectoryEntries = std::expected<std::vector<DirectoryEntry>, Error>;
 
 }  // namespace sys
@@ -5,6 +5,14 @@
 namespace sys
 {
 
+// Expected way of reading mapped data, passed to the kernel to tune readahead
+enum class AccessPattern : char
+{
+    normal,
+    sequential,
+    random,
+};
+
 struct Mapping
 {
     void*  ptr;
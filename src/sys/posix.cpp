@@ -9,9 +9,16 @@
 #include <cstring>
 #include <ctime>
 #include <cxxabi.h>
+#include <dirent.h>
 #include <dlfcn.h>
 #include <expected>
 #include <fcntl.h>
+#include <iterator>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+#endif
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -21,6 +28,7 @@
 #include "sys/mapping.hpp"
 #include "utils/buffer.hpp"
 #include "utils/string.hpp"
+#include "utils/units.hpp"
 
 #define COLOR_BLUE    "\e[34m"
 #define COLOR_YELLOW  "\e[33m"
@@ -31,6 +39,8 @@
 namespace sys
 {
 
+constexpr static size_t POPULATE_MAX_SIZE = 4_MiB;
+
 static backtrace_state* backtraceState;
 
 struct ProcessMapping
@@ -238,6 +248,15 @@ void crashHandle(const int signal)
     sys::finalize();
 }
 
+static FileIdentity identityOf(const struct stat& stat)
+{
+    return FileIdentity{
+        .device = static_cast<uint64_t>(stat.st_dev),
+        .inode = static_cast<uint64_t>(stat.st_ino),
+        .mtime = static_cast<int64_t>(stat.st_mtim.tv_sec) * 1'000'000'000 + stat.st_mtim.tv_nsec,
+    };
+}
+
 MaybeFile fileOpen(std::string path)
 {
     int fd = open(path.c_str(), O_RDONLY);
@@ -258,6 +277,7 @@ MaybeFile fileOpen(std::string path)
         .path = std::move(path),
         .size = static_cast<size_t>(stat.st_size),
         .fd = fd,
+        .identity = identityOf(stat),
     };
 }
 
@@ -270,19 +290,441 @@ Error fileClose(File& file)
     return 0;
 }
 
-Error remap(const File& file, Mapping& mapping, size_t newOffset, size_t newLen)
+Error fileRefresh(File& file)
+{
+    struct stat stat;
+
+    if (fstat(file.fd, &stat) == -1) [[unlikely]]
+    {
+        return errno;
+    }
+
+    file.size = static_cast<size_t>(stat.st_size);
+    file.identity = identityOf(stat);
+
+    return 0;
+}
+
+MaybeSize fileRead(const File& file, char* buffer, size_t offset, size_t len)
+{
+    size_t total = 0;
+
+    // Network filesystems can return less than requested, so read until
+    // everything is there or end of file is reached
+    while (total < len)
+    {
+        const auto result = pread(file.fd, buffer + total, len - total, static_cast<off_t>(offset + total));
+
+        if (result == -1) [[unlikely]]
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return std::unexpected(errno);
+        }
+
+        if (result == 0)
+        {
+            break;
+        }
+
+        total += static_cast<size_t>(result);
+    }
+
+    return total;
+}
+
+bool fileIsRemote(const File& file)
+{
+#ifdef __linux__
+    // Magic numbers of network and userspace filesystems, see statfs(2)
+    constexpr static uint32_t remoteTypes[] = {
+        0x6969,      // NFS
+        0x517b,      // SMB
+        0xfe534d42,  // SMB2
+        0xff534d42,  // CIFS
+        0x65735546,  // FUSE
+        0x01021997,  // 9P
+        0x00c36400,  // Ceph
+        0x5346414f,  // AFS
+        0x73757245,  // Coda
+    };
+
+    struct statfs stat;
+
+    if (fstatfs(file.fd, &stat) == -1) [[unlikely]]
+    {
+        return false;
+    }
+
+    const auto type = static_cast<uint32_t>(stat.f_type);
+
+    return std::find(std::begin(remoteTypes), std::end(remoteTypes), type) != std::end(remoteTypes);
+#else
+    (void)file;
+    return false;
+#endif
+}
+
+#ifdef __linux__
+
+// Files created here are reachable only through their descriptors, so the
+// path under which they can be opened again refers to the descriptor
+static MaybeFile fileFromDescriptor(FileDescriptor fd)
+{
+    struct stat stat;
+
+    if (fstat(fd, &stat) == -1) [[unlikely]]
+    {
+        const auto error = errno;
+        close(fd);
+        return std::unexpected(error);
+    }
+
+    utils::Buffer buf;
+    buf << "/proc/self/fd/" << fd;
+
+    return File{
+        .path = buf.str(),
+        .size = static_cast<size_t>(stat.st_size),
+        .fd = fd,
+        .identity = identityOf(stat),
+    };
+}
+
+MaybeFile fileCreateTemporary()
+{
+    const auto tmpDir = std::getenv("TMPDIR");
+
+    utils::Buffer buf;
+    buf << (tmpDir and *tmpDir ? tmpDir : "/tmp") << "/log-viewer-XXXXXX";
+
+    auto path = buf.str();
+
+    const int fd = mkostemp(path.data(), O_CLOEXEC);
+
+    if (fd == -1) [[unlikely]]
+    {
+        return std::unexpected(errno);
+    }
+
+    // File is removed as soon as the last descriptor is closed
+    unlink(path.c_str());
+
+    return fileFromDescriptor(fd);
+}
+
+#else
+
+MaybeFile fileCreateTemporary()
+{
+    return std::unexpected(ENOSYS);
+}
+
+#endif  // __linux__
+
+Error fileAppend(File& file, const char* data, size_t len)
+{
+    while (len)
+    {
+        const auto written = write(file.fd, data, len);
+
+        if (written == -1) [[unlikely]]
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return errno;
+        }
+
+        data += written;
+        len -= static_cast<size_t>(written);
+        file.size += static_cast<size_t>(written);
+    }
+
+    return 0;
+}
+
+std::expected<FileDescriptor, Error> stdinDetach()
+{
+    if (isatty(STDIN_FILENO))
+    {
+        return -1;
+    }
+
+    const int fd = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, STDERR_FILENO + 1);
+
+    if (fd == -1) [[unlikely]]
+    {
+        return std::unexpected(errno);
+    }
+
+    // UI reads keys from standard input, so it's given the terminal instead
+    const int tty = open("/dev/tty", O_RDWR);
+
+    if (tty == -1 or dup2(tty, STDIN_FILENO) == -1) [[unlikely]]
+    {
+        const auto error = errno;
+        if (tty != -1)
+        {
+            close(tty);
+        }
+        close(fd);
+        return std::unexpected(error);
+    }
+
+    close(tty);
+
+    return fd;
+}
+
+std::expected<bool, Error> streamWait(FileDescriptor fd, int timeoutMs)
+{
+    pollfd pfd{.fd = fd, .events = POLLIN, .revents = 0};
+
+    const auto result = poll(&pfd, 1, timeoutMs);
+
+    if (result == -1) [[unlikely]]
+    {
+        if (errno == EINTR)
+        {
+            return false;
+        }
+        return std::unexpected(errno);
+    }
+
+    // End of stream is reported as POLLHUP without POLLIN
+    return result > 0;
+}
+
+MaybeSize streamRead(FileDescriptor fd, char* buffer, size_t len)
+{
+    while (true)
+    {
+        const auto result = read(fd, buffer, len);
+
+        if (result == -1) [[unlikely]]
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return std::unexpected(errno);
+        }
+
+        return static_cast<size_t>(result);
+    }
+}
+
+MaybeFileIdentity fileIdentity(const std::string& path)
+{
+    struct stat s;
+
+    if (stat(path.c_str(), &s) == -1)
+    {
+        return std::unexpected(errno);
+    }
+
+    return identityOf(s);
+}
+
+Error fileTouch(const std::string& path)
+{
+    return utimensat(AT_FDCWD, path.c_str(), nullptr, 0) == -1 ? errno : 0;
+}
+
+Error fileRemove(const std::string& path)
+{
+    return unlink(path.c_str()) == -1 ? errno : 0;
+}
+
+MaybeDirectoryEntries directoryRead(const std::string& path)
+{
+    DIR* dir = opendir(path.c_str());
+
+    if (not dir) [[unlikely]]
+    {
+        return std::unexpected(errno);
+    }
+
+    std::vector<DirectoryEntry> entries;
+
+    while (const auto entry = readdir(dir))
+    {
+        struct stat s;
+        auto entryPath = path + '/' + entry->d_name;
+
+        if (stat(entryPath.c_str(), &s) == -1 or not S_ISREG(s.st_mode))
+        {
+            continue;
+        }
+
+        entries.push_back(DirectoryEntry{
+            .path = std::move(entryPath),
+            .size = static_cast<size_t>(s.st_size),
+            .mtime = identityOf(s).mtime,
+        });
+    }
+
+    closedir(dir);
+
+    return entries;
+}
+
+#ifdef __linux__
+
+MaybeFileWatch fileWatch(const std::string& path)
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (fd == -1) [[unlikely]]
+    {
+        return std::unexpected(errno);
+    }
+
+    int wd = inotify_add_watch(fd, path.c_str(), IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+
+    if (wd == -1) [[unlikely]]
+    {
+        const auto error = errno;
+        close(fd);
+        return std::unexpected(error);
+    }
+
+    return FileWatch{.fd = fd, .wd = wd};
+}
+
+std::expected<bool, Error> fileWatchWait(FileWatch& watch, int timeoutMs)
+{
+    pollfd pfd{.fd = watch.fd, .events = POLLIN, .revents = 0};
+
+    const auto count = poll(&pfd, 1, timeoutMs);
+
+    if (count == -1) [[unlikely]]
+    {
+        return std::unexpected(errno);
+    }
+
+    if (count == 0)
+    {
+        return false;
+    }
+
+    // Content of the events is not needed, caller checks the file itself
+    alignas(inotify_event) char buf[4096];
+
+    while (read(watch.fd, buf, sizeof(buf)) > 0);
+
+    return true;
+}
+
+Error fileUnwatch(FileWatch& watch)
+{
+    if (close(watch.fd) == -1) [[unlikely]]
+    {
+        return errno;
+    }
+    watch.fd = -1;
+    return 0;
+}
+
+#else
+
+// No notifications available; caller ends up polling the file every timeoutMs
+
+MaybeFileWatch fileWatch(const std::string&)
+{
+    return FileWatch{.fd = -1, .wd = -1};
+}
+
+std::expected<bool, Error> fileWatchWait(FileWatch&, int timeoutMs)
+{
+    usleep(timeoutMs * 1000);
+    return true;
+}
+
+Error fileUnwatch(FileWatch&)
+{
+    return 0;
+}
+
+#endif  // __linux__
+
+Error fileWrite(const std::string& path, std::span<const std::string_view> chunks)
+{
+    // Write to a temporary file first, so that readers never see partially
+    // written content; it's unique, so that content of concurrent writers of
+    // the same path is never mixed
+    auto tmpPath = path + ".tmp-XXXXXX";
+
+    int fd = mkostemp(tmpPath.data(), O_CLOEXEC);
+
+    if (fd == -1) [[unlikely]]
+    {
+        return errno;
+    }
+
+    for (auto chunk : chunks)
+    {
+        while (not chunk.empty())
+        {
+            const auto written = write(fd, chunk.data(), chunk.size());
+
+            if (written == -1) [[unlikely]]
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                const auto error = errno;
+                close(fd);
+                unlink(tmpPath.c_str());
+                return error;
+            }
+
+            chunk.remove_prefix(static_cast<size_t>(written));
+        }
+    }
+
+    if (close(fd) == -1 or rename(tmpPath.c_str(), path.c_str()) == -1) [[unlikely]]
+    {
+        const auto error = errno;
+        unlink(tmpPath.c_str());
+        return error;
+    }
+
+    return 0;
+}
+
+static size_t pageMask()
 {
-    static unsigned int pageMask = ~(static_cast<uintptr_t>(getpagesize()) - 1);
+    static const size_t mask = ~(static_cast<size_t>(getpagesize()) - 1);
+    return mask;
+}
 
+Error remap(const File& file, Mapping& mapping, size_t newOffset, size_t newLen, AccessPattern pattern)
+{
     if (mapping)
     {
         munmap(mapping.ptr, mapping.len);
     }
 
-    size_t pageStart = newOffset & pageMask;
+    size_t pageStart = newOffset & pageMask();
     newLen += newOffset - pageStart;
 
-    const auto newPtr = mmap(nullptr, newLen, PROT_READ, MAP_PRIVATE, file.fd, pageStart);
+    int flags = MAP_PRIVATE;
+
+#ifdef MAP_POPULATE
+    // Small file is read whole up front instead of faulting page by page
+    if (file.size <= POPULATE_MAX_SIZE)
+    {
+        flags |= MAP_POPULATE;
+    }
+#endif
+
+    const auto newPtr = mmap(nullptr, newLen, PROT_READ, flags, file.fd, pageStart);
 
     if (newPtr == MAP_FAILED) [[unlikely]]
     {
@@ -295,6 +737,57 @@ Error remap(const File& file, Mapping& mapping, size_t newOffset, size_t newLen)
         .len = newLen
     };
 
+    if (pattern != AccessPattern::normal)
+    {
+        // Only a hint, so failure is not an error
+        advise(mapping, pageStart, newLen, pattern);
+    }
+
+    return 0;
+}
+
+Error advise(const Mapping& mapping, size_t offset, size_t len, AccessPattern pattern)
+{
+    const auto pageStart = offset & pageMask();
+    const auto ptr = static_cast<char*>(mapping.ptr) + (pageStart - mapping.offset);
+
+    len += offset - pageStart;
+
+    int advice = MADV_NORMAL;
+
+    switch (pattern)
+    {
+        case AccessPattern::sequential:
+            advice = MADV_SEQUENTIAL;
+            break;
+        case AccessPattern::random:
+            advice = MADV_RANDOM;
+            break;
+        case AccessPattern::normal:
+            break;
+    }
+
+    if (madvise(ptr, len, advice)) [[unlikely]]
+    {
+        return errno;
+    }
+
+    return 0;
+}
+
+Error prefetch(const File& file, size_t offset, size_t len)
+{
+#ifdef POSIX_FADV_WILLNEED
+    // Starts reading in the background, doesn't wait for it
+    if (const auto error = posix_fadvise(file.fd, static_cast<off_t>(offset), static_cast<off_t>(len), POSIX_FADV_WILLNEED)) [[unlikely]]
+    {
+        return error;
+    }
+#else
+    (void)file;
+    (void)offset;
+    (void)len;
+#endif
     return 0;
 }
 
@@ -338,6 +831,35 @@ Paths getConfigFiles()
     return {path};
 }
 
+std::string getCacheDirectory()
+{
+    utils::Buffer buf;
+
+    if (const auto xdgCache = std::getenv("XDG_CACHE_HOME"); xdgCache and *xdgCache)
+    {
+        buf << xdgCache;
+    }
+    else if (const auto home = std::getenv("HOME"); home)
+    {
+        buf << home << "/.cache";
+    }
+    else
+    {
+        return {};
+    }
+
+    mkdir(buf.data(), 0700);
+
+    buf << "/log-viewer";
+
+    if (mkdir(buf.data(), 0700) == -1 and errno != EEXIST) [[unlikely]]
+    {
+        return {};
+    }
+
+    return buf.str();
+}
+
 int copyToClipboard(std::string string)
 {
     utils::Buffer buf;
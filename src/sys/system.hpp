@@ -1,6 +1,9 @@
 #pragma once
 
+#include <expected>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "sys/common.hpp"
@@ -18,10 +21,29 @@ void finalize();
 void crashHandle(const int signal);
 MaybeFile fileOpen(std::string path);
 Error fileClose(File& file);
-Error remap(const File& file, Mapping& mapping, size_t newOffset, size_t newLen);
+Error fileRefresh(File& file);
+MaybeSize fileRead(const File& file, char* buffer, size_t offset, size_t len);
+bool fileIsRemote(const File& file);
+MaybeFile fileCreateTemporary();
+Error fileAppend(File& file, const char* data, size_t len);
+MaybeFileIdentity fileIdentity(const std::string& path);
+Error fileTouch(const std::string& path);
+Error fileRemove(const std::string& path);
+MaybeDirectoryEntries directoryRead(const std::string& path);
+MaybeFileWatch fileWatch(const std::string& path);
+std::expected<bool, Error> fileWatchWait(FileWatch& watch, int timeoutMs);
+Error fileUnwatch(FileWatch& watch);
+std::expected<FileDescriptor, Error> stdinDetach();
+std::expected<bool, Error> streamWait(FileDescriptor fd, int timeoutMs);
+MaybeSize streamRead(FileDescriptor fd, char* buffer, size_t len);
+Error fileWrite(const std::string& path, std::span<const std::string_view> chunks);
+Error remap(const File& file, Mapping& mapping, size_t newOffset, size_t newLen, AccessPattern pattern = AccessPattern::normal);
+Error advise(const Mapping& mapping, size_t offset, size_t len, AccessPattern pattern);
+Error prefetch(const File& file, size_t offset, size_t len);
 Error unmap(Mapping& mapping);
 void stacktraceLog();
 Paths getConfigFiles();
+std::string getCacheDirectory();
 int copyToClipboard(std::string string);
 
 }  // namespace sys
@@ -1,16 +1,22 @@
 #define LOG_HEADER "ui::Ftxui"
 #include "ftxui.hpp"
 
+#include <chrono>
+#include <condition_variable>
 #include <cstdlib>
 #include <expected>
 #include <memory>
+#include <mutex>
+#include <stop_token>
 #include <string>
+#include <thread>
 
 #include <ftxui/component/component.hpp>
 #include <ftxui/dom/elements.hpp>
 #include <ftxui/screen/string_internal.hpp>
 #include <ftxui/screen/terminal.hpp>
 
+#include "core/buffer.hpp"
 #include "core/command_line.hpp"
 #include "core/context.hpp"
 #include "core/event.hpp"
@@ -22,13 +28,16 @@
 #include "core/main_view.hpp"
 #include "core/message_line.hpp"
 #include "core/mode.hpp"
+#include "core/progress.hpp"
 #include "core/severity.hpp"
 #include "core/thread.hpp"
 #include "sys/system.hpp"
 #include "ui/bookmarks_renderer.hpp"
 #include "ui/palette.hpp"
 #include "ui/window_renderer.hpp"
+#include "utils/buffer.hpp"
 #include "utils/math.hpp"
+#include "utils/units.hpp"
 
 using namespace ftxui;
 
@@ -196,7 +205,37 @@ static Element renderHelp(Ftxui& ui, core::Context& context)
             ));
 }
 
-static Element renderStatusLine(Ftxui&, core::Context& context)
+constexpr static auto PROGRESS_REFRESH_INTERVAL = std::chrono::milliseconds(200);
+
+static std::string renderProgress(const core::Progress& progress)
+{
+    utils::Buffer buf;
+
+    const auto total = progress.total();
+    const auto elapsed = progress.elapsed();
+
+    if (total)
+    {
+        buf << ' ' << utils::min(progress.units() * 100 / total, size_t(100)) << '%';
+    }
+
+    if (elapsed > 0)
+    {
+        const auto throughput = static_cast<float>(progress.bytes()) / MiB / elapsed;
+        buf << ' ' << (throughput | utils::precision(1)) << " MiB/s";
+    }
+
+    if (const auto eta = progress.eta(); eta >= 0)
+    {
+        buf << " ETA " << (eta | utils::precision(0)) << 's';
+    }
+
+    buf << ' ';
+
+    return buf.str();
+}
+
+static Element renderStatusLine(Ftxui& ui, core::Context& context)
 {
     const auto fileName{context.mainView.activeFileName()};
     Color statusFg, statusBg;
@@ -248,6 +287,7 @@ static Element renderStatusLine(Ftxui&, core::Context& context)
     }
 
     utils::Buffer buf;
+    std::string progress;
 
     if (const auto node = context.mainView.currentWindowNode()) [[likely]]
     {
@@ -256,6 +296,12 @@ static Element renderStatusLine(Ftxui&, core::Context& context)
         const auto currentLine = w.ycurrent + w.yoffset + 1;
         const auto currentPosition = w.xcurrent + w.xoffset + 1;
         buf << " " << currentLine << '/' << lineCount << " ℅:" << currentPosition << ' ';
+
+        if (const auto buffer = node->buffer(); buffer and buffer->progress().running())
+        {
+            progress = renderProgress(buffer->progress());
+            ui.progressShown = true;
+        }
     }
 
     return hbox({
@@ -272,6 +318,8 @@ static Element renderStatusLine(Ftxui&, core::Context& context)
         text(fileName)
             | bgcolor(Palette::StatusLine::bg1)
             | flex,
+        text(progress)
+            | bgcolor(Palette::StatusLine::bg1),
         text("")
             | color(statusBg)
             | bgcolor(Palette::StatusLine::bg1),
@@ -359,6 +407,7 @@ static inline ScreenInteractive createScreen()
 
 Ftxui::Ftxui(core::Context& context)
     : screen(createScreen())
+    , progressShown(false)
     , commandLine(context)
     , picker(context)
     , grepper(context)
@@ -382,6 +431,26 @@ void Ftxui::run(core::Context& context)
 
     resize(*this, context);
 
+    // Workers don't send any events about their progress, so the screen is
+    // redrawn periodically for as long as it's shown
+    std::jthread progressRefresher(
+        [this](std::stop_token stopToken)
+        {
+            std::mutex mutex;
+            std::condition_variable_any condition;
+            std::unique_lock lock(mutex);
+
+            while (not stopToken.stop_requested())
+            {
+                condition.wait_for(lock, stopToken, PROGRESS_REFRESH_INTERVAL, []{ return false; });
+
+                if (not stopToken.stop_requested() and progressShown.exchange(false))
+                {
+                    screen.PostEvent(Event::Custom);
+                }
+            }
+        });
+
     screen
         .OnCrash([](const int signal){ sys::crashHandle(signal); })
         .ForceHandleCtrlC(false)
@@ -939,7 +1008,8 @@ Element Grepper::render(core::Context& context)
         separator() | color(frameColor),
         renderCheckbox(options.regex, "regex (a-r)"),
         renderCheckbox(options.caseInsensitive, "case insensitive (a-c)"),
-        renderCheckbox(options.inverted, "inverted (a+i)"))
+        renderCheckbox(options.inverted, "inverted (a+i)"),
+        renderCheckbox(options.multiple, "patterns separated by | (a-m)"))
             | borderStyled(LIGHT, frameColor)
             | clear_under
             | center
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 
 #include <ftxui/component/event.hpp>
@@ -72,6 +73,7 @@ struct Ftxui final : core::UserInterface, core::MainLoop
 
     ftxui::ScreenInteractive screen;
     ftxui::Dimensions        terminalSize;
+    std::atomic_bool         progressShown;
     MainView                 mainView;
     CommandLine              commandLine;
     MainPicker               picker;
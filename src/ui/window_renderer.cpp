@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <cstring>
+#include <iterator>
 #include <memory>
 
 #include <ftxui/screen/color.hpp>
@@ -11,6 +12,7 @@
 #include "core/context.hpp"
 #include "core/logger.hpp"
 #include "core/mode.hpp"
+#include "core/palette.hpp"
 #include "core/window.hpp"
 #include "ui/palette.hpp"
 #include "utils/buffer.hpp"
@@ -54,6 +56,20 @@ static Color convertToColor(uint32_t value)
     );
 }
 
+static Color sourceColor(size_t source)
+{
+    const uint32_t colors[] = {
+        core::Palette::blue,
+        core::Palette::yellow,
+        core::Palette::magenta,
+        core::Palette::cyan,
+        core::Palette::green,
+        core::Palette::red,
+    };
+
+    return convertToColor(colors[source % std::size(colors)]);
+}
+
 void WindowRenderer::Render(ftxui::Screen& screen)
 {
     auto t = utils::startTimeMeasurement();
@@ -128,6 +144,24 @@ void WindowRenderer::Render(ftxui::Screen& screen)
                 xmin = x;
             }
 
+            if (mWindow.sourceWidth)
+            {
+                utils::Buffer buf;
+                buf << (line.sourceName | utils::rightPadding(mWindow.sourceWidth + 1));
+
+                const auto fgColor = sourceColor(line.source);
+
+                for (const auto c : buf)
+                {
+                    auto& pixel = screen.PixelAt(x, y);
+                    pixel.character = c;
+                    pixel.foreground_color = fgColor;
+                    ++x;
+                }
+
+                xmin = x;
+            }
+
             size_t position = 0;
 
             // Draw text line
@@ -3,5 +3,6 @@
 namespace utils
 {
 struct Buffer;
+struct RoaringBitmap;
 struct SourceLocation;
 }  // namespace utils
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "utils/noncopyable.hpp"
+
+namespace utils
+{
+
+// Growable array of trivially copyable values. Growing goes through realloc,
+// which for large arrays usually remaps pages instead of copying them.
+//
+// The array can also borrow an external read-only range (e.g. part of a
+// mapped file); such array is copied into owned memory on first modification
+template <typename T>
+struct PodArray final : NonCopyable
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    constexpr PodArray()
+        : mData(nullptr)
+        , mSize(0)
+        , mCapacity(0)
+    {
+    }
+
+    constexpr PodArray(PodArray&& other)
+        : mData(std::exchange(other.mData, nullptr))
+        , mSize(std::exchange(other.mSize, 0))
+        , mCapacity(std::exchange(other.mCapacity, 0))
+    {
+    }
+
+    constexpr PodArray& operator=(PodArray&& other)
+    {
+        std::swap(mData, other.mData);
+        std::swap(mSize, other.mSize);
+        std::swap(mCapacity, other.mCapacity);
+        return *this;
+    }
+
+    ~PodArray()
+    {
+        if (mCapacity)
+        {
+            std::free(mData);
+        }
+    }
+
+    void borrow(const T* data, size_t size)
+    {
+        if (mCapacity)
+        {
+            std::free(mData);
+        }
+        mData = const_cast<T*>(data);
+        mSize = size;
+        mCapacity = 0;
+    }
+
+    constexpr bool borrowed() const
+    {
+        return mCapacity == 0 and mData;
+    }
+
+    constexpr void pushBack(T value)
+    {
+        // Always true for borrowed array, as its capacity is 0
+        if (mSize >= mCapacity) [[unlikely]]
+        {
+            grow(mSize + 1);
+        }
+        mData[mSize++] = value;
+    }
+
+    constexpr void popBack()
+    {
+        --mSize;
+    }
+
+    void reserve(size_t capacity)
+    {
+        if (capacity > mCapacity)
+        {
+            reallocate(capacity);
+        }
+    }
+
+    void shrinkToFit()
+    {
+        if (mCapacity > mSize)
+        {
+            reallocate(mSize);
+        }
+    }
+
+    void clear()
+    {
+        if (borrowed())
+        {
+            mData = nullptr;
+        }
+        mSize = 0;
+    }
+
+    constexpr T& back()
+    {
+        if (borrowed()) [[unlikely]]
+        {
+            reallocate(mSize);
+        }
+        return mData[mSize - 1];
+    }
+
+    constexpr const T& back() const
+    {
+        return mData[mSize - 1];
+    }
+
+    constexpr T& operator[](size_t i)
+    {
+        if (borrowed()) [[unlikely]]
+        {
+            reallocate(mSize);
+        }
+        return mData[i];
+    }
+
+    constexpr const T& operator[](size_t i) const
+    {
+        return mData[i];
+    }
+
+    constexpr const T* data() const
+    {
+        return mData;
+    }
+
+    constexpr size_t size() const
+    {
+        return mSize;
+    }
+
+    constexpr size_t capacity() const
+    {
+        return mCapacity;
+    }
+
+    constexpr bool empty() const
+    {
+        return mSize == 0;
+    }
+
+private:
+    void grow(size_t minCapacity)
+    {
+        auto capacity = mCapacity ? mCapacity * 2 : 64;
+        reallocate(capacity < minCapacity ? minCapacity : capacity);
+    }
+
+    void reallocate(size_t capacity)
+    {
+        if (capacity == 0)
+        {
+            capacity = 1;
+        }
+
+        T* data;
+
+        if (borrowed())
+        {
+            data = static_cast<T*>(std::malloc(capacity * sizeof(T)));
+            if (data)
+            {
+                std::memcpy(data, mData, mSize * sizeof(T));
+            }
+        }
+        else
+        {
+            data = static_cast<T*>(std::realloc(mData, capacity * sizeof(T)));
+        }
+
+        if (not data) [[unlikely]]
+        {
+            std::abort();
+        }
+
+        mData = data;
+        mCapacity = capacity;
+    }
+
+    T*     mData;
+    size_t mSize;
+    size_t mCapacity;
+};
+
+}  // namespace utils
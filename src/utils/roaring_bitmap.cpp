@@ -0,0 +1,360 @@
+#include "roaring_bitmap.hpp"
+
+#include <algorithm>
+
+namespace utils
+{
+
+using Container = RoaringBitmap::Container;
+
+constexpr static bool test(const std::vector<uint64_t>& bits, uint16_t value)
+{
+    return bits[value >> 6] & (uint64_t(1) << (value & 63));
+}
+
+constexpr static void set(std::vector<uint64_t>& bits, uint16_t value)
+{
+    bits[value >> 6] |= uint64_t(1) << (value & 63);
+}
+
+static void toBitmap(Container& container)
+{
+    container.bits.assign(RoaringBitmap::BITMAP_WORDS, 0);
+
+    for (const auto value : container.values)
+    {
+        set(container.bits, value);
+    }
+
+    container.values = std::vector<uint16_t>();
+}
+
+// Result of operation on bitmaps is counted and converted back to array if
+// it got sparse
+static void fromBitmap(Container& container)
+{
+    container.cardinality = 0;
+
+    for (const auto word : container.bits)
+    {
+        container.cardinality += std::popcount(word);
+    }
+
+    if (container.cardinality > RoaringBitmap::ARRAY_MAX)
+    {
+        return;
+    }
+
+    container.values.reserve(container.cardinality);
+
+    for (size_t i = 0; i < RoaringBitmap::BITMAP_WORDS; ++i)
+    {
+        for (auto word = container.bits[i]; word; word &= word - 1)
+        {
+            container.values.push_back((i << 6) | std::countr_zero(word));
+        }
+    }
+
+    container.bits = std::vector<uint64_t>();
+}
+
+static Container fromArray(uint64_t key, std::vector<uint16_t>&& values)
+{
+    Container container{.key = key, .cardinality = values.size(), .values = std::move(values)};
+
+    if (container.cardinality > RoaringBitmap::ARRAY_MAX)
+    {
+        toBitmap(container);
+    }
+
+    return container;
+}
+
+void RoaringBitmap::append(uint64_t value)
+{
+    const auto key = value >> 16;
+    const auto low = static_cast<uint16_t>(value);
+
+    if (mContainers.empty() or mContainers.back().key != key)
+    {
+        mContainers.push_back(Container{.key = key, .cardinality = 0});
+    }
+
+    auto& container = mContainers.back();
+
+    if (container.bits.empty())
+    {
+        container.values.push_back(low);
+
+        if (container.values.size() > ARRAY_MAX)
+        {
+            toBitmap(container);
+        }
+    }
+    else
+    {
+        set(container.bits, low);
+    }
+
+    ++container.cardinality;
+    ++mSize;
+}
+
+void RoaringBitmap::append(RoaringBitmap&& other)
+{
+    auto it = other.mContainers.begin();
+
+    // Only the first container can share key with the last one here
+    if (it != other.mContainers.end() and not mContainers.empty() and mContainers.back().key == it->key)
+    {
+        RoaringBitmap first;
+        first.add(std::move(*it++));
+        first.forEach([this](uint64_t value){ append(value); });
+    }
+
+    for (; it != other.mContainers.end(); ++it)
+    {
+        add(std::move(*it));
+    }
+
+    other = RoaringBitmap();
+}
+
+bool RoaringBitmap::contains(uint64_t value) const
+{
+    const auto key = value >> 16;
+    const auto low = static_cast<uint16_t>(value);
+
+    const auto it = std::ranges::lower_bound(mContainers, key, {}, &Container::key);
+
+    if (it == mContainers.end() or it->key != key)
+    {
+        return false;
+    }
+
+    return it->bits.empty()
+        ? std::ranges::binary_search(it->values, low)
+        : test(it->bits, low);
+}
+
+size_t RoaringBitmap::memoryUsage() const
+{
+    size_t bytes = mContainers.capacity() * sizeof(Container);
+
+    for (const auto& container : mContainers)
+    {
+        bytes += container.values.capacity() * sizeof(uint16_t) + container.bits.capacity() * sizeof(uint64_t);
+    }
+
+    return bytes;
+}
+
+void RoaringBitmap::add(Container&& container)
+{
+    if (container.cardinality)
+    {
+        mSize += container.cardinality;
+        mContainers.push_back(std::move(container));
+    }
+}
+
+static Container intersect(const Container& lhs, const Container& rhs)
+{
+    const bool lhsArray = lhs.bits.empty();
+    const bool rhsArray = rhs.bits.empty();
+
+    if (lhsArray and rhsArray)
+    {
+        std::vector<uint16_t> values;
+        std::ranges::set_intersection(lhs.values, rhs.values, std::back_inserter(values));
+        return fromArray(lhs.key, std::move(values));
+    }
+
+    if (lhsArray or rhsArray)
+    {
+        const auto& array = lhsArray ? lhs : rhs;
+        const auto& bitmap = lhsArray ? rhs : lhs;
+        std::vector<uint16_t> values;
+
+        for (const auto value : array.values)
+        {
+            if (test(bitmap.bits, value))
+            {
+                values.push_back(value);
+            }
+        }
+
+        return fromArray(lhs.key, std::move(values));
+    }
+
+    Container result{.key = lhs.key, .cardinality = 0, .bits = lhs.bits};
+
+    for (size_t i = 0; i < RoaringBitmap::BITMAP_WORDS; ++i)
+    {
+        result.bits[i] &= rhs.bits[i];
+    }
+
+    fromBitmap(result);
+
+    return result;
+}
+
+static Container unite(const Container& lhs, const Container& rhs)
+{
+    const bool lhsArray = lhs.bits.empty();
+    const bool rhsArray = rhs.bits.empty();
+
+    if (lhsArray and rhsArray)
+    {
+        std::vector<uint16_t> values;
+        std::ranges::set_union(lhs.values, rhs.values, std::back_inserter(values));
+        return fromArray(lhs.key, std::move(values));
+    }
+
+    Container result{.key = lhs.key, .cardinality = 0, .bits = lhsArray ? rhs.bits : lhs.bits};
+
+    if (lhsArray or rhsArray)
+    {
+        for (const auto value : (lhsArray ? lhs : rhs).values)
+        {
+            set(result.bits, value);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < RoaringBitmap::BITMAP_WORDS; ++i)
+        {
+            result.bits[i] |= rhs.bits[i];
+        }
+    }
+
+    fromBitmap(result);
+
+    return result;
+}
+
+static Container subtract(const Container& lhs, const Container& rhs)
+{
+    const bool lhsArray = lhs.bits.empty();
+    const bool rhsArray = rhs.bits.empty();
+
+    if (lhsArray)
+    {
+        std::vector<uint16_t> values;
+
+        if (rhsArray)
+        {
+            std::ranges::set_difference(lhs.values, rhs.values, std::back_inserter(values));
+        }
+        else
+        {
+            for (const auto value : lhs.values)
+            {
+                if (not test(rhs.bits, value))
+                {
+                    values.push_back(value);
+                }
+            }
+        }
+
+        return fromArray(lhs.key, std::move(values));
+    }
+
+    Container result{.key = lhs.key, .cardinality = 0, .bits = lhs.bits};
+
+    if (rhsArray)
+    {
+        for (const auto value : rhs.values)
+        {
+            result.bits[value >> 6] &= ~(uint64_t(1) << (value & 63));
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < RoaringBitmap::BITMAP_WORDS; ++i)
+        {
+            result.bits[i] &= ~rhs.bits[i];
+        }
+    }
+
+    fromBitmap(result);
+
+    return result;
+}
+
+RoaringBitmap operator&(const RoaringBitmap& lhs, const RoaringBitmap& rhs)
+{
+    RoaringBitmap result;
+    auto l = lhs.mContainers.begin();
+    auto r = rhs.mContainers.begin();
+
+    while (l != lhs.mContainers.end() and r != rhs.mContainers.end())
+    {
+        if (l->key < r->key)
+        {
+            ++l;
+        }
+        else if (r->key < l->key)
+        {
+            ++r;
+        }
+        else
+        {
+            result.add(intersect(*l++, *r++));
+        }
+    }
+
+    return result;
+}
+
+RoaringBitmap operator|(const RoaringBitmap& lhs, const RoaringBitmap& rhs)
+{
+    RoaringBitmap result;
+    auto l = lhs.mContainers.begin();
+    auto r = rhs.mContainers.begin();
+
+    while (l != lhs.mContainers.end() or r != rhs.mContainers.end())
+    {
+        if (r == rhs.mContainers.end() or (l != lhs.mContainers.end() and l->key < r->key))
+        {
+            result.add(Container(*l++));
+        }
+        else if (l == lhs.mContainers.end() or r->key < l->key)
+        {
+            result.add(Container(*r++));
+        }
+        else
+        {
+            result.add(unite(*l++, *r++));
+        }
+    }
+
+    return result;
+}
+
+RoaringBitmap operator-(const RoaringBitmap& lhs, const RoaringBitmap& rhs)
+{
+    RoaringBitmap result;
+    auto r = rhs.mContainers.begin();
+
+    for (const auto& container : lhs.mContainers)
+    {
+        while (r != rhs.mContainers.end() and r->key < container.key)
+        {
+            ++r;
+        }
+
+        if (r != rhs.mContainers.end() and r->key == container.key)
+        {
+            result.add(subtract(container, *r));
+        }
+        else
+        {
+            result.add(Container(container));
+        }
+    }
+
+    return result;
+}
+
+}  // namespace utils
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utils
+{
+
+// Compressed set of integers in the style of Roaring bitmaps. Values are
+// split by their upper bits into containers of 2^16 values each; container
+// keeps its values either as a sorted array of lower 16 bits, if there are
+// at most ARRAY_MAX of them, or as a bitmap of all 2^16. Set operations go
+// container by container, so they take time proportional to the compressed
+// size, not to the range of values
+struct RoaringBitmap final
+{
+    constexpr static size_t ARRAY_MAX = 4096;
+    constexpr static size_t BITMAP_WORDS = 1024;
+
+    // Exactly one of values and bits is used, depending on cardinality
+    struct Container
+    {
+        uint64_t              key;
+        size_t                cardinality;
+        std::vector<uint16_t> values;
+        std::vector<uint64_t> bits;
+    };
+
+    // Values have to be appended in increasing order
+    void append(uint64_t value);
+
+    // Moves values of other to the end; all of them have to be greater than
+    // values of this one
+    void append(RoaringBitmap&& other);
+
+    bool contains(uint64_t value) const;
+
+    constexpr size_t size() const
+    {
+        return mSize;
+    }
+
+    constexpr bool empty() const
+    {
+        return mSize == 0;
+    }
+
+    constexpr size_t containerCount() const
+    {
+        return mContainers.size();
+    }
+
+    size_t memoryUsage() const;
+
+    // Calls function with values in increasing order
+    template <typename Function>
+    void forEach(Function&& function) const
+    {
+        for (const auto& container : mContainers)
+        {
+            const auto high = container.key << 16;
+
+            if (container.bits.empty())
+            {
+                for (const auto low : container.values)
+                {
+                    function(high | low);
+                }
+                continue;
+            }
+
+            for (size_t i = 0; i < BITMAP_WORDS; ++i)
+            {
+                for (auto word = container.bits[i]; word; word &= word - 1)
+                {
+                    function(high | (i << 6) | std::countr_zero(word));
+                }
+            }
+        }
+    }
+
+    friend RoaringBitmap operator&(const RoaringBitmap& lhs, const RoaringBitmap& rhs);
+    friend RoaringBitmap operator|(const RoaringBitmap& lhs, const RoaringBitmap& rhs);
+
+    // Values of lhs which are not in rhs
+    friend RoaringBitmap operator-(const RoaringBitmap& lhs, const RoaringBitmap& rhs);
+
+private:
+    void add(Container&& container);
+
+    std::vector<Container> mContainers;
+    size_t                 mSize = 0;
+};
+
+}  // namespace utils
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "utils/pod_array.hpp"
+
+namespace utils
+{
+
+// Maps index of an element of a container made of segments of arbitrary
+// length into the segment holding it. For every page of PAGE_SIZE elements
+// the segment holding its first element is recorded, so the lookup starts
+// from there and only steps over segments shorter than a page.
+//
+// Only the last segment can change its length
+struct SegmentMap final
+{
+    constexpr static size_t PAGE_SHIFT = 16;
+    constexpr static size_t PAGE_SIZE = 1 << PAGE_SHIFT;
+
+    struct Location
+    {
+        size_t segment;
+        size_t offset;
+    };
+
+    // Adds empty segment at the end
+    void addSegment()
+    {
+        mEnds.pushBack(size());
+    }
+
+    // Removes the last segment, which must be empty
+    void removeSegment()
+    {
+        mEnds.popBack();
+    }
+
+    // Extends the last segment by count elements
+    void grow(size_t count)
+    {
+        const auto oldSize = size();
+        const auto newSize = oldSize + count;
+        const auto segment = static_cast<uint32_t>(mEnds.size() - 1);
+
+        mEnds.back() = newSize;
+
+        for (auto page = mPages.size() << PAGE_SHIFT; page < newSize; page += PAGE_SIZE)
+        {
+            mPages.pushBack(segment);
+        }
+    }
+
+    // Shrinks the last segment by count elements
+    void shrink(size_t count)
+    {
+        const auto newSize = size() - count;
+
+        mEnds.back() = newSize;
+
+        while (mPages.size() and ((mPages.size() - 1) << PAGE_SHIFT) >= newSize)
+        {
+            mPages.popBack();
+        }
+    }
+
+    void clear()
+    {
+        mEnds.clear();
+        mPages.clear();
+    }
+
+    void shrinkToFit()
+    {
+        mEnds.shrinkToFit();
+        mPages.shrinkToFit();
+    }
+
+    size_t memoryUsage() const
+    {
+        return mEnds.capacity() * sizeof(size_t) + mPages.capacity() * sizeof(uint32_t);
+    }
+
+    constexpr Location locate(size_t i) const
+    {
+        size_t segment = mPages[i >> PAGE_SHIFT];
+
+        while (i >= mEnds[segment])
+        {
+            ++segment;
+        }
+
+        return Location{.segment = segment, .offset = segment ? i - mEnds[segment - 1] : i};
+    }
+
+    constexpr size_t segmentCount() const
+    {
+        return mEnds.size();
+    }
+
+    constexpr size_t size() const
+    {
+        return mEnds.empty() ? 0 : mEnds[mEnds.size() - 1];
+    }
+
+private:
+    PodArray<size_t>   mEnds;
+    PodArray<uint32_t> mPages;
+};
+
+}  // namespace utils
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "utils/noncopyable.hpp"
+#include "utils/pod_array.hpp"
+#include "utils/segment_map.hpp"
+
+namespace utils
+{
+
+// Array of trivially copyable values kept in segments, so that arrays built
+// independently (e.g. by worker threads) can be joined without copying their
+// contents. Appending an array shorter than MIN_SEGMENT_SIZE copies it
+// instead, so that segments don't get fragmented
+template <typename T>
+struct SegmentedArray final : NonCopyable
+{
+    constexpr static size_t MIN_SEGMENT_SIZE = SegmentMap::PAGE_SIZE;
+
+    SegmentedArray() = default;
+    SegmentedArray(SegmentedArray&&) = default;
+    SegmentedArray& operator=(SegmentedArray&&) = default;
+
+    void pushBack(T value)
+    {
+        if (mSegments.empty()) [[unlikely]]
+        {
+            mSegments.emplace_back();
+            mMap.addSegment();
+        }
+        mSegments.back().pushBack(value);
+        mMap.grow(1);
+    }
+
+    void append(SegmentedArray&& other)
+    {
+        if (other.empty())
+        {
+            return;
+        }
+
+        if (empty())
+        {
+            *this = std::move(other);
+            return;
+        }
+
+        if (other.size() < MIN_SEGMENT_SIZE)
+        {
+            for (size_t i = 0; i < other.size(); ++i)
+            {
+                pushBack(other[i]);
+            }
+        }
+        else
+        {
+            for (auto& segment : other.mSegments)
+            {
+                mMap.addSegment();
+                mMap.grow(segment.size());
+                mSegments.emplace_back(std::move(segment));
+            }
+        }
+
+        other.clear();
+    }
+
+    void clear()
+    {
+        mSegments.clear();
+        mMap.clear();
+    }
+
+    void shrinkToFit()
+    {
+        for (auto& segment : mSegments)
+        {
+            segment.shrinkToFit();
+        }
+        mMap.shrinkToFit();
+    }
+
+    size_t memoryUsage() const
+    {
+        size_t bytes = mMap.memoryUsage();
+        for (const auto& segment : mSegments)
+        {
+            bytes += segment.capacity() * sizeof(T);
+        }
+        return bytes;
+    }
+
+    constexpr const T& operator[](size_t i) const
+    {
+        const auto location = mMap.locate(i);
+        return mSegments[location.segment][location.offset];
+    }
+
+    constexpr const T& back() const
+    {
+        return mSegments.back().back();
+    }
+
+    constexpr size_t segmentCount() const
+    {
+        return mSegments.size();
+    }
+
+    constexpr size_t size() const
+    {
+        return mMap.size();
+    }
+
+    constexpr bool empty() const
+    {
+        return size() == 0;
+    }
+
+private:
+    std::vector<PodArray<T>> mSegments;
+    SegmentMap               mMap;
+};
+
+}  // namespace utils
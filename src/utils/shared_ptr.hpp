@@ -35,13 +35,21 @@ struct SharedPtr
 
     constexpr SharedPtr& operator=(const SharedPtr& other)
     {
-        copyFrom(other);
+        if (this != &other)
+        {
+            destroy();
+            copyFrom(other);
+        }
         return *this;
     }
 
     constexpr SharedPtr& operator=(SharedPtr&& other)
     {
-        moveFrom(std::move(other));
+        if (this != &other)
+        {
+            destroy();
+            moveFrom(std::move(other));
+        }
         return *this;
     }
 
@@ -34,7 +34,9 @@ std::string operator|(const std::string& path, const ReadTextWithoutLimit&)
 
 std::string operator|(const std::string& path, const ReadTextWithLimit& data)
 {
-    if (std::filesystem::file_size(path) > data.fileSizeLimit)
+    std::error_code error;
+
+    if (std::filesystem::file_size(path, error) > data.fileSizeLimit or error)
     {
         return "";
     }
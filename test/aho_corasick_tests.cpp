@@ -0,0 +1,103 @@
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/aho_corasick.hpp"
+
+using namespace core;
+
+static size_t naiveFind(std::string_view text, const std::vector<std::string>& patterns, size_t pos = 0)
+{
+    size_t result = AhoCorasick::npos;
+
+    for (const auto& pattern : patterns)
+    {
+        if (pattern.empty())
+        {
+            continue;
+        }
+
+        if (const auto found = text.find(pattern, pos); found != text.npos)
+        {
+            const auto end = found + pattern.size() - 1;
+            result = result == AhoCorasick::npos or end < result ? end : result;
+        }
+    }
+
+    return result;
+}
+
+TEST(AhoCorasickTests, findsAnyPattern)
+{
+    const std::vector<std::string> patterns{"he", "she", "his", "Hers"};
+    AhoCorasick ac(patterns, false);
+
+    ASSERT_EQ(ac.find("ushers"), 3);
+    ASSERT_EQ(ac.find("ushers", 2), 3);
+    ASSERT_EQ(ac.find("usHers", 2), 5);
+    ASSERT_EQ(ac.find("ushers", 3), AhoCorasick::npos);
+    ASSERT_EQ(ac.find("this"), 3);
+    ASSERT_EQ(ac.find("xyz"), AhoCorasick::npos);
+    ASSERT_EQ(ac.find(""), AhoCorasick::npos);
+    ASSERT_TRUE(ac.contains("a shell"));
+    ASSERT_FALSE(ac.contains("HERS"));
+}
+
+TEST(AhoCorasickTests, findsIgnoringCase)
+{
+    const std::vector<std::string> patterns{"Timeout", "E1001", "refused"};
+    AhoCorasick ac(patterns, true);
+
+    ASSERT_EQ(ac.find("got TIMEOUT"), 10);
+    ASSERT_EQ(ac.find("code e1001"), 9);
+    ASSERT_EQ(ac.find("connection Refused"), 17);
+    ASSERT_FALSE(ac.contains("E1002"));
+    ASSERT_FALSE(AhoCorasick(std::vector<std::string>{"a@"}, true).contains("A`"));
+}
+
+TEST(AhoCorasickTests, ignoresEmptyPatterns)
+{
+    AhoCorasick empty(std::vector<std::string>{}, false);
+    AhoCorasick withEmpty(std::vector<std::string>{"", "ab"}, false);
+
+    ASSERT_FALSE(empty.contains("abc"));
+    ASSERT_EQ(withEmpty.find("xxab"), 3);
+    ASSERT_FALSE(withEmpty.contains("xyz"));
+}
+
+TEST(AhoCorasickTests, matchesNaiveSearch)
+{
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int> dist(0, 3);
+
+    for (int iteration = 0; iteration < 200; ++iteration)
+    {
+        std::vector<std::string> patterns(1 + gen() % 20);
+
+        for (auto& pattern : patterns)
+        {
+            pattern.resize(1 + gen() % 6);
+            for (auto& c : pattern)
+            {
+                c = 'a' + dist(gen);
+            }
+        }
+
+        std::string text(200, 'a');
+
+        for (auto& c : text)
+        {
+            c = 'a' + dist(gen) + dist(gen) / 3;
+        }
+
+        AhoCorasick ac(patterns, false);
+
+        for (size_t pos = 0; pos <= text.size(); pos += 13)
+        {
+            ASSERT_EQ(ac.find(text, pos), naiveFind(text, patterns, pos)) << "iteration: " << iteration << " pos: " << pos;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include "core/grep_cache.hpp"
+
+using namespace core;
+
+static GrepCacheValue makeValue(size_t count, std::string prefilter = {})
+{
+    auto lines = utils::makeShared<LineRefs>();
+    auto bitmap = utils::makeShared<utils::RoaringBitmap>();
+    for (size_t i = 0; i < count; ++i)
+    {
+        lines->pushBack(i * 2);
+        bitmap->append(i * 2);
+    }
+    return GrepCacheValue{.lines = lines, .bitmap = bitmap, .prefilter = std::move(prefilter)};
+}
+
+static size_t sizeOf(const GrepCacheValue& value)
+{
+    return value.lines->memoryUsage() + value.bitmap->memoryUsage();
+}
+
+TEST(GrepCacheTests, findsStoredEntries)
+{
+    const auto value = makeValue(100, "timeout");
+    const auto size = sizeOf(value);
+
+    grepCacheStore(
+        GrepCacheKey{.parentVersion = 1, .pattern = "error.*timeout", .options = {}},
+        value,
+        1000000);
+
+    auto found = grepCacheFind(GrepCacheKey{.parentVersion = 1, .pattern = "error.*timeout", .options = {}});
+
+    ASSERT_EQ(found.lines.get(), value.lines.get());
+    ASSERT_EQ(found.bitmap.get(), value.bitmap.get());
+    ASSERT_EQ(found.prefilter, "timeout");
+    ASSERT_EQ(grepCacheMemoryUsage(), size);
+
+    ASSERT_FALSE(grepCacheFind(GrepCacheKey{.parentVersion = 2, .pattern = "error.*timeout", .options = {}}).lines.get());
+    ASSERT_FALSE(grepCacheFind(GrepCacheKey{.parentVersion = 1, .pattern = "Error.*timeout", .options = {}}).lines.get());
+    ASSERT_FALSE(grepCacheFind(GrepCacheKey{.parentVersion = 1, .pattern = "error.*timeout", .options = {.inverted = true}}).lines.get());
+
+    grepCacheInvalidate(1);
+
+    ASSERT_FALSE(grepCacheFind(GrepCacheKey{.parentVersion = 1, .pattern = "error.*timeout", .options = {}}).lines.get());
+    ASSERT_EQ(grepCacheMemoryUsage(), 0);
+}
+
+TEST(GrepCacheTests, evictsLeastRecentlyUsed)
+{
+    const auto size = sizeOf(makeValue(1000));
+    const auto key = [](const char* pattern){ return GrepCacheKey{.parentVersion = 3, .pattern = pattern, .options = {}}; };
+
+    grepCacheStore(key("a"), makeValue(1000), size * 2);
+    grepCacheStore(key("b"), makeValue(1000), size * 2);
+
+    // Use of "a" makes "b" the least recently used one
+    ASSERT_TRUE(grepCacheFind(key("a")).lines.get());
+
+    grepCacheStore(key("c"), makeValue(1000), size * 2);
+
+    ASSERT_TRUE(grepCacheFind(key("a")).lines.get());
+    ASSERT_FALSE(grepCacheFind(key("b")).lines.get());
+    ASSERT_TRUE(grepCacheFind(key("c")).lines.get());
+    ASSERT_EQ(grepCacheMemoryUsage(), size * 2);
+
+    // Entry bigger than the whole cache is not stored
+    grepCacheStore(key("d"), makeValue(1000), size - 1);
+
+    ASSERT_FALSE(grepCacheFind(key("d")).lines.get());
+
+    grepCacheInvalidate(3);
+
+    ASSERT_EQ(grepCacheMemoryUsage(), 0);
+}
@@ -0,0 +1,206 @@
+#include <random>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include "core/gzip.hpp"
+
+using namespace core;
+
+static std::string compress(const std::string& data)
+{
+    z_stream stream{};
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+
+    std::string output(deflateBound(&stream, data.size()), '\0');
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+    stream.next_out = reinterpret_cast<Bytef*>(output.data());
+    stream.avail_out = output.size();
+
+    deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    return output;
+}
+
+static std::string generateLog(size_t lines)
+{
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int> dist(0, 1000000);
+    std::string data;
+
+    for (size_t i = 0; i < lines; ++i)
+    {
+        data += "2024-01-01 12:00:00.000 [" + std::to_string(i) + "] some message with value " + std::to_string(dist(gen)) + '\n';
+    }
+
+    return data;
+}
+
+static void expectRandomReadsMatch(const std::string& data, const GzipIndex& index)
+{
+    std::mt19937 gen(4321);
+    std::uniform_int_distribution<size_t> offsetDist(0, data.size() - 1);
+    GzipReader reader(index);
+
+    for (int i = 0; i < 200; ++i)
+    {
+        const auto offset = offsetDist(gen);
+        const auto len = std::min(data.size() - offset, size_t(i % 3 ? 100 : 200000));
+        auto result = reader.read(offset, len);
+
+        ASSERT_TRUE(result) << result.error();
+        ASSERT_EQ(std::string_view(*result, len), std::string_view(data).substr(offset, len)) << "offset: " << offset;
+    }
+}
+
+TEST(GzipTests, canReadAnyRange)
+{
+    const auto data = generateLog(100000);
+    const auto compressed = compress(data);
+    const std::atomic_bool stopFlag(false);
+
+    GzipIndex index(compressed.data(), compressed.size());
+
+    auto result = index.build(stopFlag, 64_KiB);
+
+    ASSERT_TRUE(result) << result.error();
+    ASSERT_EQ(index.size(), data.size());
+    ASSERT_GT(index.checkpointCount(), 10);
+
+    expectRandomReadsMatch(data, index);
+}
+
+TEST(GzipTests, canReadSequentially)
+{
+    const auto data = generateLog(50000);
+    const auto compressed = compress(data);
+    const std::atomic_bool stopFlag(false);
+
+    GzipIndex index(compressed.data(), compressed.size());
+
+    ASSERT_TRUE(index.build(stopFlag, 64_KiB));
+
+    GzipReader reader(index);
+
+    for (size_t offset = 0; offset < data.size(); offset += 10000)
+    {
+        const auto len = std::min(data.size() - offset, size_t(10000));
+        auto result = reader.read(offset, len);
+
+        ASSERT_TRUE(result) << result.error();
+        ASSERT_EQ(std::string_view(*result, len), std::string_view(data).substr(offset, len)) << "offset: " << offset;
+    }
+}
+
+TEST(GzipTests, canReadMultipleMembers)
+{
+    const auto first = generateLog(20000);
+    const auto second = generateLog(30000);
+    const auto data = first + second;
+    const auto compressed = compress(first) + compress(second) + std::string(16, '\0');
+    const std::atomic_bool stopFlag(false);
+
+    GzipIndex index(compressed.data(), compressed.size());
+
+    auto result = index.build(stopFlag, 64_KiB);
+
+    ASSERT_TRUE(result) << result.error();
+    ASSERT_EQ(index.size(), data.size());
+
+    expectRandomReadsMatch(data, index);
+
+    GzipReader reader(index);
+
+    // Crossing the member boundary
+    auto read = reader.read(first.size() - 50, 100);
+
+    ASSERT_TRUE(read) << read.error();
+    ASSERT_EQ(std::string_view(*read, 100), std::string_view(data).substr(first.size() - 50, 100));
+}
+
+TEST(GzipTests, keepsDataPrecedingReadInBuffer)
+{
+    const auto data = generateLog(50000);
+    const auto compressed = compress(data);
+    const std::atomic_bool stopFlag(false);
+
+    GzipIndex index(compressed.data(), compressed.size());
+
+    ASSERT_TRUE(index.build(stopFlag, 64_KiB));
+
+    GzipReader reader(index);
+
+    const auto offset = data.size() / 2;
+    auto result = reader.read(offset, 100);
+
+    ASSERT_TRUE(result) << result.error();
+
+    const auto start = reader.bufferOffset();
+    const auto buffer = reader.buffer();
+
+    // Buffer starts at the checkpoint the read has decompressed from
+    ASSERT_EQ(start, index.closestCheckpoint(offset).out);
+    ASSERT_EQ(start + buffer.size(), offset + 100);
+    ASSERT_EQ(buffer, std::string_view(data).substr(start, buffer.size()));
+
+    // Going backwards within the buffer doesn't move it
+    for (auto i = offset; i >= start + 100; i -= 100)
+    {
+        result = reader.read(i - 100, 100);
+
+        ASSERT_TRUE(result) << result.error();
+        ASSERT_EQ(std::string_view(*result, 100), std::string_view(data).substr(i - 100, 100));
+        ASSERT_EQ(reader.bufferOffset(), start);
+    }
+}
+
+TEST(GzipTests, passesDecompressedDataToOutput)
+{
+    const auto first = generateLog(20000);
+    const auto second = generateLog(10000);
+    const auto compressed = compress(first) + compress(second);
+    const std::atomic_bool stopFlag(false);
+
+    std::string output;
+
+    const auto append = [&output](std::string_view data){ output += data; };
+    const GzipIndex::Output outputRef(append);
+
+    GzipIndex index(compressed.data(), compressed.size());
+
+    auto result = index.build(stopFlag, 64_KiB, &outputRef);
+
+    ASSERT_TRUE(result) << result.error();
+    ASSERT_EQ(output, first + second);
+}
+
+TEST(GzipTests, failsOnTruncatedData)
+{
+    const auto compressed = compress(generateLog(1000));
+    const std::atomic_bool stopFlag(false);
+
+    GzipIndex index(compressed.data(), compressed.size() / 2);
+
+    ASSERT_FALSE(index.build(stopFlag));
+}
+
+TEST(GzipTests, failsOnReadPastEnd)
+{
+    const auto data = generateLog(10);
+    const auto compressed = compress(data);
+    const std::atomic_bool stopFlag(false);
+
+    GzipIndex index(compressed.data(), compressed.size());
+
+    ASSERT_TRUE(index.build(stopFlag));
+
+    GzipReader reader(index);
+
+    ASSERT_FALSE(reader.read(data.size() - 10, 11));
+    ASSERT_TRUE(reader.read(data.size() - 10, 10));
+}
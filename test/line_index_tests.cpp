@@ -0,0 +1,288 @@
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/line_index.hpp"
+
+using namespace core;
+
+static LineIndex build(const std::vector<size_t>& starts, size_t fileSize)
+{
+    LineIndex index;
+    for (auto start : starts)
+    {
+        index.append(start);
+    }
+    index.finalize(fileSize);
+    return index;
+}
+
+TEST(LineIndexTests, emptyFile)
+{
+    auto index = build({0}, 0);
+
+    ASSERT_EQ(index.size(), 0);
+    ASSERT_TRUE(index.empty());
+}
+
+TEST(LineIndexTests, derivesLengthsFromNextStart)
+{
+    // "ab\n\ncde\n"
+    auto index = build({0, 3, 4, 8}, 8);
+
+    ASSERT_EQ(index.size(), 3);
+    ASSERT_EQ(index[0].start, 0);
+    ASSERT_EQ(index[0].len, 2);
+    ASSERT_EQ(index[1].start, 3);
+    ASSERT_EQ(index[1].len, 0);
+    ASSERT_EQ(index[2].start, 4);
+    ASSERT_EQ(index[2].len, 3);
+}
+
+TEST(LineIndexTests, lastLineWithoutNewline)
+{
+    // "ab\ncd"
+    auto index = build({0, 3}, 5);
+
+    ASSERT_EQ(index.size(), 2);
+    ASSERT_EQ(index[1].start, 3);
+    ASSERT_EQ(index[1].len, 2);
+}
+
+TEST(LineIndexTests, fallsBackToWideOffsetsForLongLines)
+{
+    std::vector<size_t> starts{0};
+
+    for (size_t i = 0; i < 300; ++i)
+    {
+        starts.push_back(starts.back() + (i % 50 == 17 ? 100000 : 10));
+    }
+
+    auto index = build(starts, starts.back());
+
+    ASSERT_EQ(index.size(), starts.size() - 1);
+
+    for (size_t i = 0; i < index.size(); ++i)
+    {
+        ASSERT_EQ(index[i].start, starts[i]) << "line: " << i;
+        ASSERT_EQ(index[i].len, starts[i + 1] - starts[i] - 1) << "line: " << i;
+    }
+}
+
+TEST(LineIndexTests, keepsBlocksOfLongLinesNarrow)
+{
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<size_t> dist(1000, 65536);
+
+    std::vector<size_t> starts{0};
+
+    // Blocks span megabytes, but no single line is too long for a delta
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        starts.push_back(starts.back() + dist(gen));
+    }
+
+    auto index = build(starts, starts.back());
+
+    ASSERT_EQ(index.segment(0).wide.size(), 0);
+
+    for (size_t i = 0; i < starts.size(); ++i)
+    {
+        ASSERT_EQ(index.start(i), starts[i]) << "start: " << i;
+    }
+}
+
+TEST(LineIndexTests, canAppendOtherIndex)
+{
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<size_t> dist(1, 200);
+
+    std::vector<size_t> starts{0};
+    LineIndex first, second;
+
+    first.append(0);
+
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        starts.push_back(starts.back() + dist(gen) * (i == 700 ? 1000 : 1));
+        (i < 500 ? first : second).append(starts.back());
+    }
+
+    first.append(std::move(second));
+    first.finalize(starts.back());
+
+    ASSERT_EQ(first.size(), starts.size() - 1);
+
+    for (size_t i = 0; i < starts.size(); ++i)
+    {
+        ASSERT_EQ(first.start(i), starts[i]) << "start: " << i;
+    }
+}
+
+TEST(LineIndexTests, usesLessMemoryThanStartAndLength)
+{
+    LineIndex index;
+
+    for (size_t i = 0; i < 100000; ++i)
+    {
+        index.append(i * 120);
+    }
+
+    index.shrinkToFit();
+
+    ASSERT_LT(index.memoryUsage(), 100000 * 4);
+}
+
+TEST(LineIndexTests, canViewExternalStorage)
+{
+    std::vector<size_t> starts{0};
+
+    for (size_t i = 0; i < 200; ++i)
+    {
+        starts.push_back(starts.back() + (i == 100 ? 70000 : 20));
+    }
+
+    auto source = build(starts, starts.back() - 5);
+
+    const auto segment = source.segment(0);
+    const std::vector<LineIndex::Block> blocks(segment.blocks.begin(), segment.blocks.end());
+    const std::vector<uint16_t> deltas(segment.deltas.begin(), segment.deltas.end());
+    const std::vector<uint64_t> wide(segment.wide.begin(), segment.wide.end());
+    const LineIndex::SegmentView view{.blocks = blocks, .deltas = deltas, .wide = wide};
+
+    LineIndex index;
+    index.view(nullptr, {&view, 1});
+
+    ASSERT_EQ(index.size(), source.size());
+    ASSERT_GE(index.memoryUsage(), blocks.size() * sizeof(LineIndex::Block) + deltas.size() * 2 + wide.size() * 8);
+
+    for (size_t i = 0; i < index.startCount(); ++i)
+    {
+        ASSERT_EQ(index.start(i), source.start(i)) << "start: " << i;
+    }
+}
+
+TEST(LineIndexTests, viewIsCopiedWhenExtended)
+{
+    std::vector<size_t> starts{0};
+
+    for (size_t i = 0; i < 130; ++i)
+    {
+        starts.push_back(starts.back() + 10);
+    }
+
+    // Last line not terminated, so a sentinel is added
+    const auto fileSize = starts.back() + 3;
+    auto source = build(starts, fileSize);
+
+    const auto segment = source.segment(0);
+    const std::vector<LineIndex::Block> blocks(segment.blocks.begin(), segment.blocks.end());
+    const std::vector<uint16_t> deltas(segment.deltas.begin(), segment.deltas.end());
+    const LineIndex::SegmentView view{.blocks = blocks, .deltas = deltas, .wide = {}};
+
+    LineIndex index;
+    index.view(nullptr, {&view, 1});
+    index.unfinalize(fileSize);
+
+    ASSERT_EQ(index.startCount(), starts.size());
+
+    index.append(fileSize + 1);
+    index.append(fileSize + 20);
+    index.finalize(fileSize + 20);
+
+    ASSERT_EQ(index.size(), starts.size() + 1);
+    ASSERT_EQ(index[starts.size() - 1].len, 3);
+    ASSERT_EQ(index[starts.size()].start, fileSize + 1);
+    ASSERT_EQ(index[starts.size()].len, 18);
+
+    // Viewed storage is untouched
+    ASSERT_EQ(deltas.size(), segment.deltas.size());
+    ASSERT_EQ(deltas.back(), segment.deltas.back());
+}
+
+TEST(LineIndexTests, takesOverSegmentsOfLargeIndex)
+{
+    constexpr size_t count = LineIndex::MIN_SEGMENT_STARTS * 2 + 100;
+
+    std::vector<size_t> starts{0};
+    LineIndex first, second, third;
+
+    first.append(0);
+
+    for (size_t i = 1; i < count * 3; ++i)
+    {
+        starts.push_back(starts.back() + (i % 1000 == 3 ? 100000 : i % 7 + 1));
+        (i < count ? first : i < count * 2 ? second : third).append(starts.back());
+    }
+
+    LineIndex small;
+
+    for (size_t i = 1; i <= 10; ++i)
+    {
+        starts.push_back(starts.back() + i);
+        small.append(starts.back());
+    }
+
+    first.append(std::move(second));
+    first.append(std::move(third));
+    first.append(std::move(small));
+
+    ASSERT_EQ(first.segmentCount(), 3);
+    ASSERT_EQ(first.startCount(), starts.size());
+    ASSERT_TRUE(second.empty());
+
+    for (size_t i = 0; i < starts.size(); ++i)
+    {
+        ASSERT_EQ(first.start(i), starts[i]) << "start: " << i;
+    }
+
+    first.finalize(starts.back() + 5);
+
+    ASSERT_EQ(first[starts.size() - 1].start, starts.back());
+    ASSERT_EQ(first[starts.size() - 1].len, 5);
+
+    first.unfinalize(starts.back() + 5);
+
+    ASSERT_EQ(first.startCount(), starts.size());
+}
+
+TEST(LineIndexTests, keepsStorageOfCopiedView)
+{
+    struct Storage final : LineIndex::Storage
+    {
+        Storage(bool& destroyed)
+            : destroyed(destroyed)
+        {
+        }
+
+        ~Storage() override
+        {
+            destroyed = true;
+        }
+
+        bool& destroyed;
+    };
+
+    auto source = build({100, 110, 120, 130}, 130);
+
+    const auto segment = source.segment(0);
+    const LineIndex::SegmentView view{.blocks = segment.blocks, .deltas = segment.deltas, .wide = {}};
+
+    bool destroyed = false;
+
+    {
+        LineIndex index;
+        index.append(0);
+
+        // Short view is copied, but its storage still has to be kept, as
+        // views appended later may refer to it
+        LineIndex viewed;
+        viewed.view(utils::UniquePtr<LineIndex::Storage>(new Storage(destroyed)), {&view, 1});
+        index.append(std::move(viewed));
+
+        ASSERT_FALSE(destroyed);
+    }
+
+    ASSERT_TRUE(destroyed);
+}
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/aho_corasick.hpp"
+#include "core/literal_search.hpp"
+
+using namespace core;
+
+using Clock = std::chrono::steady_clock;
+using Lines = std::vector<std::string_view>;
+
+struct Corpus
+{
+    const char* name;
+    std::string text;
+    Lines       lines;
+};
+
+constexpr static size_t CORPUS_SIZE = 256 * 1024 * 1024;
+constexpr static int    REPEATS = 5;
+
+// Log-like lines of random words; every 1000th line has the pattern
+static Corpus makeCorpus(const char* name, size_t lineLen, std::string_view pattern)
+{
+    constexpr static const char* words[] = {
+        "INFO", "DEBUG", "request", "served", "in", "ms", "client", "connected",
+        "worker", "queue", "size", "retrying", "session", "closed", "eta", "err",
+    };
+
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<size_t> dist(0, std::size(words) - 1);
+    Corpus corpus{.name = name};
+    std::vector<size_t> lineLens;
+
+    for (size_t i = 0; corpus.text.size() < CORPUS_SIZE; ++i)
+    {
+        const auto start = corpus.text.size();
+
+        while (corpus.text.size() - start < lineLen)
+        {
+            corpus.text += words[dist(gen)];
+            corpus.text += ' ';
+        }
+
+        if (i % 1000 == 999)
+        {
+            corpus.text += pattern;
+        }
+
+        lineLens.push_back(corpus.text.size() - start);
+        corpus.text += '\n';
+    }
+
+    size_t offset = 0;
+
+    for (const auto len : lineLens)
+    {
+        corpus.lines.push_back(std::string_view(corpus.text).substr(offset, len));
+        offset += len + 1;
+    }
+
+    return corpus;
+}
+
+template <typename Check>
+static void run(const char* name, const Corpus& corpus, const Check& check)
+{
+    double best = 0;
+    size_t matches = 0;
+
+    for (int repeat = 0; repeat < REPEATS; ++repeat)
+    {
+        matches = 0;
+
+        const auto start = Clock::now();
+
+        for (const auto& line : corpus.lines)
+        {
+            matches += check(line);
+        }
+
+        const auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        const auto throughput = corpus.text.size() / seconds / (1024 * 1024);
+
+        best = throughput > best ? throughput : best;
+    }
+
+    std::printf("%-12s %-26s %10.0f MiB/s  (%zu matches)\n", corpus.name, name, best, matches);
+}
+
+int main()
+{
+    const std::string pattern = "connection refused";
+    const LiteralSearch literal(pattern);
+    const LiteralSearch literalIgnoringCase(pattern, true);
+
+    const auto tolowerSearch =
+        [&](std::string_view line)
+        {
+            return std::search(
+                line.begin(), line.end(),
+                pattern.begin(), pattern.end(),
+                [](char c1, char c2)
+                {
+                    return std::tolower(c1) == std::tolower(c2);
+                }) != line.end();
+        };
+
+    // Throughput of automaton shouldn't depend on the number of patterns
+    std::vector<std::string> manyPatterns{pattern};
+
+    for (int i = 0; i < 299; ++i)
+    {
+        manyPatterns.push_back("unknown host " + std::to_string(i));
+    }
+
+    const AhoCorasick automaton(std::span<const std::string>(&pattern, 1), false);
+    const AhoCorasick manyAutomaton(manyPatterns, false);
+
+    std::printf("literal search kernel: %s\n", literalSearchName());
+
+    for (const auto& corpus : {makeCorpus("short lines", 80, pattern), makeCorpus("long lines", 4096, pattern)})
+    {
+        run("string_view::contains", corpus, [&](std::string_view line){ return line.contains(pattern); });
+        run("LiteralSearch::contains", corpus, [&](std::string_view line){ return literal.contains(line); });
+        run("string_view::rfind", corpus, [&](std::string_view line){ return line.rfind(pattern) != line.npos; });
+        run("LiteralSearch::rfind", corpus, [&](std::string_view line){ return literal.rfind(line) != literal.npos; });
+        run("std::search + tolower", corpus, tolowerSearch);
+        run("LiteralSearch ignore case", corpus, [&](std::string_view line){ return literalIgnoringCase.contains(line); });
+        run("AhoCorasick, 1 pattern", corpus, [&](std::string_view line){ return automaton.contains(line); });
+        run("AhoCorasick, 300 patterns", corpus, [&](std::string_view line){ return manyAutomaton.contains(line); });
+    }
+
+    return 0;
+}
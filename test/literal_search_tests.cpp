@@ -0,0 +1,160 @@
+#include <random>
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+#include "core/literal_search.hpp"
+
+using namespace core;
+
+TEST(LiteralSearchTests, findsInShortText)
+{
+    LiteralSearch search("abc");
+
+    ASSERT_EQ(search.find(""), LiteralSearch::npos);
+    ASSERT_EQ(search.find("ab"), LiteralSearch::npos);
+    ASSERT_EQ(search.find("abc"), 0);
+    ASSERT_EQ(search.find("xxabcxabc"), 2);
+    ASSERT_EQ(search.find("xxabcxabc", 3), 6);
+    ASSERT_EQ(search.find("xxabcxabc", 7), LiteralSearch::npos);
+    ASSERT_EQ(search.find("abc", 4), LiteralSearch::npos);
+    ASSERT_EQ(search.rfind("xxabcxabc"), 6);
+    ASSERT_EQ(search.rfind("xxabcxabc", 5), 2);
+    ASSERT_EQ(search.rfind("xxabcxabc", 1), LiteralSearch::npos);
+    ASSERT_TRUE(search.contains("xabcx"));
+    ASSERT_FALSE(search.contains("xabx"));
+}
+
+TEST(LiteralSearchTests, handlesShortPatterns)
+{
+    LiteralSearch empty("");
+    LiteralSearch single("b");
+
+    ASSERT_EQ(empty.find("abc"), 0);
+    ASSERT_EQ(empty.find("abc", 3), 3);
+    ASSERT_EQ(empty.rfind("abc"), 3);
+    ASSERT_EQ(empty.rfind("abc", 1), 1);
+    ASSERT_EQ(single.find("abcb"), 1);
+    ASSERT_EQ(single.find("abcb", 2), 3);
+    ASSERT_EQ(single.rfind("abcb"), 3);
+    ASSERT_EQ(single.rfind("abcb", 2), 1);
+    ASSERT_EQ(single.find("xyz"), LiteralSearch::npos);
+}
+
+TEST(LiteralSearchTests, findsAcrossVectorBoundaries)
+{
+    for (size_t i : {0, 14, 15, 16, 30, 31, 32, 63, 64, 100})
+    {
+        std::string text(120, 'x');
+        text.replace(i, 5, "error");
+
+        LiteralSearch search("error");
+
+        ASSERT_EQ(search.find(text), i);
+        ASSERT_EQ(search.rfind(text), i);
+    }
+}
+
+TEST(LiteralSearchTests, matchesStringViewForAllLengthsAndPositions)
+{
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int> dist(0, 2);
+
+    // Small alphabet, so that there are many candidates which fail verification
+    std::string text(300, 'a');
+
+    for (auto& c : text)
+    {
+        c = 'a' + dist(gen);
+    }
+
+    for (const auto pattern : {"ab", "aa", "aab", "abca", "baab", "cabbac", "aaaaaaaaaaaaaaaaab"})
+    {
+        LiteralSearch search(pattern);
+
+        for (size_t len = 0; len < text.size(); len += 7)
+        {
+            const auto sv = std::string_view(text).substr(0, len);
+
+            for (size_t pos = 0; pos <= len + 1; ++pos)
+            {
+                ASSERT_EQ(search.find(sv, pos), sv.find(pattern, pos)) << pattern << " len: " << len << " pos: " << pos;
+                ASSERT_EQ(search.rfind(sv, pos), sv.rfind(pattern, pos)) << pattern << " len: " << len << " pos: " << pos;
+            }
+
+            ASSERT_EQ(search.rfind(sv), sv.rfind(pattern));
+        }
+    }
+}
+
+static std::string toLower(std::string_view sv)
+{
+    std::string result(sv);
+    for (auto& c : result)
+    {
+        c = c >= 'A' and c <= 'Z' ? c + ('a' - 'A') : c;
+    }
+    return result;
+}
+
+TEST(LiteralSearchTests, findsIgnoringCase)
+{
+    LiteralSearch search("ErRoR", true);
+    LiteralSearch single("x", true);
+
+    ASSERT_EQ(search.find("an error"), 3);
+    ASSERT_EQ(search.find("an ERROR"), 3);
+    ASSERT_EQ(search.find("an eRrOr and Error"), 3);
+    ASSERT_EQ(search.rfind("an eRrOr and Error"), 13);
+    ASSERT_EQ(search.find("an errxr"), LiteralSearch::npos);
+    ASSERT_EQ(single.find("abXc"), 2);
+    ASSERT_EQ(single.rfind("xabXc"), 3);
+
+    // Only ASCII letters are folded; '@' and '`' differ from letters by 0x20
+    ASSERT_EQ(LiteralSearch("a@", true).find("A`"), LiteralSearch::npos);
+    ASSERT_EQ(LiteralSearch("`a", true).find("@A"), LiteralSearch::npos);
+    ASSERT_EQ(LiteralSearch("[z", true).find("{Z"), LiteralSearch::npos);
+}
+
+TEST(LiteralSearchTests, comparesNonAsciiBytesExactly)
+{
+    LiteralSearch search("\xc3\x84pfel", true); // Äpfel
+
+    ASSERT_EQ(search.find("viele \xc3\x84PFEL"), 6);
+    ASSERT_EQ(search.find("viele \xc3\xa4pfel"), LiteralSearch::npos); // äpfel
+}
+
+TEST(LiteralSearchTests, matchesLoweredStringViewForAllLengthsAndPositions)
+{
+    std::mt19937 gen(4321);
+    std::uniform_int_distribution<int> dist(0, 5);
+
+    std::string text(300, 'a');
+
+    for (auto& c : text)
+    {
+        const auto r = dist(gen);
+        c = r < 3 ? 'a' + r : 'A' + r - 3;
+    }
+
+    const auto lowered = toLower(text);
+
+    for (const auto pattern : {"Ab", "aA", "aAB", "AbCa", "bAAb", "cABbac", "aaaaaaaaaaaaaaaaAB"})
+    {
+        LiteralSearch search(pattern, true);
+        const auto loweredPattern = toLower(pattern);
+
+        for (size_t len = 0; len < text.size(); len += 7)
+        {
+            const auto sv = std::string_view(text).substr(0, len);
+            const auto expected = std::string_view(lowered).substr(0, len);
+
+            for (size_t pos = 0; pos <= len + 1; ++pos)
+            {
+                ASSERT_EQ(search.find(sv, pos), expected.find(loweredPattern, pos)) << pattern << " len: " << len << " pos: " << pos;
+                ASSERT_EQ(search.rfind(sv, pos), expected.rfind(loweredPattern, pos)) << pattern << " len: " << len << " pos: " << pos;
+            }
+        }
+    }
+}
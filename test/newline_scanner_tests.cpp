@@ -0,0 +1,89 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "core/newline_scanner.hpp"
+
+using namespace core;
+
+static std::vector<uint32_t> scan(const std::string& text, size_t offset = 0)
+{
+    std::vector<uint32_t> positions(text.size() - offset);
+    positions.resize(findNewlines(text.data() + offset, text.size() - offset, positions.data()));
+    return positions;
+}
+
+static std::vector<uint32_t> naiveScan(const std::string& text, size_t offset = 0)
+{
+    std::vector<uint32_t> positions;
+    for (size_t i = offset; i < text.size(); ++i)
+    {
+        if (text[i] == '\n')
+        {
+            positions.push_back(i - offset);
+        }
+    }
+    return positions;
+}
+
+TEST(NewlineScannerTests, emptyInput)
+{
+    uint32_t position;
+    ASSERT_EQ(findNewlines("", 0, &position), 0);
+}
+
+TEST(NewlineScannerTests, findsNewlinesInShortInput)
+{
+    ASSERT_THAT(scan("\n"), testing::ElementsAre(0));
+    ASSERT_THAT(scan("abc"), testing::ElementsAre());
+    ASSERT_THAT(scan("a\nb\n\nc"), testing::ElementsAre(1, 3, 4));
+}
+
+TEST(NewlineScannerTests, findsNewlinesAcrossVectorBoundaries)
+{
+    std::string text(200, 'x');
+
+    for (size_t i : {0, 15, 16, 31, 32, 63, 64, 65, 127, 128, 199})
+    {
+        text[i] = '\n';
+    }
+
+    ASSERT_EQ(scan(text), naiveScan(text));
+}
+
+TEST(NewlineScannerTests, matchesNaiveScanForAllLengthsAndAlignments)
+{
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int> dist(0, 7);
+
+    std::string text(4096 + 64, 'a');
+
+    for (auto& c : text)
+    {
+        c = dist(gen) == 0 ? '\n' : 'a' + dist(gen);
+    }
+
+    for (size_t offset = 0; offset < 64; ++offset)
+    {
+        for (size_t len = offset; len < 300; ++len)
+        {
+            const auto sub = text.substr(0, len);
+            ASSERT_EQ(scan(sub, offset), naiveScan(sub, offset)) << "offset: " << offset << " len: " << len;
+        }
+    }
+
+    ASSERT_EQ(scan(text), naiveScan(text));
+}
+
+TEST(NewlineScannerTests, allNewlines)
+{
+    const std::string text(NEWLINE_SCAN_WINDOW, '\n');
+    const auto positions = scan(text);
+
+    ASSERT_EQ(positions.size(), text.size());
+    ASSERT_EQ(positions.back(), text.size() - 1);
+}
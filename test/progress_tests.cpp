@@ -0,0 +1,118 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/progress.hpp"
+
+using namespace core;
+
+TEST(ProgressTests, sumsCountersOfAllThreads)
+{
+    Progress progress;
+
+    progress.start(4);
+    progress.setTotal(400);
+
+    ASSERT_TRUE(progress.running());
+    ASSERT_EQ(progress.eta(), -1);
+
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        threads.emplace_back(
+            [i, &progress]
+            {
+                for (size_t j = 0; j < 100; ++j)
+                {
+                    progress.counter(i).add(1, 10);
+                }
+                progress.finish(i);
+            });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    progress.stop();
+
+    ASSERT_FALSE(progress.running());
+    ASSERT_EQ(progress.total(), 400);
+    ASSERT_EQ(progress.units(), 400);
+    ASSERT_EQ(progress.bytes(), 4000);
+    ASSERT_EQ(progress.eta(), 0);
+
+    const auto summary = progress.summary();
+
+    ASSERT_EQ(summary.size(), 4);
+
+    for (const auto& thread : summary)
+    {
+        ASSERT_EQ(thread.units, 100);
+        ASSERT_EQ(thread.bytes, 1000);
+        ASSERT_LE(thread.time, progress.elapsed());
+    }
+}
+
+TEST(ProgressTests, skipsIdleThreadsInSummary)
+{
+    Progress progress;
+
+    progress.start(3);
+    progress.setTotal(10);
+
+    progress.counter(1).add(4, 40);
+    progress.finish(1);
+
+    ASSERT_GT(progress.eta(), 0);
+
+    progress.stop();
+
+    const auto summary = progress.summary();
+
+    ASSERT_EQ(summary.size(), 1);
+    ASSERT_EQ(summary[0].units, 4);
+    ASSERT_EQ(summary[0].bytes, 40);
+}
+
+TEST(ProgressTests, isResetOnStart)
+{
+    Progress progress;
+
+    progress.start(1);
+    progress.setTotal(5);
+    progress.counter(0).add(5, 5);
+    progress.stop();
+
+    progress.start(2);
+
+    ASSERT_EQ(progress.total(), 0);
+    ASSERT_EQ(progress.units(), 0);
+    ASSERT_TRUE(progress.summary().empty());
+}
+
+TEST(ProgressTests, countsBusyTimeFromBegin)
+{
+    Progress progress;
+
+    progress.start(2);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    progress.begin(1);
+    progress.counter(0).add(1, 1);
+    progress.counter(1).add(1, 1);
+    progress.finish(0);
+    progress.finish(1);
+    progress.stop();
+
+    const auto summary = progress.summary();
+
+    ASSERT_EQ(summary.size(), 2);
+    ASSERT_GE(summary[0].time, 0.05f);
+    ASSERT_LT(summary[1].time, summary[0].time);
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+#include "utils/roaring_bitmap.hpp"
+
+using namespace utils;
+
+static RoaringBitmap makeBitmap(const std::set<uint64_t>& values)
+{
+    RoaringBitmap bitmap;
+    for (const auto value : values)
+    {
+        bitmap.append(value);
+    }
+    return bitmap;
+}
+
+static std::set<uint64_t> toSet(const RoaringBitmap& bitmap)
+{
+    std::set<uint64_t> values;
+    uint64_t previous = 0;
+    bool first = true;
+
+    bitmap.forEach(
+        [&](uint64_t value)
+        {
+            EXPECT_TRUE(first or value > previous);
+            first = false;
+            previous = value;
+            values.insert(value);
+        });
+
+    EXPECT_EQ(values.size(), bitmap.size());
+
+    return values;
+}
+
+// Mixes sparse containers, dense ones and ones close to ARRAY_MAX, so that
+// operations have to convert containers both ways
+static std::set<uint64_t> makeValues(unsigned seed)
+{
+    std::mt19937_64 random(seed);
+    std::set<uint64_t> values;
+
+    for (uint64_t key = 0; key < 8; ++key)
+    {
+        const auto base = key << 16;
+
+        switch (random() % 4)
+        {
+            case 0:
+                for (size_t i = 0; i < 100; ++i)
+                {
+                    values.insert(base + random() % 65536);
+                }
+                break;
+            case 1:
+                for (uint64_t i = 0; i < 30000; ++i)
+                {
+                    values.insert(base + random() % 32768);
+                }
+                break;
+            case 2:
+                for (uint64_t i = 0; i < RoaringBitmap::ARRAY_MAX * 2 + 1; i += 2)
+                {
+                    values.insert(base + i);
+                }
+                break;
+        }
+    }
+
+    return values;
+}
+
+TEST(RoaringBitmapTests, keepsAppendedValues)
+{
+    const std::set<uint64_t> values{0, 1, 65535, 65536, 1ull << 40, (1ull << 40) + 7};
+
+    const auto bitmap = makeBitmap(values);
+
+    ASSERT_EQ(bitmap.size(), values.size());
+    ASSERT_EQ(bitmap.containerCount(), 3);
+    ASSERT_EQ(toSet(bitmap), values);
+
+    for (const auto value : values)
+    {
+        ASSERT_TRUE(bitmap.contains(value));
+    }
+
+    ASSERT_FALSE(bitmap.contains(2));
+    ASSERT_FALSE(bitmap.contains(1ull << 30));
+    ASSERT_FALSE(RoaringBitmap().contains(0));
+}
+
+TEST(RoaringBitmapTests, convertsDenseContainers)
+{
+    std::set<uint64_t> values;
+    for (uint64_t i = 0; i < 65536; ++i)
+    {
+        values.insert(i);
+    }
+
+    const auto bitmap = makeBitmap(values);
+
+    ASSERT_EQ(bitmap.size(), 65536);
+    ASSERT_LE(bitmap.memoryUsage(), 9000);
+    ASSERT_EQ(toSet(bitmap), values);
+}
+
+TEST(RoaringBitmapTests, appendsBitmaps)
+{
+    for (unsigned seed = 0; seed < 5; ++seed)
+    {
+        const auto values = makeValues(seed);
+
+        RoaringBitmap bitmap;
+        std::set<uint64_t> part;
+
+        // Parts split inside containers, so that boundary ones are merged
+        for (const auto value : values)
+        {
+            part.insert(value);
+
+            if (part.size() == 3000)
+            {
+                bitmap.append(makeBitmap(std::exchange(part, {})));
+            }
+        }
+
+        bitmap.append(makeBitmap(part));
+        bitmap.append(RoaringBitmap());
+
+        ASSERT_EQ(bitmap.size(), values.size());
+        ASSERT_EQ(bitmap.containerCount(), makeBitmap(values).containerCount());
+        ASSERT_EQ(toSet(bitmap), values);
+    }
+}
+
+TEST(RoaringBitmapTests, computesSetOperations)
+{
+    for (unsigned seed = 0; seed < 5; ++seed)
+    {
+        const auto a = makeValues(seed);
+        const auto b = makeValues(seed + 100);
+
+        std::set<uint64_t> intersection, sum, difference;
+
+        std::ranges::set_intersection(a, b, std::inserter(intersection, intersection.end()));
+        std::ranges::set_union(a, b, std::inserter(sum, sum.end()));
+        std::ranges::set_difference(a, b, std::inserter(difference, difference.end()));
+
+        const auto lhs = makeBitmap(a);
+        const auto rhs = makeBitmap(b);
+
+        ASSERT_EQ(toSet(lhs & rhs), intersection);
+        ASSERT_EQ(toSet(lhs | rhs), sum);
+        ASSERT_EQ(toSet(lhs - rhs), difference);
+        ASSERT_EQ(toSet(lhs - lhs), std::set<uint64_t>());
+        ASSERT_EQ((lhs - lhs).containerCount(), 0);
+    }
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "utils/segmented_array.hpp"
+
+using namespace utils;
+
+static SegmentedArray<size_t> sequence(size_t first, size_t count)
+{
+    SegmentedArray<size_t> array;
+    for (size_t i = 0; i < count; ++i)
+    {
+        array.pushBack(first + i);
+    }
+    return array;
+}
+
+TEST(SegmentedArrayTests, canPushBack)
+{
+    auto array = sequence(0, SegmentMap::PAGE_SIZE * 3 + 5);
+
+    ASSERT_EQ(array.size(), SegmentMap::PAGE_SIZE * 3 + 5);
+    ASSERT_EQ(array.segmentCount(), 1);
+
+    for (size_t i = 0; i < array.size(); ++i)
+    {
+        ASSERT_EQ(array[i], i);
+    }
+}
+
+TEST(SegmentedArrayTests, joinsLargeArraysWithoutCopying)
+{
+    const size_t sizes[] = {10, SegmentMap::PAGE_SIZE + 1, 3, SegmentMap::PAGE_SIZE * 2, 0, 7};
+
+    SegmentedArray<size_t> array;
+    size_t total = 0;
+
+    for (auto size : sizes)
+    {
+        auto other = sequence(total, size);
+        array.append(std::move(other));
+        total += size;
+
+        ASSERT_TRUE(other.empty());
+        ASSERT_EQ(array.size(), total);
+    }
+
+    // Small arrays are copied into the preceding segment
+    ASSERT_EQ(array.segmentCount(), 3);
+    ASSERT_EQ(array.back(), total - 1);
+
+    for (size_t i = 0; i < total; ++i)
+    {
+        ASSERT_EQ(array[i], i) << "index: " << i;
+    }
+}
+
+TEST(SegmentedArrayTests, canLocateElementsInShortSegments)
+{
+    SegmentMap map;
+
+    map.addSegment();
+    map.grow(5);
+    map.addSegment();
+    map.addSegment();
+    map.grow(SegmentMap::PAGE_SIZE);
+    map.addSegment();
+    map.grow(1);
+
+    ASSERT_EQ(map.size(), SegmentMap::PAGE_SIZE + 6);
+    ASSERT_EQ(map.locate(4).segment, 0);
+    ASSERT_EQ(map.locate(5).segment, 2);
+    ASSERT_EQ(map.locate(5).offset, 0);
+    ASSERT_EQ(map.locate(SegmentMap::PAGE_SIZE + 4).segment, 2);
+    ASSERT_EQ(map.locate(SegmentMap::PAGE_SIZE + 5).segment, 3);
+    ASSERT_EQ(map.locate(SegmentMap::PAGE_SIZE + 5).offset, 0);
+
+    map.shrink(1);
+    map.removeSegment();
+    map.shrink(SegmentMap::PAGE_SIZE);
+
+    ASSERT_EQ(map.size(), 5);
+    ASSERT_EQ(map.locate(4).offset, 4);
+}
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/thread.hpp"
+
+using namespace core;
+
+using namespace std::chrono_literals;
+
+template <typename Predicate>
+static bool waitFor(const Predicate& predicate)
+{
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+
+    while (not predicate())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+
+    return true;
+}
+
+TEST(ThreadTests, runsAllTasks)
+{
+    constexpr size_t count = 100;
+
+    std::vector<std::atomic_int> runs(count);
+    Tasks tasks;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        tasks.emplace_back([&runs, i]{ runs[i]++; });
+    }
+
+    executeInParallelAndWait(std::move(tasks));
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(runs[i], 1) << "task " << i;
+    }
+}
+
+TEST(ThreadTests, runsNestedTasksOnPoolThreads)
+{
+    const auto workers = threadPoolStats().workers;
+    const auto outerCount = 2 * workers + 1;
+    constexpr size_t innerCount = 8;
+
+    std::atomic_size_t runs(0);
+    std::atomic_size_t running(0);
+    std::atomic_size_t maxRunning(0);
+    std::mutex lock;
+    std::set<std::thread::id> threads;
+
+    const auto innerTask =
+        [&]
+        {
+            const auto current = ++running;
+
+            for (auto max = maxRunning.load(); current > max;)
+            {
+                if (maxRunning.compare_exchange_weak(max, current))
+                {
+                    break;
+                }
+            }
+
+            {
+                std::lock_guard guard(lock);
+                threads.insert(std::this_thread::get_id());
+            }
+
+            std::this_thread::sleep_for(100us);
+            ++runs;
+            --running;
+        };
+
+    Tasks tasks;
+
+    for (size_t i = 0; i < outerCount; ++i)
+    {
+        tasks.emplace_back(
+            [&innerTask]
+            {
+                // Waiting inside a pool task mustn't need a free worker
+                executeInParallelAndWait(Tasks(innerCount, innerTask));
+            });
+    }
+
+    executeInParallelAndWait(std::move(tasks));
+
+    ASSERT_EQ(runs, outerCount * innerCount);
+
+    // Tasks run only on workers and on the calling thread, never on threads
+    // created for waiting
+    ASSERT_LE(maxRunning, workers + 1);
+    ASSERT_LE(threads.size(), workers + 1);
+}
+
+TEST(ThreadTests, countsTasksInStats)
+{
+    constexpr size_t count = 32;
+
+    const auto before = threadPoolStats();
+
+    Tasks tasks(count, []{ std::this_thread::sleep_for(100us); });
+
+    executeInParallelAndWait(std::move(tasks));
+
+    const auto after = threadPoolStats();
+
+    ASSERT_EQ(after.workers, std::max(hardwareThreadCount(), 1u));
+
+    // The first task is run by the calling thread without going through
+    // the pool
+    ASSERT_GE(after.tasks - before.tasks, count - 1);
+    ASSERT_GE(after.maxQueued, 1);
+    ASSERT_GE(after.averageLatency, 0);
+    ASSERT_GE(after.maxLatency, after.averageLatency);
+}
+
+TEST(ThreadTests, runsAsyncTaskOnNewThreadIfNoWorkerIsIdle)
+{
+    const auto workers = threadPoolStats().workers;
+
+    std::atomic_bool release(false);
+    std::atomic_size_t started(0);
+
+    // Calling thread runs one of the tasks, and each worker the others
+    std::thread blocker(
+        [&]
+        {
+            executeInParallelAndWait(Tasks(
+                workers + 1,
+                [&]
+                {
+                    ++started;
+                    while (not release)
+                    {
+                        std::this_thread::sleep_for(1ms);
+                    }
+                }));
+        });
+
+    const bool allStarted = waitFor([&]{ return started == workers + 1; });
+
+    std::atomic_bool done(false);
+
+    if (allStarted)
+    {
+        async([&done]{ done = true; });
+    }
+
+    const bool asyncDone = allStarted and waitFor([&done]{ return done.load(); });
+
+    release = true;
+    blocker.join();
+
+    ASSERT_TRUE(allStarted);
+    ASSERT_TRUE(asyncDone);
+}
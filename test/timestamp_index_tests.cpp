@@ -0,0 +1,217 @@
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/timestamp_index.hpp"
+
+using namespace core;
+
+constexpr static Timestamp SECOND = 1'000'000;
+
+// 2024-01-15T10:23:45Z
+constexpr static Timestamp REFERENCE = 1705314225 * SECOND;
+
+// Expected column: lines without timestamp take the preceding one
+static std::vector<Timestamp> carried(const std::vector<Timestamp>& timestamps)
+{
+    std::vector<Timestamp> result;
+    auto last = NO_TIMESTAMP;
+
+    for (auto timestamp : timestamps)
+    {
+        last = timestamp == NO_TIMESTAMP ? last : timestamp;
+        result.push_back(last);
+    }
+
+    return result;
+}
+
+static std::vector<Timestamp> generate(size_t count, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<Timestamp> step(0, 2 * SECOND);
+    std::uniform_int_distribution<int> kind(0, 99);
+
+    std::vector<Timestamp> timestamps;
+    auto current = REFERENCE;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto k = kind(gen);
+
+        // Some stack traces, and some gaps of hours
+        current += k == 0 ? 3600 * SECOND : step(gen);
+        timestamps.push_back(k < 10 ? NO_TIMESTAMP : current);
+    }
+
+    return timestamps;
+}
+
+TEST(TimestampIndexTests, carriesTimestampToLinesWithoutIt)
+{
+    TimestampIndex index;
+
+    for (auto timestamp : {NO_TIMESTAMP, NO_TIMESTAMP, REFERENCE, NO_TIMESTAMP, REFERENCE + SECOND})
+    {
+        index.append(timestamp);
+    }
+
+    ASSERT_EQ(index.size(), 5);
+    ASSERT_EQ(index[0], NO_TIMESTAMP);
+    ASSERT_EQ(index[1], NO_TIMESTAMP);
+    ASSERT_EQ(index[2], REFERENCE);
+    ASSERT_EQ(index[3], REFERENCE);
+    ASSERT_EQ(index[4], REFERENCE + SECOND);
+}
+
+TEST(TimestampIndexTests, fallsBackToWideValuesForGaps)
+{
+    const auto timestamps = generate(1000, 1234);
+    const auto expected = carried(timestamps);
+
+    TimestampIndex index;
+
+    for (auto timestamp : timestamps)
+    {
+        index.append(timestamp);
+    }
+
+    ASSERT_EQ(index.size(), expected.size());
+
+    for (size_t i = 0; i < index.size(); ++i)
+    {
+        ASSERT_EQ(index[i], expected[i]) << "line: " << i;
+    }
+}
+
+TEST(TimestampIndexTests, resolvesLeadingLinesOfAppendedIndex)
+{
+    constexpr size_t count = TimestampIndex::MIN_SEGMENT_LINES * 2 + 100;
+
+    for (const auto split : {size_t(100), count})
+    {
+        auto timestamps = generate(count * 2, 42);
+
+        // Second part starts with a long stack trace
+        for (size_t i = split; i < split + 200; ++i)
+        {
+            timestamps[i] = NO_TIMESTAMP;
+        }
+
+        const auto expected = carried(timestamps);
+
+        TimestampIndex first, second;
+
+        for (size_t i = 0; i < timestamps.size(); ++i)
+        {
+            (i < split ? first : second).append(timestamps[i]);
+        }
+
+        first.append(std::move(second));
+
+        ASSERT_EQ(first.size(), expected.size());
+        ASSERT_TRUE(second.empty());
+
+        for (size_t i = 0; i < first.size(); ++i)
+        {
+            ASSERT_EQ(first[i], expected[i]) << "split: " << split << "; line: " << i;
+        }
+    }
+}
+
+TEST(TimestampIndexTests, keepsLinesBeforeFirstTimestamp)
+{
+    constexpr size_t count = TimestampIndex::MIN_SEGMENT_LINES + 10;
+
+    TimestampIndex first, second, third;
+
+    first.append(NO_TIMESTAMP);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        second.append(NO_TIMESTAMP);
+    }
+
+    third.append(NO_TIMESTAMP);
+    third.append(REFERENCE);
+
+    first.append(std::move(second));
+    first.append(std::move(third));
+    first.append(NO_TIMESTAMP);
+
+    ASSERT_EQ(first.size(), count + 4);
+    ASSERT_EQ(first[count + 1], NO_TIMESTAMP);
+    ASSERT_EQ(first[count + 2], REFERENCE);
+    ASSERT_EQ(first[count + 3], REFERENCE);
+    ASSERT_EQ(first.lowerBound(REFERENCE), count + 2);
+}
+
+TEST(TimestampIndexTests, chunkBuiltAfterMoveContinuesPreviousOne)
+{
+    TimestampIndex built, joined;
+
+    built.append(REFERENCE);
+    built.append(NO_TIMESTAMP);
+    joined.append(std::move(built));
+
+    ASSERT_TRUE(built.empty());
+
+    built.append(NO_TIMESTAMP);
+    built.append(REFERENCE + SECOND);
+    joined.append(std::move(built));
+
+    ASSERT_EQ(joined.size(), 4);
+    ASSERT_EQ(joined[2], REFERENCE);
+    ASSERT_EQ(joined[3], REFERENCE + SECOND);
+}
+
+TEST(TimestampIndexTests, findsLowerBound)
+{
+    const auto expected = carried(generate(5000, 7));
+
+    TimestampIndex index;
+
+    for (auto timestamp : expected)
+    {
+        index.append(timestamp);
+    }
+
+    for (size_t i = 0; i < expected.size(); i += 37)
+    {
+        const auto bound = index.lowerBound(expected[i]);
+        ASSERT_LE(bound, i);
+        ASSERT_EQ(index[bound], expected[i]);
+        ASSERT_TRUE(bound == 0 or index[bound - 1] < expected[i]);
+    }
+
+    ASSERT_EQ(index.lowerBound(NO_TIMESTAMP), 0);
+    ASSERT_EQ(index.lowerBound(expected.back() + 1), expected.size());
+}
+
+TEST(TimestampIndexTests, canPopBack)
+{
+    TimestampIndex index;
+
+    index.append(REFERENCE);
+    index.append(REFERENCE + 2 * 3600 * SECOND);
+    index.popBack();
+    index.append(NO_TIMESTAMP);
+
+    ASSERT_EQ(index.size(), 2);
+    ASSERT_EQ(index[1], REFERENCE);
+}
+
+TEST(TimestampIndexTests, usesLessMemoryThanPlainTimestamps)
+{
+    TimestampIndex index;
+
+    for (size_t i = 0; i < 100000; ++i)
+    {
+        index.append(REFERENCE + Timestamp(i) * 1000);
+    }
+
+    index.shrinkToFit();
+
+    ASSERT_LT(index.memoryUsage(), 100000 * 5);
+}
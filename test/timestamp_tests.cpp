@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include "core/timestamp.hpp"
+
+using namespace core;
+
+constexpr static Timestamp SECOND = 1'000'000;
+
+// 2024-01-15T10:23:45Z
+constexpr static Timestamp REFERENCE = 1705314225 * SECOND;
+
+TEST(TimestampTests, parsesIsoFormats)
+{
+    EXPECT_EQ(*parseTimestamp("2024-01-15T10:23:45 message"), REFERENCE);
+    EXPECT_EQ(*parseTimestamp("2024-01-15 10:23:45 message"), REFERENCE);
+    EXPECT_EQ(*parseTimestamp("2024/01/15 10:23:45"), REFERENCE);
+    EXPECT_EQ(*parseTimestamp("2024-01-15T10:23:45Z"), REFERENCE);
+    EXPECT_EQ(*parseTimestamp("1970-01-01T00:00:00"), 0);
+    EXPECT_EQ(*parseTimestamp("2000-03-01T00:00:00"), 951868800 * SECOND);
+}
+
+TEST(TimestampTests, parsesFraction)
+{
+    EXPECT_EQ(*parseTimestamp("2024-01-15T10:23:45.5"), REFERENCE + SECOND / 2);
+    EXPECT_EQ(*parseTimestamp("2024-01-15 10:23:45,123"), REFERENCE + 123'000);
+    EXPECT_EQ(*parseTimestamp("2024-01-15T10:23:45.123456789Z"), REFERENCE + 123'456);
+}
+
+TEST(TimestampTests, appliesZoneOffset)
+{
+    EXPECT_EQ(*parseTimestamp("2024-01-15T12:23:45+02:00"), REFERENCE);
+    EXPECT_EQ(*parseTimestamp("2024-01-15T12:23:45+0200"), REFERENCE);
+    EXPECT_EQ(*parseTimestamp("2024-01-15T08:23:45-02"), REFERENCE);
+    EXPECT_EQ(*parseTimestamp("2024-01-15T10:23:45.5+00:00"), REFERENCE + SECOND / 2);
+}
+
+TEST(TimestampTests, skipsPrefix)
+{
+    EXPECT_EQ(*parseTimestamp("[2024-01-15 10:23:45] message"), REFERENCE);
+    EXPECT_EQ(*parseTimestamp("  2024-01-15 10:23:45"), REFERENCE);
+    EXPECT_FALSE(parseTimestamp("INFO 2024-01-15 10:23:45"));
+}
+
+TEST(TimestampTests, parsesSyslogFormat)
+{
+    const auto jan15 = *parseTimestamp("Jan 15 10:23:45 host daemon[1]: message");
+
+    EXPECT_EQ(jan15, (14 * 86400 + 10 * 3600 + 23 * 60 + 45) * SECOND);
+    EXPECT_EQ(*parseTimestamp("Jan  5 10:23:45 host"), jan15 - 10 * 86400 * SECOND);
+    EXPECT_EQ(*parseTimestamp("Feb  1 00:00:00.25"), 31 * 86400 * SECOND + SECOND / 4);
+    EXPECT_LT(*parseTimestamp("Nov 30 23:59:59"), *parseTimestamp("Dec  1 00:00:00"));
+}
+
+TEST(TimestampTests, rejectsInvalidTimestamps)
+{
+    EXPECT_FALSE(parseTimestamp(""));
+    EXPECT_FALSE(parseTimestamp("message"));
+    EXPECT_FALSE(parseTimestamp("    at com.example.Main.run(Main.java:10)"));
+    EXPECT_FALSE(parseTimestamp("2024-01-15"));
+    EXPECT_FALSE(parseTimestamp("2024-13-15 10:23:45"));
+    EXPECT_FALSE(parseTimestamp("2024-01-15 24:00:00"));
+    EXPECT_FALSE(parseTimestamp("2024-01-15 10:23"));
+    EXPECT_FALSE(parseTimestamp("2024-01-15X10:23:45"));
+    EXPECT_FALSE(parseTimestamp("Foo 15 10:23:45"));
+    EXPECT_FALSE(parseTimestamp("Jan 1510:23:45"));
+    EXPECT_FALSE(parseTimestamp("12345"));
+}
+
+TEST(TimestampTests, parsesGivenFormat)
+{
+    EXPECT_EQ(*parseTimestamp("2024-01-15T10:23:45 message", TimestampFormat::iso), REFERENCE);
+    EXPECT_FALSE(parseTimestamp("2024-01-15T10:23:45 message", TimestampFormat::syslog));
+    EXPECT_FALSE(parseTimestamp("Jan 15 10:23:45 host", TimestampFormat::iso));
+    EXPECT_EQ(*parseTimestamp("Jan 15 10:23:45 host", TimestampFormat::syslog), *parseTimestamp("Jan 15 10:23:45"));
+    EXPECT_FALSE(parseTimestamp("2024-01-15T10:23:45", TimestampFormat::none));
+}
+
+TEST(TimestampTests, parsesEpoch)
+{
+    EXPECT_EQ(*parseTimestamp("1705314225 message", TimestampFormat::epoch), REFERENCE);
+    EXPECT_EQ(*parseTimestamp("[1705314225.25] message", TimestampFormat::epoch), REFERENCE + SECOND / 4);
+    EXPECT_FALSE(parseTimestamp("17053142251 message", TimestampFormat::epoch));
+    EXPECT_FALSE(parseTimestamp("170531422 message", TimestampFormat::epoch));
+    EXPECT_FALSE(parseTimestamp("1705314225 message"));
+}
+
+TEST(TimestampTests, detectsFormat)
+{
+    EXPECT_EQ(detectTimestampFormat("2024-01-15 10:23:45 a\n  trace\n2024-01-15 10:23:46 b\n"), TimestampFormat::iso);
+    EXPECT_EQ(detectTimestampFormat("Jan 15 10:23:45 host a\nJan 15 10:23:46 host b"), TimestampFormat::syslog);
+    EXPECT_EQ(detectTimestampFormat("no\ntimestamps\n"), TimestampFormat::none);
+    EXPECT_EQ(detectTimestampFormat(""), TimestampFormat::none);
+}
+
+TEST(TimestampTests, namesFormats)
+{
+    for (const auto format : {TimestampFormat::none, TimestampFormat::automatic, TimestampFormat::iso, TimestampFormat::syslog, TimestampFormat::epoch})
+    {
+        EXPECT_EQ(*parseTimestampFormat(timestampFormatName(format)), format);
+    }
+
+    EXPECT_FALSE(parseTimestampFormat("rfc"));
+}
+
+TEST(TimestampTests, parsesTimeQuery)
+{
+    constexpr Timestamp MINUTE = 60 * SECOND;
+    const auto syslogReference = *parseTimestamp("Jan 15 10:23:45");
+
+    EXPECT_EQ(*parseTimeQuery("2024-01-15T10:23:45", REFERENCE), REFERENCE);
+    EXPECT_EQ(*parseTimeQuery("2024-01-15 10:23", REFERENCE), REFERENCE - 45 * SECOND);
+    EXPECT_EQ(*parseTimeQuery("2024-01-15", REFERENCE), REFERENCE - (10 * 60 + 23) * MINUTE - 45 * SECOND);
+    EXPECT_EQ(*parseTimeQuery("10:25", REFERENCE), REFERENCE + MINUTE + 15 * SECOND);
+    EXPECT_EQ(*parseTimeQuery("00:00:00", REFERENCE + 5 * SECOND), REFERENCE - (10 * 60 + 23) * MINUTE - 45 * SECOND);
+    EXPECT_EQ(*parseTimeQuery("Jan 15 10:23", syslogReference), syslogReference - 45 * SECOND);
+    EXPECT_EQ(*parseTimeQuery("2026-01-15 10:23:45", syslogReference), syslogReference);
+    EXPECT_FALSE(parseTimeQuery("10", REFERENCE));
+    EXPECT_FALSE(parseTimeQuery("10:23 junk", REFERENCE));
+    EXPECT_FALSE(parseTimeQuery("2024-01-15T", REFERENCE));
+}